@@ -3,19 +3,12 @@ Import("env")
 env.Append(LINKFLAGS=["-Wl,--undefined=_mmcu,--section-start=.mmcu=0x3800"])
 
 def capture_callback(*args, **kwargs):
-    try:
-        import configparser
-    except ImportError:
-        import ConfigParser as configparser
-
-    config = configparser.ConfigParser()
-    config.read("platformio.ini")
-
-    custom_arg = 'custom_capture'
-    sections = config.sections()
-    extra_args = []
-    if config.has_option(sections[0], custom_arg):
-        extra_args = config.get(sections[0], custom_arg).split()
+    # Read through the project config, so environments that extend env:uno
+    # get its traces.
+    capture = env.GetProjectOption("custom_capture", "")
+    if isinstance(capture, list):
+        capture = " ".join(capture)
+    extra_args = capture.split()
 
     cmd_base = [
         "simavr",
@@ -0,0 +1,138 @@
+// Generated by tools/ps_job from images/demo_black.pgm. Do not edit.
+
+#ifndef DEMO_JOB_H
+#define DEMO_JOB_H
+
+#include "printspider_job.h"
+
+// 11 rows of the black cartridge, 9 blank, 28 packets, 1475 bytes.
+static const uint8_t demo_job_data[] PROGMEM = {
+    0x23, 0x15, 0x00, 0x00, 0x08, 0x00, 0x09, 0x02, 0x19, 0x02, 0x14, 0x00,
+    0x04, 0x00, 0x0f, 0x02, 0x2f, 0x02, 0x27, 0x00, 0x07, 0x00, 0x04, 0x02,
+    0x44, 0x02, 0x43, 0x04, 0x03, 0x04, 0x07, 0x06, 0x87, 0x06, 0x87, 0x04,
+    0x07, 0x04, 0x07, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x09, 0xfc, 0x00,
+    0x08, 0xf9, 0x00, 0x00, 0x23, 0x15, 0x00, 0x00, 0x08, 0x00, 0x08, 0x02,
+    0x18, 0x02, 0x10, 0x00, 0x00, 0x00, 0x0f, 0x02, 0x2f, 0x02, 0x27, 0x00,
+    0x07, 0x00, 0x05, 0x02, 0x45, 0x02, 0x43, 0x04, 0x03, 0x04, 0x07, 0x06,
+    0x87, 0x06, 0x87, 0x04, 0x07, 0x04, 0x07, 0x00, 0x00, 0x00, 0x00, 0x01,
+    0x00, 0x09, 0xfc, 0x00, 0x08, 0xf9, 0x00, 0x00, 0x23, 0x15, 0x00, 0x00,
+    0x08, 0x00, 0x08, 0x02, 0x18, 0x02, 0x10, 0x00, 0x00, 0x00, 0x0f, 0x02,
+    0x2f, 0x02, 0x27, 0x00, 0x07, 0x00, 0x03, 0x02, 0x43, 0x02, 0x41, 0x04,
+    0x01, 0x04, 0x07, 0x06, 0x87, 0x06, 0x87, 0x04, 0x07, 0x04, 0x07, 0x00,
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x09, 0xfc, 0x00, 0x08, 0xf9, 0x00, 0x00,
+    0x23, 0x15, 0x00, 0x00, 0x08, 0x00, 0x09, 0x02, 0x19, 0x02, 0x11, 0x00,
+    0x01, 0x00, 0x0f, 0x02, 0x2f, 0x02, 0x27, 0x00, 0x07, 0x00, 0x05, 0x02,
+    0x45, 0x02, 0x43, 0x04, 0x03, 0x04, 0x07, 0x06, 0x87, 0x06, 0x87, 0x04,
+    0x07, 0x04, 0x07, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x09, 0xfc, 0x00,
+    0x08, 0xf9, 0x00, 0x00, 0x23, 0x15, 0x00, 0x00, 0x08, 0x00, 0x08, 0x02,
+    0x18, 0x02, 0x11, 0x00, 0x01, 0x00, 0x0f, 0x02, 0x2f, 0x02, 0x27, 0x00,
+    0x07, 0x00, 0x01, 0x02, 0x41, 0x02, 0x47, 0x04, 0x07, 0x04, 0x07, 0x06,
+    0x87, 0x06, 0x87, 0x04, 0x07, 0x04, 0x07, 0x00, 0x00, 0x00, 0x00, 0x01,
+    0x00, 0x09, 0xfc, 0x00, 0x08, 0xf9, 0x00, 0x00, 0x23, 0x15, 0x00, 0x00,
+    0x08, 0x00, 0x0a, 0x02, 0x1a, 0x02, 0x10, 0x00, 0x00, 0x00, 0x0f, 0x02,
+    0x2f, 0x02, 0x27, 0x00, 0x07, 0x00, 0x07, 0x02, 0x47, 0x02, 0x41, 0x04,
+    0x01, 0x04, 0x07, 0x06, 0x87, 0x06, 0x87, 0x04, 0x07, 0x04, 0x07, 0x00,
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x09, 0xfc, 0x00, 0x08, 0xf9, 0x00, 0x00,
+    0x23, 0x15, 0x00, 0x00, 0x08, 0x00, 0x08, 0x02, 0x18, 0x02, 0x10, 0x00,
+    0x00, 0x00, 0x0f, 0x02, 0x2f, 0x02, 0x27, 0x00, 0x07, 0x00, 0x03, 0x02,
+    0x43, 0x02, 0x45, 0x04, 0x05, 0x04, 0x07, 0x06, 0x87, 0x06, 0x87, 0x04,
+    0x07, 0x04, 0x07, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x09, 0xfc, 0x00,
+    0x08, 0xf9, 0x00, 0x00, 0x23, 0x15, 0x00, 0x00, 0x08, 0x00, 0x08, 0x02,
+    0x18, 0x02, 0x11, 0x00, 0x01, 0x00, 0x0f, 0x02, 0x2f, 0x02, 0x27, 0x00,
+    0x07, 0x00, 0x02, 0x02, 0x42, 0x02, 0x47, 0x04, 0x07, 0x04, 0x07, 0x06,
+    0x87, 0x06, 0x87, 0x04, 0x07, 0x04, 0x07, 0x00, 0x00, 0x00, 0x00, 0x01,
+    0x00, 0x09, 0xfc, 0x00, 0x08, 0xf9, 0x00, 0x00, 0x23, 0x15, 0x00, 0x00,
+    0x08, 0x00, 0x08, 0x02, 0x18, 0x02, 0x11, 0x00, 0x01, 0x00, 0x0f, 0x02,
+    0x2f, 0x02, 0x27, 0x00, 0x07, 0x00, 0x03, 0x02, 0x43, 0x02, 0x47, 0x04,
+    0x07, 0x04, 0x07, 0x06, 0x87, 0x06, 0x87, 0x04, 0x07, 0x04, 0x07, 0x00,
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x09, 0xfc, 0x00, 0x08, 0xf9, 0x00, 0x00,
+    0x23, 0x15, 0x00, 0x00, 0x08, 0x00, 0x08, 0x02, 0x18, 0x02, 0x12, 0x00,
+    0x02, 0x00, 0x0f, 0x02, 0x2f, 0x02, 0x27, 0x00, 0x07, 0x00, 0x03, 0x02,
+    0x43, 0x02, 0x45, 0x04, 0x05, 0x04, 0x07, 0x06, 0x87, 0x06, 0x87, 0x04,
+    0x07, 0x04, 0x07, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x09, 0xfc, 0x00,
+    0x08, 0xf9, 0x00, 0x00, 0x23, 0x15, 0x00, 0x00, 0x08, 0x00, 0x08, 0x02,
+    0x18, 0x02, 0x10, 0x00, 0x00, 0x00, 0x0f, 0x02, 0x2f, 0x02, 0x27, 0x00,
+    0x07, 0x00, 0x05, 0x02, 0x45, 0x02, 0x47, 0x04, 0x07, 0x04, 0x07, 0x06,
+    0x87, 0x06, 0x87, 0x04, 0x07, 0x04, 0x07, 0x00, 0x00, 0x00, 0x00, 0x01,
+    0x00, 0x09, 0xfc, 0x00, 0x08, 0xf9, 0x00, 0x00, 0x23, 0x15, 0x00, 0x00,
+    0x08, 0x00, 0x08, 0x02, 0x18, 0x02, 0x10, 0x00, 0x00, 0x00, 0x0f, 0x02,
+    0x2f, 0x02, 0x27, 0x00, 0x07, 0x00, 0x03, 0x02, 0x43, 0x02, 0x46, 0x04,
+    0x06, 0x04, 0x07, 0x06, 0x87, 0x06, 0x87, 0x04, 0x07, 0x04, 0x07, 0x00,
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x09, 0xfc, 0x00, 0x08, 0xf9, 0x00, 0x00,
+    0x23, 0x15, 0x00, 0x00, 0x08, 0x00, 0x09, 0x02, 0x19, 0x02, 0x12, 0x00,
+    0x02, 0x00, 0x0f, 0x02, 0x2f, 0x02, 0x27, 0x00, 0x07, 0x00, 0x02, 0x02,
+    0x42, 0x02, 0x43, 0x04, 0x03, 0x04, 0x07, 0x06, 0x87, 0x06, 0x87, 0x04,
+    0x07, 0x04, 0x07, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x09, 0xfc, 0x00,
+    0x08, 0xf9, 0x00, 0x00, 0x23, 0x15, 0x00, 0x00, 0x08, 0x00, 0x0b, 0x02,
+    0x1b, 0x02, 0x14, 0x00, 0x04, 0x00, 0x0f, 0x02, 0x2f, 0x02, 0x27, 0x00,
+    0x0f, 0x00, 0x0b, 0x02, 0x4b, 0x02, 0x43, 0x04, 0x03, 0x04, 0x07, 0x06,
+    0x87, 0x06, 0x87, 0x04, 0x07, 0x04, 0x0f, 0x00, 0x08, 0x00, 0x08, 0x01,
+    0x00, 0x09, 0xfc, 0x00, 0x08, 0xf9, 0x00, 0x00, 0x81, 0xea, 0x81, 0xea,
+    0x81, 0xea, 0x81, 0xea, 0x81, 0xea, 0x81, 0xea, 0x81, 0xea, 0x81, 0xea,
+    0x81, 0xea, 0x23, 0x15, 0x00, 0x00, 0x08, 0x00, 0x0f, 0x02, 0x1f, 0x02,
+    0x17, 0x00, 0x07, 0x00, 0x08, 0x02, 0x28, 0x02, 0x20, 0x00, 0x00, 0x00,
+    0x07, 0x02, 0x47, 0x02, 0x47, 0x04, 0x07, 0x04, 0x03, 0x06, 0x83, 0x06,
+    0x86, 0x04, 0x06, 0x04, 0x06, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x09,
+    0xfc, 0x00, 0x08, 0xf9, 0x00, 0x00, 0x23, 0x15, 0x00, 0x00, 0x08, 0x00,
+    0x0f, 0x02, 0x1f, 0x02, 0x17, 0x00, 0x07, 0x00, 0x08, 0x02, 0x28, 0x02,
+    0x20, 0x00, 0x00, 0x00, 0x07, 0x02, 0x47, 0x02, 0x47, 0x04, 0x07, 0x04,
+    0x05, 0x06, 0x85, 0x06, 0x87, 0x04, 0x07, 0x04, 0x07, 0x00, 0x00, 0x00,
+    0x00, 0x01, 0x00, 0x09, 0xfc, 0x00, 0x08, 0xf9, 0x00, 0x00, 0x23, 0x15,
+    0x00, 0x00, 0x08, 0x00, 0x0f, 0x02, 0x1f, 0x02, 0x17, 0x00, 0x07, 0x00,
+    0x08, 0x02, 0x28, 0x02, 0x22, 0x00, 0x02, 0x00, 0x07, 0x02, 0x47, 0x02,
+    0x47, 0x04, 0x07, 0x04, 0x03, 0x06, 0x83, 0x06, 0x85, 0x04, 0x05, 0x04,
+    0x05, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x09, 0xfc, 0x00, 0x08, 0xf9,
+    0x00, 0x00, 0x23, 0x15, 0x00, 0x00, 0x08, 0x00, 0x0f, 0x02, 0x1f, 0x02,
+    0x17, 0x00, 0x07, 0x00, 0x08, 0x02, 0x28, 0x02, 0x21, 0x00, 0x01, 0x00,
+    0x07, 0x02, 0x47, 0x02, 0x47, 0x04, 0x07, 0x04, 0x03, 0x06, 0x83, 0x06,
+    0x87, 0x04, 0x07, 0x04, 0x07, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x09,
+    0xfc, 0x00, 0x08, 0xf9, 0x00, 0x00, 0x23, 0x15, 0x00, 0x00, 0x08, 0x00,
+    0x0f, 0x02, 0x1f, 0x02, 0x17, 0x00, 0x07, 0x00, 0x0b, 0x02, 0x2b, 0x02,
+    0x24, 0x00, 0x04, 0x00, 0x07, 0x02, 0x47, 0x02, 0x47, 0x04, 0x07, 0x04,
+    0x03, 0x06, 0x83, 0x06, 0x83, 0x04, 0x03, 0x04, 0x03, 0x00, 0x00, 0x00,
+    0x00, 0x01, 0x00, 0x09, 0xfc, 0x00, 0x08, 0xf9, 0x00, 0x00, 0x23, 0x15,
+    0x00, 0x00, 0x08, 0x00, 0x0f, 0x02, 0x1f, 0x02, 0x17, 0x00, 0x07, 0x00,
+    0x08, 0x02, 0x28, 0x02, 0x20, 0x00, 0x00, 0x00, 0x07, 0x02, 0x47, 0x02,
+    0x47, 0x04, 0x07, 0x04, 0x03, 0x06, 0x83, 0x06, 0x85, 0x04, 0x05, 0x04,
+    0x05, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x09, 0xfc, 0x00, 0x08, 0xf9,
+    0x00, 0x00, 0x23, 0x15, 0x00, 0x00, 0x08, 0x00, 0x0f, 0x02, 0x1f, 0x02,
+    0x17, 0x00, 0x07, 0x00, 0x0a, 0x02, 0x2a, 0x02, 0x20, 0x00, 0x00, 0x00,
+    0x07, 0x02, 0x47, 0x02, 0x47, 0x04, 0x07, 0x04, 0x07, 0x06, 0x87, 0x06,
+    0x81, 0x04, 0x01, 0x04, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x09,
+    0xfc, 0x00, 0x08, 0xf9, 0x00, 0x00, 0x23, 0x15, 0x00, 0x00, 0x08, 0x00,
+    0x0f, 0x02, 0x1f, 0x02, 0x17, 0x00, 0x07, 0x00, 0x09, 0x02, 0x29, 0x02,
+    0x22, 0x00, 0x02, 0x00, 0x07, 0x02, 0x47, 0x02, 0x47, 0x04, 0x07, 0x04,
+    0x02, 0x06, 0x82, 0x06, 0x83, 0x04, 0x03, 0x04, 0x03, 0x00, 0x00, 0x00,
+    0x00, 0x01, 0x00, 0x09, 0xfc, 0x00, 0x08, 0xf9, 0x00, 0x00, 0x23, 0x15,
+    0x00, 0x00, 0x08, 0x00, 0x0f, 0x02, 0x1f, 0x02, 0x17, 0x00, 0x07, 0x00,
+    0x09, 0x02, 0x29, 0x02, 0x21, 0x00, 0x01, 0x00, 0x07, 0x02, 0x47, 0x02,
+    0x47, 0x04, 0x07, 0x04, 0x05, 0x06, 0x85, 0x06, 0x83, 0x04, 0x03, 0x04,
+    0x03, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x09, 0xfc, 0x00, 0x08, 0xf9,
+    0x00, 0x00, 0x23, 0x15, 0x00, 0x00, 0x08, 0x00, 0x0f, 0x02, 0x1f, 0x02,
+    0x17, 0x00, 0x07, 0x00, 0x08, 0x02, 0x28, 0x02, 0x20, 0x00, 0x00, 0x00,
+    0x07, 0x02, 0x47, 0x02, 0x47, 0x04, 0x07, 0x04, 0x03, 0x06, 0x83, 0x06,
+    0x81, 0x04, 0x01, 0x04, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x09,
+    0xfc, 0x00, 0x08, 0xf9, 0x00, 0x00, 0x23, 0x15, 0x00, 0x00, 0x08, 0x00,
+    0x0f, 0x02, 0x1f, 0x02, 0x17, 0x00, 0x07, 0x00, 0x08, 0x02, 0x28, 0x02,
+    0x20, 0x00, 0x00, 0x00, 0x07, 0x02, 0x47, 0x02, 0x47, 0x04, 0x07, 0x04,
+    0x05, 0x06, 0x85, 0x06, 0x83, 0x04, 0x03, 0x04, 0x03, 0x00, 0x00, 0x00,
+    0x00, 0x01, 0x00, 0x09, 0xfc, 0x00, 0x08, 0xf9, 0x00, 0x00, 0x23, 0x15,
+    0x00, 0x00, 0x08, 0x00, 0x0f, 0x02, 0x1f, 0x02, 0x17, 0x00, 0x07, 0x00,
+    0x09, 0x02, 0x29, 0x02, 0x24, 0x00, 0x04, 0x00, 0x07, 0x02, 0x47, 0x02,
+    0x47, 0x04, 0x07, 0x04, 0x04, 0x06, 0x84, 0x06, 0x83, 0x04, 0x03, 0x04,
+    0x03, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x09, 0xfc, 0x00, 0x08, 0xf9,
+    0x00, 0x00, 0x23, 0x15, 0x00, 0x00, 0x08, 0x00, 0x0f, 0x02, 0x1f, 0x02,
+    0x17, 0x00, 0x07, 0x00, 0x08, 0x02, 0x28, 0x02, 0x21, 0x00, 0x01, 0x00,
+    0x07, 0x02, 0x47, 0x02, 0x47, 0x04, 0x07, 0x04, 0x02, 0x06, 0x82, 0x06,
+    0x87, 0x04, 0x07, 0x04, 0x07, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x09,
+    0xfc, 0x00, 0x08, 0xf9, 0x00, 0x00, 0x23, 0x15, 0x00, 0x00, 0x08, 0x00,
+    0x0f, 0x02, 0x1f, 0x02, 0x17, 0x00, 0x07, 0x00, 0x08, 0x02, 0x28, 0x02,
+    0x21, 0x00, 0x09, 0x00, 0x0f, 0x02, 0x4f, 0x02, 0x47, 0x04, 0x07, 0x04,
+    0x01, 0x06, 0x81, 0x06, 0x87, 0x04, 0x07, 0x04, 0x0f, 0x00, 0x08, 0x00,
+    0x08, 0x01, 0x00, 0x09, 0xfc, 0x00, 0x08, 0xf9, 0x00, 0x00, 0x00,
+};
+
+static const printspider_job_t demo_job = {
+    PRINTSPIDER_WAVEFORM_BLACK_B, 11, demo_job_data};
+
+#endif
@@ -0,0 +1,132 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef EMIT_H
+#define EMIT_H
+
+#include <stdint.h>
+
+#include "Arduino.h"
+#include "printspider.h"
+#include "printspider_cache.h"
+#include "printspider_dual.h"
+
+/*
+Output stage writing waveform words to the cartridge lines. Words are first converted into PORTD/PORTB
+port pairs (see printspider_port.h) and then written by a cycle-counted loop, so every word stays on the
+lines for exactly EMIT_WORD_CYCLES CPU cycles. Converted packets are kept in a small cache, see
+printspider_cache.h, and blank rows are only waited out. With EMIT_DIRECT_PORTS packets missing from the
+cache are generated straight as port pairs (see printspider_portgen.h), which takes less time per packet
+for about 170 bytes more RAM; the words written stay the same.
+
+With PRINT_DUAL a second cartridge takes PORTC bits 0..5 (see printspider_dual.h), and merged packets are
+written as PORTD/PORTB/PORTC triples by a loop of the same word rate. The packet cache is left out then.
+*/
+
+// CPU cycles every waveform word is held on the output lines. The default
+// gives a 1 MHz word rate at 16 MHz.
+#ifndef EMIT_WORD_CYCLES
+#define EMIT_WORD_CYCLES 16
+#endif
+
+// Cycles taken by the emission loop itself, without padding.
+#define EMIT_LOOP_CYCLES 12
+
+#if EMIT_WORD_CYCLES < EMIT_LOOP_CYCLES
+#error "EMIT_WORD_CYCLES is shorter than the emission loop"
+#endif
+
+#ifdef PRINT_DUAL
+// Cycles taken by the emission loop of port triples, without padding.
+#define EMIT_TRIPLE_LOOP_CYCLES 16
+
+#if EMIT_WORD_CYCLES < EMIT_TRIPLE_LOOP_CYCLES
+#error "EMIT_WORD_CYCLES is shorter than the emission loop of port triples"
+#endif
+
+// PORTC lines of the second cartridge.
+#define EMIT_DUAL_MASK 0x3f
+#endif
+
+/**
+ * Sets output pin state by writing directly to its port register. Pins 0..7
+ * are on PORTD, pins 8..13 are on PORTB.
+ */
+static inline void digitalWriteFast(uint8_t pin, uint8_t x) {
+    if (pin / 8) {  // pin >= 8
+        PORTB ^= (-x ^ PORTB) & (1 << (pin % 8));
+    } else {
+        PORTD ^= (-x ^ PORTD) & (1 << (pin % 8));
+    }
+}
+
+/**
+ * Builds port translation tables for the bus.
+ * @param bus pin numbers, bus[i] carries bit i of a waveform word.
+ * @param len number of pins in bus.
+ */
+void emit_setup(const uint8_t *bus, uint8_t len);
+
+/**
+ * Converts waveform words to port pairs in place.
+ */
+void emit_convert(uint16_t *buffer, int len);
+
+/**
+ * Writes port pairs to PORTD/PORTB with fixed timing. Interrupts are disabled
+ * while the words are written.
+ */
+void emit_pairs(const uint16_t *pairs, int len);
+
+/**
+ * Keeps the bus low for len words, taking the same time as emit_pairs.
+ * Interrupts stay enabled, so the time may get a little longer.
+ */
+void emit_idle(int len);
+
+#ifdef PRINT_DUAL
+/**
+ * Writes port triples to PORTD/PORTB/PORTC with fixed timing. Interrupts are
+ * disabled while the words are written.
+ */
+void emit_triples(const uint8_t *triples, int len);
+
+/**
+ * Starts merging a row of both cartridges with the bus port map, see
+ * printspider_dual_begin.
+ */
+void emit_dual_begin(printspider_dual_cursor_t *cursor,
+                     const printspider_waveform_desc_t *a,
+                     const uint8_t *nozdata_a,
+                     const printspider_waveform_desc_t *b,
+                     const uint8_t *nozdata_b);
+#else
+/**
+ * Returns port pairs of the next data packet of the cursor, from the packet
+ * cache if possible, see printspider_cache_next_packet.
+ * @param len set to the amount of pairs, or of idle words if NULL is
+ * returned for a blank row; 0 when the row is finished.
+ */
+const uint16_t *emit_next_packet(printspider_waveform_cursor_t *cursor,
+                                 int *len);
+
+/**
+ * Copies the packet cache counters to stats.
+ */
+void emit_get_cache_stats(printspider_cache_stats_t *stats);
+#endif
+
+#endif
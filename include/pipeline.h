@@ -0,0 +1,119 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdint.h>
+
+#include "printspider.h"
+
+/*
+Pipelined print mode. The Timer2 compare interrupt generates and emits one data packet of the current row,
+then sets the timer to come back for the next packet PIPELINE_GAP_US after the emit is done. Packets
+follow each other back to back with the gap in between, and rows with one gap after their last packet,
+so the row rate is set by the waveform length and the time to generate it. The main context fills the
+nozzle data of the next row into a second buffer in the gaps: while a row is out it gets PIPELINE_GAP_US
+of every packet, the profile report shows the waveform and emit stages of the interrupt next to it.
+Blank packets keep the bus low for their length, so every row of a waveform takes the same time.
+
+The interrupt is only enabled while there are rows to print. Every row time the cartridge waits for the
+next row after the slot it should have started in is counted as an underrun.
+
+Up to PIPELINE_ROWS rows are held: the one being emitted and the rows queued after it, so the main
+context can work ahead through rows that take longer to prepare.
+
+With PRINT_TRIGGERED rows don't follow each other at a fixed rate, every row waits for a position trigger,
+see trigger.h. The trigger starts the next queued row right away, so its first word follows the trigger
+by little more than the time to generate one packet; the rest of the row follows back to back. A trigger that comes while the last row is still out starts the next row right after it and
+one that finds no row queued is dropped, both are counted as missed.
+
+Usage: call pipeline_start once, then for every row call pipeline_acquire, enable nozzles in the returned
+buffer and call pipeline_commit. Call pipeline_flush to wait until the last row is out.
+*/
+
+// Time from the end of a data packet to the interrupt generating the next
+// one, in microseconds, a multiple of the 4 us Timer2 count. The main context
+// runs in these gaps while a row is out.
+#ifndef PIPELINE_GAP_US
+#define PIPELINE_GAP_US 32
+#endif
+
+// Nozzle data buffers, the row being emitted included. Triggered rows get a
+// longer queue to even out the time taken to prepare them.
+#ifndef PIPELINE_ROWS
+#ifdef PRINT_TRIGGERED
+#define PIPELINE_ROWS 4
+#else
+#define PIPELINE_ROWS 2
+#endif
+#endif
+
+typedef struct pipeline_stats_t {
+    // Rows sent to the cartridge.
+    uint16_t rows;
+    // Row times that passed without a row ready to print, or triggers that
+    // found none. A row that is late by less than a row time counts once.
+    // Not counted from pipeline_flush to the next commit, so time between
+    // images is not an underrun.
+    uint16_t underruns;
+    // Position triggers, and triggers that couldn't start a row right away.
+    uint16_t triggers;
+    uint16_t missed_triggers;
+    // Shortest and longest time from a trigger to the first word of its row,
+    // in microseconds with the 4 us resolution of micros().
+    uint16_t latency_min_us;
+    uint16_t latency_max_us;
+} pipeline_stats_t;
+
+/**
+ * Sets up the packet timer, it runs while there are rows to print.
+ * @param waveform waveform template used for all rows.
+ */
+void pipeline_start(const printspider_waveform_desc_t *waveform);
+
+/**
+ * Waits for a free nozzle data buffer.
+ * @return cleared buffer of PRINTSPIDER_NOZDATA_SZ bytes.
+ */
+uint8_t *pipeline_acquire(void);
+
+/**
+ * Hands the buffer returned by pipeline_acquire over to the interrupt.
+ */
+void pipeline_commit(void);
+
+/**
+ * Waits until all committed rows are sent. Idle row slots after this are not
+ * counted as underruns.
+ */
+void pipeline_flush(void);
+
+#ifdef PRINT_TRIGGERED
+/**
+ * Starts the next queued row for a position trigger. Called from the encoder
+ * interrupt, see trigger.h.
+ * @param us micros() at the trigger.
+ */
+void pipeline_trigger(uint32_t us);
+#endif
+
+/**
+ * Copies the pipeline counters to stats.
+ */
+void pipeline_get_stats(pipeline_stats_t *stats);
+
+#endif
@@ -0,0 +1,176 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+
+#include "Arduino.h"
+
+/*
+Cycle counters of the print path, enabled with PRINT_PROFILE. Timer1 runs free at the CPU clock and every
+stage of a row is timed between PROFILE_BEGIN and PROFILE_END, keeping the count, min, max, mean and a
+histogram of the cycles it took. The report also has the row rate, pipeline underruns and packet cache
+counters. Under simavr the counts are cycle exact and the same on every run: the simulation starts from
+the same state and takes no input, so every interrupt lands on the same cycle.
+
+Timer1 wraps every 65536 cycles (4.1 ms). Its overflow interrupt counts the wraps as the high half of a
+32-bit time, so long stages are timed correctly too, and the row rate is taken from it as well; the time
+wraps after 268 s. The interrupt takes a few dozen cycles every 4.1 ms, which are counted in whichever
+stage it lands in and can delay a packet of the pipeline by as much. The Timer0 interrupt behind millis()
+and micros() would add several dozen cycles every 1024 us the same way; without PRINT_PIPELINED nothing needs
+it, so profile_init stops it. The pipeline and the position triggers take their times from micros(), so
+pipelined builds keep it and its cycles show up in the max and histogram of the stages it lands in.
+
+Without PRINT_PROFILE all of it compiles to nothing. Timer1 is taken over, so analogWrite on pins 9 and
+10 doesn't work with it.
+
+Usage:
+
+    PROFILE_BEGIN(start);
+    printspider_swath_push(&swath, line, nozdata);
+    PROFILE_END(PROFILE_NOZZLES, start);
+*/
+
+// Stages of the print path.
+// Decoding and dithering an image line, or drawing a label line.
+#define PROFILE_DITHER 0
+// Setting the nozzles of a row, printspider_swath_push or
+// printspider_set_row_*.
+#define PROFILE_NOZZLES 1
+// Fitting a row into the power budget, see printspider_power.h.
+#define PROFILE_POWER 2
+// Waiting for a free buffer of the pipeline, see pipeline.h.
+#define PROFILE_WAIT 3
+// Generating and converting a data packet, taking it from the cache, or
+// decompressing it from a compiled job.
+#define PROFILE_WAVEFORM 4
+// Writing a data packet to the lines, or waiting out a blank one.
+#define PROFILE_EMIT 5
+// A row from row_begin to the end of row_end. In the pipelined mode this
+// doesn't include waveform and emit, which run in the interrupt.
+#define PROFILE_ROW 6
+#define PROFILE_STAGES 7
+
+// Histogram bucket 0 counts durations under 64 cycles, every next bucket
+// twice as long ones, the last one 32768 cycles and more.
+#define PROFILE_BUCKET_SHIFT 6
+#define PROFILE_BUCKETS 11
+
+#ifndef PROFILE_BAUD
+#define PROFILE_BAUD 115200
+#endif
+
+typedef struct profile_stage_t {
+    uint32_t count;
+    // Sum of cycles, for the mean.
+    uint32_t sum;
+    uint32_t min;
+    uint32_t max;
+    // Saturating counts of durations per bucket.
+    uint16_t buckets[PROFILE_BUCKETS];
+} profile_stage_t;
+
+#ifdef PRINT_PROFILE
+
+// Timer1 overflows since profile_init, counted by its interrupt.
+extern volatile uint16_t profile_overflows;
+
+/**
+ * Returns the time in cycles: Timer1 count with its overflows above it.
+ * Reading the 16-bit register takes two instructions and the pipeline
+ * interrupt reads it too, so interrupts are disabled in between. An overflow
+ * that came in while they are, like in the pipeline interrupt, is still
+ * pending and counted here.
+ */
+static inline uint32_t profile_now(void) {
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t t = TCNT1;
+    uint16_t high = profile_overflows;
+    if ((TIFR1 & _BV(TOV1)) && t < 0x8000) high++;
+    SREG = sreg;
+    return (uint32_t)high << 16 | t;
+}
+
+#define PROFILE_BEGIN(start) uint32_t start = profile_now()
+#define PROFILE_END(stage, start) \
+    profile_record((stage), profile_now() - (start))
+
+/**
+ * Starts Timer1 and clears the counters.
+ */
+void profile_init(void);
+
+/**
+ * Clears the counters.
+ */
+void profile_reset(void);
+
+/**
+ * Adds a duration to a stage.
+ * @param stage one of PROFILE_*.
+ * @param cycles duration including the time of taking it, which is
+ * subtracted.
+ */
+void profile_record(uint8_t stage, uint32_t cycles);
+
+/**
+ * Marks the start of a row for PROFILE_ROW.
+ */
+void profile_row_begin(void);
+
+/**
+ * Marks the end of a row for PROFILE_ROW and the row rate.
+ */
+void profile_row_end(void);
+
+/**
+ * Copies the counters of a stage to out.
+ */
+void profile_get(uint8_t stage, profile_stage_t *out);
+
+/**
+ * Writes the report as text, one line at a time:
+ *
+ *     stage count min max mean <64 <128 ... <32768 >=32768
+ *     dither 1 20301 20301 20301 0 0 0 0 0 0 0 0 0 1 0
+ *     ...
+ *     rows 336 us 453120 us_per_row 1348 underruns 0
+ *     cache_hits 120 cache_misses 36 cache_blank_rows 3
+ *
+ * With PRINT_TRIGGERED a line with the trigger counters and latency of
+ * pipeline.h and the encoder position of trigger.h follows the rows line.
+ *
+ * Stage lines have a column per header field, the other lines are pairs of
+ * name and value. Cycles are CPU cycles.
+ * @param write_line called with every line, without the line end.
+ */
+void profile_dump(void (*write_line)(const char *line));
+
+#else
+
+#define PROFILE_BEGIN(start)
+#define PROFILE_END(stage, start)
+#define profile_init()
+#define profile_reset()
+#define profile_row_begin()
+#define profile_row_end()
+
+#endif
+
+#endif
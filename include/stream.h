@@ -0,0 +1,151 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdint.h>
+
+#include "printspider_dither.h"
+
+/*
+Serial row streaming protocol. The host sends image rows over USART0 (see uart.h) and the printer prints
+them as they arrive, for as long as the host keeps sending.
+
+Every frame in both directions is:
+
+    0xA5, type, length (2 bytes, little endian), payload (length bytes), crc
+
+where crc is CRC-8 (polynomial 0x07, initial value 0) of type, length and payload.
+
+Host to printer frames:
+- STREAM_ROW_PACKED: one row, 1 bit per nozzle, MSB first, see printspider_set_row_color and
+  printspider_set_row_black. Color: cyan, magenta and yellow rows of PRINTSPIDER_COLOR_ROW_BYTES bytes
+  each. Black: first and second nozzle row of PRINTSPIDER_BLACK_ROW_BYTES bytes each.
+- STREAM_ROW_BYTES: one row, 1 byte per pixel in the same channel order, 0 is full ink, 255 is no ink.
+  Dithered on the printer while it is received; a frame with a bad crc leaves the dither state unchanged.
+- STREAM_LINE_PACKED, STREAM_LINE_BYTES: one image line, sent once, in the format of STREAM_ROW_PACKED and
+  STREAM_ROW_BYTES. The printer combines the lines for the offset nozzle rows itself (see
+  printspider_swath.h). Color lines have the three channels, black lines have one row that is printed by
+  both nozzle rows. Don't mix line and row frames in one print.
+- STREAM_STATUS_REQUEST: empty, the printer answers with STREAM_STATUS.
+- STREAM_END: empty, the printer waits for the last row to be printed and answers with STREAM_STATUS.
+- STREAM_PROFILE_REQUEST: empty, the printer answers with the profile report, see profile.h. Ignored
+  unless built with PRINT_PROFILE.
+
+Printer to host frames:
+- STREAM_CREDIT: 2 bytes, number of further bytes the host may send. The printer sends the receive
+  buffer size once at start and then returns credit as it takes bytes out of the buffer, so the buffer
+  never overflows as long as the host keeps within its credit.
+- STREAM_STATUS: stream_status_t as little endian 16 bit fields.
+- STREAM_PROFILE: one line of text of the profile report, see profile_dump. An empty line ends the
+  report.
+
+Rows with a wrong payload length for the configured cartridge are dropped, as are frames with a bad crc;
+both are counted in the status.
+*/
+
+#ifndef STREAM_BAUD
+#define STREAM_BAUD 115200
+#endif
+
+// Credit is returned to the host in chunks of this many bytes.
+#ifndef STREAM_CREDIT_CHUNK
+#define STREAM_CREDIT_CHUNK 32
+#endif
+
+#define STREAM_SYNC 0xA5
+
+#define STREAM_ROW_PACKED 0x01
+#define STREAM_ROW_BYTES 0x02
+#define STREAM_STATUS_REQUEST 0x03
+#define STREAM_END 0x04
+#define STREAM_LINE_PACKED 0x05
+#define STREAM_LINE_BYTES 0x06
+#define STREAM_PROFILE_REQUEST 0x07
+#define STREAM_CREDIT 0x81
+#define STREAM_STATUS 0x82
+#define STREAM_PROFILE 0x83
+
+// Results of stream_poll.
+#define STREAM_EVENT_NONE 0
+#define STREAM_EVENT_ROW 1
+#define STREAM_EVENT_STATUS 2
+#define STREAM_EVENT_END 3
+#define STREAM_EVENT_LINE 4
+#define STREAM_EVENT_PROFILE 5
+
+typedef struct stream_status_t {
+    // Rows sent to the cartridge.
+    uint16_t rows;
+    // Row slots that passed without a row to print, not packet slots, see
+    // pipeline.h.
+    uint16_t underruns;
+    // Rows that left nozzles over the power budget for later, and the
+    // amount of those nozzles, see printspider_power.h.
+    uint16_t deferred_rows;
+    uint16_t deferred_nozzles;
+    // Rows and lines received.
+    uint16_t frames;
+    // Frames dropped for a bad crc.
+    uint16_t crc_errors;
+    // Frames dropped for an unknown type or a wrong length.
+    uint16_t frame_errors;
+    // Bytes lost because the receive buffer was full.
+    uint16_t overruns;
+    // Drops lost to the power budget with POWER_NEXT_ROW, nozzles requested
+    // again while still deferred, see printspider_power.h.
+    uint16_t dropped_nozzles;
+} stream_status_t;
+
+/**
+ * Starts receiving and sends the initial credit to the host.
+ * @param channels nozzle rows per print row, 3 for color, 2 for black.
+ * @param line_channels channels of an image line, 3 for color, 1 for black.
+ * @param nozzles nozzles in every nozzle row.
+ * @param dither dither state per nozzle row, used for 8-bit rows and lines.
+ */
+void stream_begin(uint8_t channels, uint8_t line_channels, uint8_t nozzles,
+                  printspider_dither_t *dither);
+
+/**
+ * Processes received bytes until a complete frame or the end of the receive
+ * buffer.
+ * @return one of STREAM_EVENT_*. After STREAM_EVENT_ROW and STREAM_EVENT_LINE
+ * the received data is available from stream_row_bits until the next call.
+ */
+uint8_t stream_poll(void);
+
+/**
+ * Returns 1-bit row of the given channel of the last received row or line.
+ * The channels follow each other, so stream_row_bits(0) is the whole line in
+ * the format taken by printspider_swath_push.
+ */
+const uint8_t *stream_row_bits(uint8_t channel);
+
+/**
+ * Fills the receive counters of status and sends it to the host. Fields rows,
+ * underruns, deferred_* and dropped_nozzles are filled by the caller.
+ */
+void stream_send_status(stream_status_t *status);
+
+/**
+ * Sends a line of the profile report to the host.
+ * @param line text without the line end, empty at the end of the report.
+ */
+void stream_send_profile(const char *line);
+
+#endif
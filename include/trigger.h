@@ -0,0 +1,64 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef TRIGGER_H
+#define TRIGGER_H
+
+#include <stdint.h>
+
+/*
+Position triggers from a quadrature encoder on the carriage or the paper feed, for PRINT_TRIGGERED. The
+encoder channels are connected to A0 (channel A) and A1 (channel B). The pin change interrupt decodes
+every edge of both channels, four counts per encoder line, and every TRIGGER_DIVIDER counts in the print
+direction the next row of the pipeline is started, see pipeline_trigger. Rows are spaced by position, no
+matter how fast the carriage moves or how busy the CPU is.
+
+The print direction is the one with channel A leading; swap the channels to print the other way. Moving
+back doesn't trigger anything until the position where the next row is due is reached again. An edge of
+both channels at once can't be decoded, it means the interrupt was held off for too long and is counted
+as an encoder error.
+
+For a 150 lines per inch encoder strip (600 counts per inch) and 300 DPI rows TRIGGER_DIVIDER is 2.
+*/
+
+// Encoder counts per row.
+#ifndef TRIGGER_DIVIDER
+#define TRIGGER_DIVIDER 2
+#endif
+
+#if TRIGGER_DIVIDER < 1 || TRIGGER_DIVIDER > 16383
+#error "TRIGGER_DIVIDER is out of range"
+#endif
+
+typedef struct trigger_stats_t {
+    // Encoder position in counts since trigger_start.
+    int16_t position;
+    // Edges of both channels at once.
+    uint16_t errors;
+} trigger_stats_t;
+
+/**
+ * Sets up the encoder inputs and starts counting from position 0. The first
+ * row is due at TRIGGER_DIVIDER counts.
+ */
+void trigger_start(void);
+
+/**
+ * Copies the encoder counters to stats.
+ */
+void trigger_get_stats(trigger_stats_t *stats);
+
+#endif
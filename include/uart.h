@@ -0,0 +1,66 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef UART_H
+#define UART_H
+
+#include <stdint.h>
+
+/*
+Minimal USART0 driver. Received bytes are put into a ring buffer by the receive interrupt; sending is
+polled. Used instead of the Arduino Serial object, which is not available from C.
+
+USART0 uses pins 0 and 1, so the cartridge data lines D1 and D2 have to be moved elsewhere when it is in
+use (see main.c).
+*/
+
+// Size of the receive ring buffer, must be a power of two up to 256.
+#ifndef UART_RX_BUFFER_SIZE
+#define UART_RX_BUFFER_SIZE 256
+#endif
+
+/**
+ * Enables USART0 with 8N1 framing.
+ * @param baud baud rate.
+ */
+void uart_init(uint32_t baud);
+
+/**
+ * Returns amount of received bytes waiting in the ring buffer.
+ */
+uint16_t uart_available(void);
+
+/**
+ * Returns next received byte, or -1 if there is none.
+ */
+int uart_read(void);
+
+/**
+ * Returns amount of bytes lost because the ring buffer was full, and clears it.
+ */
+uint16_t uart_take_overruns(void);
+
+/**
+ * Sends a byte, waiting for room in the transmitter.
+ */
+void uart_write(uint8_t c);
+
+/**
+ * Sends len bytes.
+ */
+void uart_write_buffer(const uint8_t *buffer, uint16_t len);
+
+#endif
@@ -20,6 +20,8 @@ limitations under the License.
 #include <stdio.h>
 #include <string.h>
 
+#include "printspider_pgm.h"
+
 // To decode or change these waveforms, please use tools/waveform_editor.html
 static uint16_t waveform_tpl_color_a[] = {
     0x0,    0xc001, 0xc101, 0xc142, 0x42,   0x4001, 0x4101, 0x4112, 0x12,
@@ -38,11 +40,17 @@ static uint16_t waveform_tpl_black_b[] = {
     0x4002, 0x4101, 0x4301, 0x602,  0x402, 0x501, 0x521,  0x422,  0x402,
     0x4002, 0x4000, 0x4080, 0x880,  0x800, 0x800, 0x800,  0x800,  0x800};
 
+#include "printspider_steps.h"
+
 const printspider_waveform_desc_t printspider_waveforms[] = {
-    {waveform_tpl_color_a, sizeof(waveform_tpl_color_a) / 2},
-    {waveform_tpl_color_b, sizeof(waveform_tpl_color_b) / 2},
-    {waveform_tpl_black_a, sizeof(waveform_tpl_black_a) / 2},
-    {waveform_tpl_black_b, sizeof(waveform_tpl_black_b) / 2},
+    {waveform_tpl_color_a, sizeof(waveform_tpl_color_a) / 2,
+     tpl_color_a_steps},
+    {waveform_tpl_color_b, sizeof(waveform_tpl_color_b) / 2,
+     tpl_color_b_steps},
+    {waveform_tpl_black_a, sizeof(waveform_tpl_black_a) / 2,
+     tpl_black_a_steps},
+    {waveform_tpl_black_b, sizeof(waveform_tpl_black_b) / 2,
+     tpl_black_b_steps},
 };
 
 /**
@@ -59,7 +67,7 @@ void printspider_set_nozzle_color(uint8_t *l, int p, int color) {
     const int bo[3][14] = {{8, 13, 4, 9, 0, 5, 10, 1, 6, 11, 2, 7, 12, 3},
                            {11, 2, 7, 12, 3, 8, 13, 4, 9, 0, 5, 10, 1, 6},
                            {0, 5, 10, 1, 6, 11, 2, 7, 12, 3, 8, 13, 4, 9}};
-    if (p > (8 * 14) || p < 0) return;
+    if (p >= (8 * 14) || p < 0) return;
     int byteno = bo[color][p % 14];
     int bitno = p / 14;
     l[byteno + (14 * color)] |= (1 << bitno);
@@ -86,6 +94,7 @@ const bw_nozinfo_t ni[] = {
 // nozzle). Note that the 2 first and last nozzles of each 168-nozzle row are
 // not connected (giving a total of 324 nozzles in the combined two rows).
 void printspider_set_nozzle_black(uint8_t *l, int p, int row) {
+    if (p >= PRINTSPIDER_BLACK_NOZZLES_IN_ROW || p < 0) return;
     if (row) p += 168;
     int j = p / 14;
     int k = 13 - (p % 14);
@@ -98,6 +107,47 @@ void printspider_set_nozzle_black(uint8_t *l, int p, int row) {
     l[ni[j].c * 14 + bo[ni[j].order][k]] |= (1 << ni[j].bit);
 }
 
+// Nozzle data byte and bit mask enabling a nozzle.
+typedef struct {
+    uint8_t byte;
+    uint8_t mask;
+} printspider_nozmap_t;
+
+#include "printspider_nozmap.h"
+
+static const printspider_nozmap_t *const nozmap_color[3] = {
+    nozmap_color_c, nozmap_color_m, nozmap_color_y};
+static const printspider_nozmap_t *const nozmap_black[2] = {nozmap_black_0,
+                                                            nozmap_black_1};
+
+// Enables the nozzles from map for every set pixel of the packed row of n
+// pixels.
+static void set_row(uint8_t *l, const uint8_t *bits, int n,
+                    const printspider_nozmap_t *map) {
+    for (int i = 0; i < n; i += 8) {
+        uint8_t b = bits[i >> 3];
+        // Image rows are mostly blank, skip empty bytes quickly.
+        if (!b) continue;
+        int end = (n - i < 8) ? n - i : 8;
+        for (int k = 0; k < end; k++, b <<= 1) {
+            if (b & 0x80) {
+                l[pgm_read_byte(&map[i + k].byte)] |=
+                    pgm_read_byte(&map[i + k].mask);
+            }
+        }
+    }
+}
+
+void printspider_set_row_color(uint8_t *l, const uint8_t *bits, int color) {
+    if (color < 0 || color > 2) return;
+    set_row(l, bits, PRINTSPIDER_COLOR_NOZZLES_IN_ROW, nozmap_color[color]);
+}
+
+void printspider_set_row_black(uint8_t *l, const uint8_t *bits, int row) {
+    set_row(l, bits, PRINTSPIDER_BLACK_NOZZLES_IN_ROW,
+            nozmap_black[row ? 1 : 0]);
+}
+
 // Function to set a value in the output buffer.
 static inline __attribute__((always_inline)) void set_signals(uint16_t *buf,
                                                               int pos,
@@ -132,81 +182,315 @@ static inline __attribute__((always_inline)) void set_signals(uint16_t *buf,
 #define OUT_F3 (1 << 10)
 #define OUT_F5 (1 << 11)
 
+// Returns 1 if no nozzle at all is enabled in the nozzle data.
+static int nozdata_is_empty(const uint8_t *nozdata) {
+    for (int i = 0; i < PRINTSPIDER_NOZDATA_SZ; i++) {
+        if (nozdata[i] != 0) return 0;
+    }
+    return 1;
+}
+
+// Calculates the template mask and the csync selector for packet j.
+static void packet_setup(const uint8_t *nozdata, int j, uint16_t *mask,
+                         uint16_t *csync_sel) {
+    // We need to mask out some bits in the template, because their data is
+    // generated here.
+    uint16_t m = 0xffff;
+    m &= ~(OUT_CSYNC | OUT_D1 | OUT_D2 | OUT_D3);  // Data and csync
+    // mask out power lines if not needed
+    int power = (nozdata[j] | nozdata[14 + j] | nozdata[28 + j]);
+    if ((power & 0x0f) == 0x00) m &= ~OUT_F3;
+    if ((power & 0xf0) == 0x00) m &= ~OUT_F5;
+    *mask = m;
+    // Depending on which packet we're generating, we pick a different csync
+    // line.
+    if (j == PRINTSPIDER_PACKETS - 1) {  // last one
+        *csync_sel = TP_CSYNC_LAST;
+    } else {
+        *csync_sel = TP_CSYNC_NORM;
+    }
+}
+
+// Generates the output word for template value v of packet j. bit and ov
+// carry the data bit position between the steps of a packet.
+static inline __attribute__((always_inline)) uint16_t packet_word(
+    uint16_t v, const uint8_t *nozdata, int j, uint16_t mask,
+    uint16_t csync_sel, uint8_t *bit, uint8_t *ov) {
+    // Increase bitno if data toggle lines toggle
+    if ((v & (TP_BIT_TOGGLE1 | TP_BIT_TOGGLE2)) != *ov) {
+        if (!*bit) {
+            *bit = 1;  // first bit
+        } else {
+            *bit <<= 1;  // next bit
+        }
+        *ov = v & (TP_BIT_TOGGLE1 | TP_BIT_TOGGLE2);
+    }
+    int en = v & (TP_BIT_TOGGLE1 |
+                  TP_BIT_TOGGLE2);  // only send out bit if data toggle
+                                    // lines are non-zero
+
+    v &= mask;  // We got what we needed from the template. Mask off all
+                // generated bits.
+
+    // Set bit values for [d1, d2, d3] streams
+    if (en) {
+        if (!(nozdata[j] & *bit)) v |= OUT_D1;
+        if (!(nozdata[14 + j] & *bit)) v |= OUT_D2;
+        if (!(nozdata[28 + j] & *bit)) v |= OUT_D3;
+    }
+    // Select correct value for seg ena
+    if (v & csync_sel) v |= OUT_CSYNC;
+    return v;
+}
+
+// Generates data packet j, including its idle words, into w. Returns the
+// amount of words written.
+static int generate_packet(uint16_t *w, const uint16_t *tp,
+                           const uint8_t *nozdata, int j, int l,
+                           int is_empty) {
+    int p = 0;
+    if (is_empty) {
+        // no need to output anything
+        for (; p < l + PRINTSPIDER_IDLE_WORDS; p++) set_signals(w, p, 0);
+        return p;
+    }
+    uint16_t mask, csync_sel;
+    uint8_t bit = 0;
+    uint8_t ov = 0;
+    packet_setup(nozdata, j, &mask, &csync_sel);
+    for (int i = 0; i < l; i++) {
+        set_signals(w, p++,
+                    packet_word(tp[i], nozdata, j, mask, csync_sel, &bit, &ov));
+    }
+    // idle time after data
+    for (int i = 0; i < PRINTSPIDER_IDLE_WORDS; i++) set_signals(w, p++, 0);
+    return p;
+}
+
+// Same as generate_packet, using the precomputed template steps. Only the data
+// bits and the power gating are added per step.
+static int generate_packet_steps(uint16_t *w,
+                                 const printspider_waveform_step_t *steps,
+                                 const uint8_t *nozdata, int j, int l,
+                                 int is_empty) {
+    int p = 0;
+    if (!is_empty) {
+        uint16_t mask;
+        uint16_t csync_sel;
+        packet_setup(nozdata, j, &mask, &csync_sel);
+        // The steps already have csync and the fixed data bits resolved, only
+        // the power gating is left of the mask.
+        mask |= OUT_CSYNC | OUT_D1 | OUT_D2 | OUT_D3;
+        // Index of the word for this packet's csync line.
+        uint8_t last = (csync_sel == TP_CSYNC_LAST);
+        // A data line is driven high for a bit that is not set.
+        uint8_t n1 = ~nozdata[j];
+        uint8_t n2 = ~nozdata[14 + j];
+        uint8_t n3 = ~nozdata[28 + j];
+        for (; p < l; p++) {
+            uint16_t v = pgm_read_word(&steps[p].word[last]) & mask;
+            uint8_t bit = pgm_read_byte(&steps[p].bit);
+            if (n1 & bit) v |= OUT_D1;
+            if (n2 & bit) v |= OUT_D2;
+            if (n3 & bit) v |= OUT_D3;
+            set_signals(w, p, v);
+        }
+    }
+    for (; p < l + PRINTSPIDER_IDLE_WORDS; p++) set_signals(w, p, 0);
+    return p;
+}
+
+int printspider_waveform_length(int l) {
+    // Always an even amount of words
+    return (PRINTSPIDER_PACKETS * (l + PRINTSPIDER_IDLE_WORDS) + 1) & ~1;
+}
+
 // This takes a pointer to a buffer of words to send out to the cartridge after
 // eachother. It then uses a template (tp) with length l to generate the base
 // signals to control the inkjet. It then uses the bitstreams in nozdata to add
 // in the image data into the buffer. It finally returns the length written.
-int printspider_generate_waveform(uint16_t *w, const uint16_t *tp, const uint8_t *nozdata, int l) {
-    const uint8_t *d1data = &nozdata[0];
-    const uint8_t *d2data = &nozdata[14];
-    const uint8_t *d3data = &nozdata[28];
+int printspider_generate_waveform(uint16_t *w, const uint16_t *tp,
+                                  const uint8_t *nozdata, int l) {
     int p = 0;
 
     // See if we actually need to output anything
-    int is_empty = 1;
-    for (int i = 0; i < PRINTSPIDER_NOZDATA_SZ; i++) {
-        if (nozdata[i] != 0) {
-            is_empty = 0;
-            break;
-        }
-    }
+    int is_empty = nozdata_is_empty(nozdata);
 
     // Generate the 14 data packets
-    for (int j = 0; j < 14; j++) {
-        uint8_t bit = 0;
-        int ov = 0;
-        // We need to mask out some bits in the template, because their data is
-        // generated here.
-        uint16_t mask = 0xffff;
-        mask &= ~(OUT_CSYNC | OUT_D1 | OUT_D2 | OUT_D3);  // Data and csync
-        // mask out power lines if not needed
-        int power = (d1data[j] | d2data[j] | d3data[j]);
-        if ((power & 0x0f) == 0x00) mask &= ~OUT_F3;
-        if ((power & 0xf0) == 0x00) mask &= ~OUT_F5;
-        // Depending on which packet we're generating, we pick a different csync
-        // line.
-        uint16_t csync_sel = 0;
-        if (j == 13) {  // last one
-            csync_sel = TP_CSYNC_LAST;
+    for (int j = 0; j < PRINTSPIDER_PACKETS; j++) {
+        p += generate_packet(&w[p], tp, nozdata, j, l, is_empty);
+    }
+    // Always return an even amount of words
+    return (p + 1) & ~1;
+}
+
+int printspider_generate_waveform_fast(uint16_t *w,
+                                       const printspider_waveform_desc_t *wf,
+                                       const uint8_t *nozdata) {
+    if (!wf->steps) {
+        return printspider_generate_waveform(w, wf->data, nozdata, wf->len);
+    }
+    int p = 0;
+    int is_empty = nozdata_is_empty(nozdata);
+    for (int j = 0; j < PRINTSPIDER_PACKETS; j++) {
+        p += generate_packet_steps(&w[p], wf->steps, nozdata, j, wf->len,
+                                   is_empty);
+    }
+    return (p + 1) & ~1;
+}
+
+void printspider_waveform_begin(printspider_waveform_cursor_t *c,
+                                const uint16_t *tp, const uint8_t *nozdata,
+                                int l) {
+    c->tp = tp;
+    c->steps = NULL;
+    c->nozdata = nozdata;
+    c->len = l;
+    c->pos = 0;
+    c->total = printspider_waveform_length(l);
+    c->packet = 0;
+    c->step = 0;
+    c->is_empty = nozdata_is_empty(nozdata);
+}
+
+void printspider_waveform_begin_fast(printspider_waveform_cursor_t *c,
+                                     const printspider_waveform_desc_t *wf,
+                                     const uint8_t *nozdata) {
+    printspider_waveform_begin(c, wf->data, nozdata, wf->len);
+    c->steps = wf->steps;
+}
+
+int printspider_waveform_next_word(printspider_waveform_cursor_t *c,
+                                   uint16_t *v) {
+    if (c->pos >= c->total) return 0;
+    c->pos++;
+    if (c->packet >= PRINTSPIDER_PACKETS) {
+        // padding to an even length
+        *v = 0;
+        return 1;
+    }
+    if (c->step == 0) {
+        packet_setup(c->nozdata, c->packet, &c->mask, &c->csync_sel);
+        c->bit = 0;
+        c->ov = 0;
+    }
+    if (c->step < c->len && !c->is_empty) {
+        *v = packet_word(c->tp[c->step], c->nozdata, c->packet, c->mask,
+                         c->csync_sel, &c->bit, &c->ov);
+    } else {
+        *v = 0;
+    }
+    if (++c->step == c->len + PRINTSPIDER_IDLE_WORDS) {
+        c->step = 0;
+        c->packet++;
+    }
+    return 1;
+}
+
+int printspider_waveform_next_packet(printspider_waveform_cursor_t *c,
+                                     uint16_t *w) {
+    if (c->pos >= c->total) return 0;
+    int p = 0;
+    if (c->packet < PRINTSPIDER_PACKETS) {
+        if (c->steps) {
+            p = generate_packet_steps(w, c->steps, c->nozdata, c->packet,
+                                      c->len, c->is_empty);
         } else {
-            csync_sel = TP_CSYNC_NORM;
+            p = generate_packet(w, c->tp, c->nozdata, c->packet, c->len,
+                                c->is_empty);
         }
+        c->packet++;
+    }
+    // The last packet also carries the padding to an even length.
+    if (c->packet == PRINTSPIDER_PACKETS) {
+        while (c->pos + p < c->total) set_signals(w, p++, 0);
+    }
+    c->pos += p;
+    return p;
+}
+
+int printspider_waveform_skip_packet(printspider_waveform_cursor_t *c) {
+    if (c->pos >= c->total) return 0;
+    int p = 0;
+    if (c->packet < PRINTSPIDER_PACKETS) {
+        p = c->len + PRINTSPIDER_IDLE_WORDS;
+        c->packet++;
+    }
+    if (c->packet == PRINTSPIDER_PACKETS) p = c->total - c->pos;
+    c->pos += p;
+    return p;
+}
+
+int printspider_decode_waveform(const uint16_t *w, int len, const uint16_t *tp,
+                                int l, uint8_t *nozdata,
+                                printspider_waveform_info_t *info) {
+    printspider_waveform_info_t scratch;
+    if (!info) info = &scratch;
+    memset(nozdata, 0, PRINTSPIDER_NOZDATA_SZ);
+    memset(info, 0, sizeof(*info));
+    info->error_pos = -1;
+    if (len != printspider_waveform_length(l)) return PRINTSPIDER_DECODE_ELEN;
 
+    // Pick the data bits from the steps that send them. A data line is low
+    // for a nozzle that fires.
+    for (int j = 0; j < PRINTSPIDER_PACKETS; j++) {
+        const uint16_t *pw = &w[j * (l + PRINTSPIDER_IDLE_WORDS)];
+        uint8_t bit = 0;
+        uint8_t ov = 0;
         for (int i = 0; i < l; i++) {
-            if (is_empty) {
-                // no need to output anything
-                set_signals(w, p++, 0);
-                continue;
-            }
             uint16_t v = tp[i];
-            // Increase bitno if data toggle lines toggle
             if ((v & (TP_BIT_TOGGLE1 | TP_BIT_TOGGLE2)) != ov) {
-                if (!bit) {
-                    bit = 1;  // first bit
-                } else {
-                    bit <<= 1;  // next bit
-                }
+                bit = bit ? bit << 1 : 1;
                 ov = v & (TP_BIT_TOGGLE1 | TP_BIT_TOGGLE2);
             }
-            int en = v & (TP_BIT_TOGGLE1 |
-                          TP_BIT_TOGGLE2);  // only send out bit if data toggle
-                                            // lines are non-zero
-
-            v &= mask;  // We got what we needed from the template. Mask off all
-                        // generated bits.
-
-            // Set bit values for [d1, d2, d3] streams
-            if (en) {
-                if (!(d1data[j] & bit)) v |= OUT_D1;
-                if (!(d2data[j] & bit)) v |= OUT_D2;
-                if (!(d3data[j] & bit)) v |= OUT_D3;
+            if (!(v & (TP_BIT_TOGGLE1 | TP_BIT_TOGGLE2))) continue;
+            if (!(pw[i] & OUT_D1)) nozdata[j] |= bit;
+            if (!(pw[i] & OUT_D2)) nozdata[14 + j] |= bit;
+            if (!(pw[i] & OUT_D3)) nozdata[28 + j] |= bit;
+        }
+    }
+
+    // An all-low waveform carries no data at all.
+    info->empty = 1;
+    for (int i = 0; i < len; i++) {
+        if (w[i]) {
+            info->empty = 0;
+            break;
+        }
+    }
+    if (info->empty) memset(nozdata, 0, PRINTSPIDER_NOZDATA_SZ);
+
+    // Describe the packets and compare every element with what the generator
+    // makes of the nozzle data.
+    int is_empty = nozdata_is_empty(nozdata);
+    int p = 0;
+    for (int j = 0; j < PRINTSPIDER_PACKETS; j++) {
+        printspider_packet_info_t *pi = &info->packet[j];
+        uint16_t mask, csync_sel;
+        uint8_t bit = 0;
+        uint8_t ov = 0;
+        packet_setup(nozdata, j, &mask, &csync_sel);
+        pi->start = p;
+        pi->csync_first = 0xff;
+        if (csync_sel == TP_CSYNC_LAST) pi->flags |= PRINTSPIDER_PACKET_LAST;
+        for (int i = 0; i < l + PRINTSPIDER_IDLE_WORDS; i++, p++) {
+            uint16_t expected = 0;
+            if (i < l && !is_empty) {
+                expected = packet_word(tp[i], nozdata, j, mask, csync_sel,
+                                       &bit, &ov);
+            }
+            if (w[p] != expected && info->error_pos < 0) info->error_pos = p;
+            if (w[p] & OUT_CSYNC) {
+                if (pi->csync_first == 0xff) pi->csync_first = i;
+                pi->csync_count++;
             }
-            // Select correct value for seg ena
-            if (v & csync_sel) v |= OUT_CSYNC;
-            set_signals(w, p++, v);
+            if (w[p] & OUT_F3) pi->flags |= PRINTSPIDER_PACKET_F3;
+            if (w[p] & OUT_F5) pi->flags |= PRINTSPIDER_PACKET_F5;
+            pi->idle = (w[p] & 0x0fff) ? 0 : pi->idle + 1;
         }
-        p += 8;  // idle time after data
     }
-    // Always return an even amount of words
-    return (p + 1) & ~1;
+    for (; p < len; p++) {
+        if (w[p] && info->error_pos < 0) info->error_pos = p;
+    }
+    return info->error_pos < 0 ? 0 : PRINTSPIDER_DECODE_EMISMATCH;
 }
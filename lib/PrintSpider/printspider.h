@@ -25,12 +25,18 @@ to essentially fire a 'row' of ink drops. You use this by allocating an uint8_t-
 PRINTSPIDER_NOZDATA_SZ to contain the nozzle data. Clear it by setting all elements to 0, then 
 use printspider_fire_nozzle_color or printspider_fire_nozzle_mono to enable firing a nozzle. 
 Finally, feed the nozzle data to printspider_generate_waveform to generate the actual waveform that
-needs to be sent to the cartridge.
+needs to be sent to the cartridge, or use a printspider_waveform_cursor_t to get it packet by packet.
 */
 
 //Size of the nozzle data, in bytes
 #define PRINTSPIDER_NOZDATA_SZ (14*3)
 
+//Number of data packets sent to the cartridge for every row
+#define PRINTSPIDER_PACKETS 14
+
+//Number of idle (all lines low) words following each data packet
+#define PRINTSPIDER_IDLE_WORDS 8
+
 //Colors, for printspider_fire_nozzle_color
 #define PRINTSPIDER_COLOR_C 0
 #define PRINTSPIDER_COLOR_M 1
@@ -52,6 +58,13 @@ needs to be sent to the cartridge.
 //Number of nozzles in each row of mono cartridge
 #define PRINTSPIDER_BLACK_NOZZLES_IN_ROW 168
 
+//Size in bytes of a packed 1-bit image row, for printspider_set_row_color and printspider_set_row_black
+#define PRINTSPIDER_COLOR_ROW_BYTES ((PRINTSPIDER_COLOR_NOZZLES_IN_ROW + 7) / 8)
+#define PRINTSPIDER_BLACK_ROW_BYTES ((PRINTSPIDER_BLACK_NOZZLES_IN_ROW + 7) / 8)
+
+//Value of pixel `i` in a packed 1-bit image row; the first pixel is the most significant bit of the first byte
+#define PRINTSPIDER_ROW_BIT(bits, i) (((bits)[(i) >> 3] >> (7 - ((i) & 7))) & 1)
+
 enum printspider_waveform_type_en {
 	PRINTSPIDER_WAVEFORM_COLOR_A = 0,		//old, duplicates lines on 2nd color cart
 	PRINTSPIDER_WAVEFORM_COLOR_B = 1,			//works on 2nd color cart
@@ -60,11 +73,23 @@ enum printspider_waveform_type_en {
 };
 
 /*
-Structure to store the waveform data, so you can easily add others if needed.
+Precomputed template step, stored in flash. `word` is the output word with the csync line already resolved
+for a normal ([0]) and for the last ([1]) packet; `bit` is the nozzle data bit sent in this step, or 0 if
+the step sends no data.
+*/
+typedef struct printspider_waveform_step_t {
+	uint16_t word[2];
+	uint8_t bit;
+} printspider_waveform_step_t;
+
+/*
+Structure to store the waveform data, so you can easily add others if needed. `steps` points to the
+precomputed steps of the template (see tools/gen_waveform_steps.py), or is NULL if there are none.
 */
 typedef struct printspider_waveform_desc_t {
 	uint16_t *data;
 	int len;
+	const printspider_waveform_step_t *steps;
 } printspider_waveform_desc_t;
 
 /**
@@ -86,6 +111,20 @@ of each 168-nozzle row are not connected (giving a total of 324 nozzles in the c
 */
 void printspider_set_nozzle_black(uint8_t *l, int p, int row);
 
+/*
+In the nozzle data array `l`, this enables the nozzles of color `color` for all set pixels of the packed
+1-bit image row `bits` of PRINTSPIDER_COLOR_NOZZLES_IN_ROW pixels. Pixel `y` is fired by nozzle
+`y + PRINTSPIDER_COLOR_VERTICAL_OFFSET`, the same as calling printspider_set_nozzle_color for it.
+*/
+void printspider_set_row_color(uint8_t *l, const uint8_t *bits, int color);
+
+/*
+In the nozzle data array `l`, this enables the nozzles of row `row` for all set pixels of the packed 1-bit
+image row `bits` of PRINTSPIDER_BLACK_NOZZLES_IN_ROW pixels, the same as calling
+printspider_set_nozzle_black for every set pixel.
+*/
+void printspider_set_row_black(uint8_t *l, const uint8_t *bits, int row);
+
 /*
 Use the nozzle data in `nozdata` combined with the waveform template `tp` which has a length of `l` 16-bit 
 elements, generate the waveform to send to the printer cartridge and put it in the buffer `w`. Returns the 
@@ -98,4 +137,115 @@ the write_signals function).
 */
 int printspider_generate_waveform(uint16_t *w, const uint16_t *tp, const uint8_t *nozdata, int l);
 
+/*
+Same as printspider_generate_waveform, for the template described by `wf`. If the template has precomputed
+steps, the waveform is generated from them, which only has to add the data bits and power gating per step.
+*/
+int printspider_generate_waveform_fast(uint16_t *w, const printspider_waveform_desc_t *wf, const uint8_t *nozdata);
+
+/*
+Returns the amount of 16-bit elements of the waveform generated from a template of `l` elements.
+*/
+int printspider_waveform_length(int l);
+
+/*
+State of a waveform that is generated piece by piece instead of into one buffer, so the output stage can
+consume it without having room for the whole waveform.
+*/
+typedef struct printspider_waveform_cursor_t {
+	const uint16_t *tp;
+	const printspider_waveform_step_t *steps;
+	const uint8_t *nozdata;
+	int len;
+	// Elements produced so far and in total.
+	int pos;
+	int total;
+	// Current packet and position inside it (template steps, then idle words).
+	uint8_t packet;
+	uint8_t step;
+	// Data bit position and template toggle state of the current packet.
+	uint8_t bit;
+	uint8_t ov;
+	uint8_t is_empty;
+	uint16_t mask;
+	uint16_t csync_sel;
+} printspider_waveform_cursor_t;
+
+/*
+Start streaming the waveform for `nozdata` and the template `tp` of length `l`. The concatenated output of
+the cursor is identical to what printspider_generate_waveform writes to a zeroed buffer. `nozdata` must
+stay unchanged until the cursor is finished.
+*/
+void printspider_waveform_begin(printspider_waveform_cursor_t *c, const uint16_t *tp, const uint8_t *nozdata, int l);
+
+/*
+Same as printspider_waveform_begin, for the template described by `wf`. Packets are generated from the
+precomputed steps if the template has them.
+*/
+void printspider_waveform_begin_fast(printspider_waveform_cursor_t *c, const printspider_waveform_desc_t *wf, const uint8_t *nozdata);
+
+/*
+Put the next element of the waveform in `v`. Returns 1, or 0 when the waveform is finished.
+*/
+int printspider_waveform_next_word(printspider_waveform_cursor_t *c, uint16_t *v);
+
+/*
+Put the next data packet with its trailing idle elements in `w`, which must have room for `l` +
+PRINTSPIDER_IDLE_WORDS + 1 elements. Returns the amount of elements written, or 0 when the waveform is
+finished. Don't mix with printspider_waveform_next_word on the same cursor.
+*/
+int printspider_waveform_next_packet(printspider_waveform_cursor_t *c, uint16_t *w);
+
+/*
+Advance the cursor past the next data packet without generating it. Returns the amount of elements
+printspider_waveform_next_packet would have written, or 0 when the waveform is finished.
+*/
+int printspider_waveform_skip_packet(printspider_waveform_cursor_t *c);
+
+/*
+Structure of one data packet found by printspider_decode_waveform.
+*/
+typedef struct printspider_packet_info_t {
+	// Index in the waveform of the first element of the packet.
+	uint16_t start;
+	// Template step of the first element with csync high, or 0xff if csync stays low.
+	uint8_t csync_first;
+	// Amount of elements with csync high.
+	uint8_t csync_count;
+	// PRINTSPIDER_PACKET_* flags.
+	uint8_t flags;
+	// Amount of all-low elements at the end of the packet, including the idle words.
+	uint8_t idle;
+} printspider_packet_info_t;
+
+//The F3 power line is pulsed in the packet
+#define PRINTSPIDER_PACKET_F3 (1 << 0)
+//The F5 power line is pulsed in the packet
+#define PRINTSPIDER_PACKET_F5 (1 << 1)
+//The packet uses the csync selection of the last packet of a row
+#define PRINTSPIDER_PACKET_LAST (1 << 2)
+
+typedef struct printspider_waveform_info_t {
+	// The waveform is all low, no nozzle fires.
+	uint8_t empty;
+	// Index of the first element that differs from what the generator makes of the decoded nozzle data,
+	// or -1.
+	int error_pos;
+	printspider_packet_info_t packet[PRINTSPIDER_PACKETS];
+} printspider_waveform_info_t;
+
+//Errors returned by printspider_decode_waveform
+#define PRINTSPIDER_DECODE_ELEN (-1)
+#define PRINTSPIDER_DECODE_EMISMATCH (-2)
+
+/*
+The reverse of printspider_generate_waveform: rebuild the nozzle data `nozdata` from the waveform `w` of
+`len` elements that was generated with the template `tp` of length `l`. If `info` is not NULL, the packet
+structure is reported in it. Returns 0 if the waveform is exactly what printspider_generate_waveform makes
+of the rebuilt nozzle data, PRINTSPIDER_DECODE_ELEN if `len` doesn't fit the template, or
+PRINTSPIDER_DECODE_EMISMATCH if any element differs (see `info->error_pos`).
+*/
+int printspider_decode_waveform(const uint16_t *w, int len, const uint16_t *tp, int l, uint8_t *nozdata,
+                                printspider_waveform_info_t *info);
+
 #endif
\ No newline at end of file
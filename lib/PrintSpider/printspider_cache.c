@@ -0,0 +1,86 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Reuse of converted data packets.
+#include "printspider_cache.h"
+
+#include <string.h>
+
+void printspider_cache_init(printspider_cache_t *k,
+                            const printspider_portmap_t *portmap) {
+    memset(&k->stats, 0, sizeof(k->stats));
+    k->portmap = portmap;
+    k->portgen = NULL;
+    printspider_cache_clear(k);
+}
+
+void printspider_cache_use_portgen(printspider_cache_t *k,
+                                  printspider_portgen_t *g) {
+    k->portgen = g;
+    if (g) g->steps = NULL;
+}
+
+void printspider_cache_clear(printspider_cache_t *k) {
+    k->tp = NULL;
+    k->used = 0;
+    k->next = 0;
+}
+
+const uint16_t *printspider_cache_next_packet(printspider_cache_t *k,
+                                              printspider_waveform_cursor_t *c,
+                                              int *len) {
+    if (c->pos >= c->total) {
+        *len = 0;
+        return NULL;
+    }
+    if (c->is_empty) {
+        if (c->packet == 0) k->stats.blank_rows++;
+        *len = printspider_waveform_skip_packet(c);
+        return NULL;
+    }
+    if (c->tp != k->tp) {
+        printspider_cache_clear(k);
+        k->tp = c->tp;
+    }
+    uint8_t j = c->packet;
+    uint8_t key[4] = {c->nozdata[j], c->nozdata[14 + j], c->nozdata[28 + j],
+                      j == PRINTSPIDER_PACKETS - 1};
+    for (uint8_t i = 0; i < k->used; i++) {
+        printspider_cache_entry_t *e = &k->entry[i];
+        if (memcmp(e->key, key, sizeof(key)) == 0) {
+            k->stats.hits++;
+            *len = printspider_waveform_skip_packet(c);
+            return e->pairs;
+        }
+    }
+    // Replace the entries in turn.
+    printspider_cache_entry_t *e = &k->entry[k->next];
+    if (++k->next == PRINTSPIDER_CACHE_ENTRIES) k->next = 0;
+    if (k->used < PRINTSPIDER_CACHE_ENTRIES) k->used++;
+    k->stats.misses++;
+    memcpy(e->key, key, sizeof(key));
+    printspider_portgen_t *g = k->portgen;
+    if (g && c->steps &&
+        (g->steps == c->steps ||
+         printspider_portgen_init(g, k->portmap, c->steps, c->len) == 0)) {
+        e->len = printspider_portgen_next_packet(g, c, e->pairs);
+    } else {
+        e->len = printspider_waveform_next_packet(c, e->pairs);
+        printspider_portmap_convert(k->portmap, e->pairs, e->len);
+    }
+    *len = e->len;
+    return e->pairs;
+}
@@ -0,0 +1,101 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef PRINTSPIDER_CACHE_H
+#define PRINTSPIDER_CACHE_H
+
+#include <stdint.h>
+
+#include "printspider.h"
+#include "printspider_port.h"
+#include "printspider_portgen.h"
+
+/*
+Cache of data packets already converted to port pairs (see printspider_port.h). A data packet only
+depends on the template, its three nozzle data bytes and whether it is the last packet of the row, so
+the same packet repeats a lot in real images: blank packets in the margins of non-blank rows, solid
+bars, and whole rows printed again. A hit skips both generating and converting the packet.
+
+Rows without any nozzle to fire are not generated at all: printspider_cache_next_packet returns NULL with
+the length of the all-low packet, which the output stage turns into a plain delay.
+
+Missed packets are generated and converted, or with printspider_cache_use_portgen generated straight as port
+pairs (see printspider_portgen.h) when the template has precomputed steps.
+*/
+
+//Number of cached packets
+#ifndef PRINTSPIDER_CACHE_ENTRIES
+#define PRINTSPIDER_CACHE_ENTRIES 4
+#endif
+
+//Room for one packet in a cache entry, must be at least the template length + PRINTSPIDER_IDLE_WORDS + 1
+#ifndef PRINTSPIDER_CACHE_PACKET_LEN
+#define PRINTSPIDER_CACHE_PACKET_LEN 40
+#endif
+
+typedef struct printspider_cache_entry_t {
+	// Nozzle data bytes of the packet and 1 for the last packet of a row.
+	uint8_t key[4];
+	uint8_t len;
+	uint16_t pairs[PRINTSPIDER_CACHE_PACKET_LEN];
+} printspider_cache_entry_t;
+
+typedef struct printspider_cache_stats_t {
+	// Packets taken from the cache and packets generated.
+	uint16_t hits;
+	uint16_t misses;
+	// Rows without any nozzle to fire.
+	uint16_t blank_rows;
+} printspider_cache_stats_t;
+
+typedef struct printspider_cache_t {
+	const printspider_portmap_t *portmap;
+	// Generator of port pairs for missed packets, or NULL.
+	printspider_portgen_t *portgen;
+	// Template of the cached packets.
+	const uint16_t *tp;
+	// Entries in use and the entry replaced next.
+	uint8_t used;
+	uint8_t next;
+	printspider_cache_stats_t stats;
+	printspider_cache_entry_t entry[PRINTSPIDER_CACHE_ENTRIES];
+} printspider_cache_t;
+
+/*
+Initialize the empty cache `k` for packets converted with `portmap`.
+*/
+void printspider_cache_init(printspider_cache_t *k, const printspider_portmap_t *portmap);
+
+/*
+Generate missed packets with `g` instead of generating and converting them. The tables of `g` are built
+from the port map of the cache whenever the template changes. NULL goes back to converting.
+*/
+void printspider_cache_use_portgen(printspider_cache_t *k, printspider_portgen_t *g);
+
+/*
+Drop all cached packets, for example after the port map was changed.
+*/
+void printspider_cache_clear(printspider_cache_t *k);
+
+/*
+Return the port pairs of the next data packet of the cursor `c`, with their amount in `len`. The pairs
+stay valid until the next call. Returns NULL with `len` set to the amount of all-low elements if the row
+is blank, and NULL with `len` 0 when the waveform is finished.
+*/
+const uint16_t *printspider_cache_next_packet(printspider_cache_t *k, printspider_waveform_cursor_t *c,
+	int *len);
+
+#endif
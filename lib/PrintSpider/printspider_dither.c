@@ -0,0 +1,163 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Dithering of 8-bit image rows into nozzle firing bits.
+#include "printspider_dither.h"
+
+#include <string.h>
+
+#include "printspider_pgm.h"
+
+// 8x8 Bayer matrix, thresholds 0..63.
+static const uint8_t bayer8[8][8] PROGMEM = {
+    {0, 32, 8, 40, 2, 34, 10, 42},   {48, 16, 56, 24, 50, 18, 58, 26},
+    {12, 44, 4, 36, 14, 46, 6, 38},  {60, 28, 52, 20, 62, 30, 54, 22},
+    {3, 35, 11, 43, 1, 33, 9, 41},   {51, 19, 59, 27, 49, 17, 57, 25},
+    {15, 47, 7, 39, 13, 45, 5, 37},  {63, 31, 55, 23, 61, 29, 53, 21},
+};
+
+// Multi-pass firing patterns: bit s is set for a pixel with that many drops
+// to fire in pass s. The drops are spread evenly, also from the last pass on
+// to the first one.
+static const uint8_t pass_patterns[] PROGMEM = {
+    // 1 pass
+    0x00, 0x01,
+    // 2 passes
+    0x00, 0x02, 0x03,
+    // 3 passes
+    0x00, 0x04, 0x06, 0x07,
+    // 4 passes
+    0x00, 0x08, 0x0a, 0x0e, 0x0f,
+    // 5 passes
+    0x00, 0x10, 0x14, 0x1a, 0x1e, 0x1f,
+    // 6 passes
+    0x00, 0x20, 0x24, 0x2a, 0x36, 0x3e, 0x3f,
+    // 7 passes
+    0x00, 0x40, 0x48, 0x54, 0x6a, 0x76, 0x7e, 0x7f,
+    // 8 passes
+    0x00, 0x80, 0x88, 0xa4, 0xaa, 0xda, 0xee, 0xfe, 0xff,
+};
+
+void printspider_dither_init(printspider_dither_t *d,
+                             enum printspider_dither_mode_en mode,
+                             uint32_t seed) {
+    d->mode = mode;
+    d->density = 255;
+    d->seed = seed;
+    d->passes = 1;
+    d->pass = 0;
+    printspider_dither_reset(d);
+}
+
+void printspider_dither_set_density(printspider_dither_t *d, uint8_t density) {
+    d->density = density;
+}
+
+void printspider_dither_set_passes(printspider_dither_t *d, uint8_t passes) {
+    if (passes < 1) passes = 1;
+    if (passes > PRINTSPIDER_DITHER_MAX_PASSES) {
+        passes = PRINTSPIDER_DITHER_MAX_PASSES;
+    }
+    d->passes = passes;
+    printspider_dither_begin_pass(d, 0);
+}
+
+void printspider_dither_begin_pass(printspider_dither_t *d, uint8_t pass) {
+    d->pass = pass < d->passes ? pass : d->passes - 1;
+    printspider_dither_reset(d);
+}
+
+void printspider_dither_seek_row(printspider_dither_t *d, uint16_t row) {
+    d->row = row;
+    d->phase = (d->pass + row) % d->passes;
+}
+
+void printspider_dither_reset(printspider_dither_t *d) {
+    d->row = 0;
+    d->phase = d->pass;
+    d->error = 0;
+    // xorshift must not start from zero
+    d->state = d->seed ? d->seed : 0x9e3779b9UL;
+}
+
+// Ink amount of a pixel, 0..255.
+static inline uint8_t ink(const printspider_dither_t *d, uint8_t pixel) {
+    return ((uint16_t)(uint8_t)~pixel * (d->density + 1)) >> 8;
+}
+
+void printspider_dither_row(printspider_dither_t *d, const uint8_t *pixels,
+                            uint8_t *bits, int n) {
+    memset(bits, 0, (n + 7) / 8);
+    if (d->mode == PRINTSPIDER_DITHER_RANDOM) {
+        uint32_t x = d->state;
+        uint32_t r = 0;
+        for (int i = 0; i < n; i++) {
+            // One xorshift32 step gives thresholds for four pixels.
+            if ((i & 3) == 0) {
+                x ^= x << 13;
+                x ^= x >> 17;
+                x ^= x << 5;
+                r = x;
+            }
+            // The chance of the nozzle firing is equal to (ink/256).
+            if (ink(d, pixels[i]) > (uint8_t)r) {
+                bits[i >> 3] |= 0x80 >> (i & 7);
+            }
+            r >>= 8;
+        }
+        d->state = x;
+    } else if (d->mode == PRINTSPIDER_DITHER_ORDERED) {
+        const uint8_t *m = bayer8[d->row & 7];
+        for (int i = 0; i < n; i++) {
+            uint8_t threshold = pgm_read_byte(&m[i & 7]) * 4 + 2;
+            if (ink(d, pixels[i]) > threshold) {
+                bits[i >> 3] |= 0x80 >> (i & 7);
+            }
+        }
+    } else if (d->mode == PRINTSPIDER_DITHER_MULTIPASS) {
+        const uint8_t *m = bayer8[d->row & 7];
+        uint8_t passes = d->passes;
+        const uint8_t *patterns =
+            &pass_patterns[(passes - 1) * (passes + 2) / 2];
+        // Pass of the pattern this pass fires, rotated along the row.
+        uint8_t slot = d->phase;
+        for (int i = 0; i < n; i++) {
+            // Ink 0..256 times the passes: whole drops and the part of one
+            // more, which is dithered like in the ordered mode.
+            uint8_t v = ink(d, pixels[i]);
+            uint16_t amount = (uint16_t)(v + (v >> 7)) * passes;
+            uint8_t drops = amount >> 8;
+            uint8_t threshold = pgm_read_byte(&m[i & 7]) * 4 + 2;
+            if ((uint8_t)amount > threshold) drops++;
+            if (pgm_read_byte(&patterns[drops]) & (1 << slot)) {
+                bits[i >> 3] |= 0x80 >> (i & 7);
+            }
+            if (++slot == passes) slot = 0;
+        }
+        if (++d->phase == passes) d->phase = 0;
+    } else {
+        int16_t error = d->error;
+        for (int i = 0; i < n; i++) {
+            error += ink(d, pixels[i]);
+            if (error >= 128) {
+                bits[i >> 3] |= 0x80 >> (i & 7);
+                error -= 255;
+            }
+        }
+        d->error = error;
+    }
+    d->row++;
+}
@@ -0,0 +1,106 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef PRINTSPIDER_DITHER_H
+#define PRINTSPIDER_DITHER_H
+
+#include <stdint.h>
+
+/*
+Routines to turn rows of 8-bit image pixels into the packed 1-bit rows taken by printspider_set_row_color
+and printspider_set_row_black. Use one printspider_dither_t per nozzle row (color channel or black row),
+as the state carries over from one image row to the next. Every mode does the same amount of work for
+every pixel, and the output only depends on the mode, the seed and the rows dithered since the last
+printspider_dither_reset, so print jobs can be reproduced exactly.
+
+Pixel values are image brightness: 0 is full ink, 255 is white paper.
+
+The multi-pass mode prints an image in several passes over the same span, see printspider_dither_set_passes.
+Every pixel gets from 0 to `passes` drops, so full ink puts `passes` drops on a dot. The level of a pixel is
+rounded to a number of drops with the ordered dither matrix, and a table of firing patterns picks the passes
+that fire them, spread evenly over the passes. The pattern is rotated by one pass for every pixel along the
+row and every row, so a nozzle printing a flat grey fires every (`passes` / drops)'th row of a pass instead
+of on consecutive rows, and has more time to refill; neighbouring nozzles take turns as well. Every pass
+costs the same as an ordered dither of the row.
+*/
+
+enum printspider_dither_mode_en {
+	PRINTSPIDER_DITHER_RANDOM = 0,		//xorshift random threshold per pixel
+	PRINTSPIDER_DITHER_ORDERED = 1,		//8x8 Bayer threshold matrix
+	PRINTSPIDER_DITHER_DIFFUSION = 2,	//1-D error diffusion along the row
+	PRINTSPIDER_DITHER_MULTIPASS = 3	//drops spread over several passes
+};
+
+//Most passes of the multi-pass mode
+#define PRINTSPIDER_DITHER_MAX_PASSES 8
+
+typedef struct printspider_dither_t {
+	uint8_t mode;
+	// Maximum ink coverage, 255 is 100%.
+	uint8_t density;
+	// Rows dithered since reset, selects the ordered dither matrix row.
+	uint8_t row;
+	// Passes of the multi-pass mode, the current one and its pattern rotation for the next row.
+	uint8_t passes;
+	uint8_t pass;
+	uint8_t phase;
+	// Error diffusion accumulator, carried from one row to the next.
+	int16_t error;
+	// Random generator seed and state.
+	uint32_t seed;
+	uint32_t state;
+} printspider_dither_t;
+
+/*
+Initialize `d` for dither mode `mode`, with full density, and reset it with `seed`.
+*/
+void printspider_dither_init(printspider_dither_t *d, enum printspider_dither_mode_en mode, uint32_t seed);
+
+/*
+Set the maximum ink coverage of `d`: pixels are scaled so full ink fires (`density` + 1) / 256 of the
+nozzles. Use it to keep the power draw of dense areas within limits.
+*/
+void printspider_dither_set_density(printspider_dither_t *d, uint8_t density);
+
+/*
+Set the number of passes of the multi-pass mode, 1 to PRINTSPIDER_DITHER_MAX_PASSES, and start the first one.
+*/
+void printspider_dither_set_passes(printspider_dither_t *d, uint8_t passes);
+
+/*
+Reset `d` and start the multi-pass pass `pass`, counted from 0. All passes have to dither the same rows.
+*/
+void printspider_dither_begin_pass(printspider_dither_t *d, uint8_t pass);
+
+/*
+Continue dithering at image row `row`, counted from the start of the pass, for images printed in another
+order like the reverse passes of printspider_image_seek. The ordered and the multi-pass modes then dither
+every row the same in any order.
+*/
+void printspider_dither_seek_row(printspider_dither_t *d, uint16_t row);
+
+/*
+Restore the state `d` had right after printspider_dither_init, staying in the current pass.
+*/
+void printspider_dither_reset(printspider_dither_t *d);
+
+/*
+Dither the `n` pixels in `pixels` into the packed row `bits`, which is cleared first. A set bit means the
+nozzle fires.
+*/
+void printspider_dither_row(printspider_dither_t *d, const uint8_t *pixels, uint8_t *bits, int n);
+
+#endif
@@ -0,0 +1,82 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Merging the waveforms of two cartridges into one output stream.
+#include "printspider_dual.h"
+
+#include <stddef.h>
+
+int printspider_dual_compatible(const printspider_waveform_desc_t *a,
+                                const printspider_waveform_desc_t *b) {
+    if (a->len != b->len) return 0;
+    for (int i = 0; i < a->len; i++) {
+        if ((a->data[i] ^ b->data[i]) & PRINTSPIDER_DUAL_SHARED) return 0;
+    }
+    return 1;
+}
+
+void printspider_dual_begin(printspider_dual_cursor_t *c,
+                            const printspider_portmap_t *portmap,
+                            const printspider_waveform_desc_t *a,
+                            const uint8_t *nozdata_a,
+                            const printspider_waveform_desc_t *b,
+                            const uint8_t *nozdata_b) {
+    c->portmap = portmap;
+    printspider_waveform_begin_fast(&c->a, a, nozdata_a);
+    printspider_waveform_begin_fast(&c->b, b, nozdata_b);
+    // A cartridge without nozzles to fire still gets a full waveform while
+    // the other one prints, so the shared clock shifts in data lines that are
+    // high, not all low.
+    if (c->a.is_empty != c->b.is_empty) {
+        c->a.is_empty = 0;
+        c->b.is_empty = 0;
+    }
+}
+
+const uint8_t *printspider_dual_next_packet(printspider_dual_cursor_t *c,
+                                            int *len) {
+    if (c->a.is_empty && c->b.is_empty) {
+        printspider_waveform_skip_packet(&c->b);
+        *len = printspider_waveform_skip_packet(&c->a);
+        return NULL;
+    }
+    // Both templates have the same length, so the packets do too. The
+    // triples are written as bytes over the second cartridge's words, which
+    // bytes may alias.
+    uint8_t *triples = (uint8_t *)c->triples;
+    printspider_waveform_next_packet(&c->b, c->triples);
+    *len = printspider_waveform_next_packet(&c->a, c->words);
+    if (!*len) return NULL;
+    printspider_dual_merge(c->portmap, c->words, c->triples, triples, *len);
+    return triples;
+}
+
+void printspider_dual_merge(const printspider_portmap_t *portmap,
+                            const uint16_t *wa, const uint16_t *wb,
+                            uint8_t *out, int len) {
+    // Last word first: triple i only overwrites words i and up of wb when out
+    // starts at wb.
+    for (int i = len - 1; i >= 0; i--) {
+        uint16_t a = wa[i];
+        uint16_t b = wb[i];
+        uint16_t pair = printspider_portmap_word(
+            portmap, a | (b & PRINTSPIDER_DUAL_SHARED));
+        out[3 * i] = pair;
+        out[3 * i + 1] = pair >> 8;
+        // D1, D2, D3, CSYNC are word bits 0..3, F3 and F5 bits 10 and 11.
+        out[3 * i + 2] = (b & 0x0f) | ((b >> 6) & 0x30);
+    }
+}
@@ -0,0 +1,92 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef PRINTSPIDER_DUAL_H
+#define PRINTSPIDER_DUAL_H
+
+#include <stdint.h>
+
+#include "printspider.h"
+#include "printspider_port.h"
+
+/*
+Driving two cartridges, usually a color and a black one, from one output stream. Both cartridges are
+connected to the same select and clock lines S1..S5 and DCLK; every cartridge has its own data lines
+D1..D3, CSYNC and power lines F3 and F5. This only works when both templates drive the shared lines
+the same way at every step, see printspider_dual_compatible. The color_b and black_b templates do, they
+only differ in the CSYNC selection and the data bit toggles.
+
+Packet j of both rows is generated together and merged into port triples of 3 bytes: PORTD, PORTB and
+PORTC. The lines of the first cartridge, shared ones included, are mapped to PORTD and PORTB with a
+printspider_portmap_t as usual. The own lines of the second cartridge are fixed to PORTC bits 0..5 (pins
+A0..A5 of the Uno) in the order D1, D2, D3, CSYNC, F3, F5, so they take no table.
+
+A row without any nozzle to fire is normally sent as all-low words, but the shared clock would then shift
+all-low data lines, the pattern for firing every nozzle, into that cartridge. So while the other
+cartridge prints, it gets the full waveform of a row without nozzles: the data lines are high and the
+power lines stay low. Only when both rows are blank is the packet all low.
+*/
+
+//Waveform word bits of the lines shared by both cartridges: S2, S4, S1, S5, DCLK and S3
+#define PRINTSPIDER_DUAL_SHARED 0x03f0
+
+//Room for one packet of port triples, must be at least the template length + PRINTSPIDER_IDLE_WORDS + 1
+#ifndef PRINTSPIDER_DUAL_PACKET_LEN
+#define PRINTSPIDER_DUAL_PACKET_LEN 40
+#endif
+
+typedef struct printspider_dual_cursor_t {
+	printspider_waveform_cursor_t a;
+	printspider_waveform_cursor_t b;
+	const printspider_portmap_t *portmap;
+	// Words of the first cartridge's packet.
+	uint16_t words[PRINTSPIDER_DUAL_PACKET_LEN];
+	// Port triples of the merged packet, read as bytes. The second cartridge's packet is generated here
+	// first, as words, so the room is declared as words to keep them aligned.
+	uint16_t triples[(3 * PRINTSPIDER_DUAL_PACKET_LEN + 1) / 2];
+} printspider_dual_cursor_t;
+
+/*
+Return 1 if the templates of `a` and `b` have the same length and drive the shared lines the same way at
+every step, so their packets can be merged.
+*/
+int printspider_dual_compatible(const printspider_waveform_desc_t *a, const printspider_waveform_desc_t *b);
+
+/*
+Start merging the rows `nozdata_a` for the first cartridge with waveform `a` and `nozdata_b` for the
+second one with waveform `b`, which must be compatible. The shared lines and the first cartridge's lines
+are converted with `portmap`. Both nozzle data buffers are read while packets are generated.
+*/
+void printspider_dual_begin(printspider_dual_cursor_t *c, const printspider_portmap_t *portmap,
+	const printspider_waveform_desc_t *a, const uint8_t *nozdata_a,
+	const printspider_waveform_desc_t *b, const uint8_t *nozdata_b);
+
+/*
+Return the port triples of the next merged data packet, `len` triples. When neither row has any nozzle to
+fire NULL is returned and `len` is the length of the all-low packet. `len` is 0 when the rows are
+finished. The triples are valid until the next call.
+*/
+const uint8_t *printspider_dual_next_packet(printspider_dual_cursor_t *c, int *len);
+
+/*
+Merge the packets `wa` of the first cartridge and `wb` of the second one, `len` words each, into `len`
+port triples in `out`. `out` may start at `wb` when it has room for the triples, the words are read
+before they are overwritten.
+*/
+void printspider_dual_merge(const printspider_portmap_t *portmap, const uint16_t *wa, const uint16_t *wb,
+	uint8_t *out, int len);
+
+#endif
@@ -0,0 +1,104 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Reading of images stored in flash.
+#include "printspider_image.h"
+
+#include <string.h>
+
+// Decodes one PackBits compressed channel line of n pixels from flash.
+static const uint8_t *unpack_rle(const uint8_t *src, uint8_t *pixels, int n) {
+    int i = 0;
+    while (i < n) {
+        uint8_t control = pgm_read_byte(src++);
+        if (control < 128) {
+            for (int k = control + 1; k > 0 && i < n; k--) {
+                pixels[i++] = pgm_read_byte(src++);
+            }
+        } else if (control > 128) {
+            uint8_t v = pgm_read_byte(src++);
+            for (int k = 257 - control; k > 0 && i < n; k--) {
+                pixels[i++] = v;
+            }
+        }
+    }
+    return src;
+}
+
+// Returns the end of one PackBits compressed channel line of n pixels.
+static const uint8_t *skip_rle(const uint8_t *src, int n) {
+    int i = 0;
+    while (i < n) {
+        uint8_t control = pgm_read_byte(src++);
+        if (control < 128) {
+            i += control + 1;
+            src += control + 1;
+        } else if (control > 128) {
+            i += 257 - control;
+            src++;
+        }
+    }
+    return src;
+}
+
+void printspider_image_open(printspider_image_reader_t *r,
+                            const printspider_image_t *image) {
+    r->image = image;
+    r->pos = image->data;
+    r->line = 0;
+}
+
+void printspider_image_seek(printspider_image_reader_t *r, uint16_t line) {
+    const printspider_image_t *image = r->image;
+    if (line >= image->lines) {
+        r->line = image->lines;
+        return;
+    }
+    if (image->format == PRINTSPIDER_IMAGE_PACKED) {
+        int row_bytes = (image->width + 7) / 8;
+        r->pos = image->data + (uint32_t)line * image->channels * row_bytes;
+    } else if (image->index) {
+        r->pos = image->data + pgm_read_word(&image->index[line]);
+    } else {
+        if (line < r->line) printspider_image_open(r, image);
+        for (; r->line < line; r->line++) {
+            for (int c = 0; c < image->channels; c++) {
+                r->pos = skip_rle(r->pos, image->width);
+            }
+        }
+    }
+    r->line = line;
+}
+
+int printspider_image_read_line(printspider_image_reader_t *r,
+                                printspider_dither_t *dither, uint8_t *pixels,
+                                uint8_t *bits) {
+    const printspider_image_t *image = r->image;
+    if (r->line >= image->lines) return 0;
+    int row_bytes = (image->width + 7) / 8;
+    for (int c = 0; c < image->channels; c++) {
+        if (image->format == PRINTSPIDER_IMAGE_PACKED) {
+            memcpy_P(bits, r->pos, row_bytes);
+            r->pos += row_bytes;
+        } else {
+            r->pos = unpack_rle(r->pos, pixels, image->width);
+            printspider_dither_row(&dither[c], pixels, bits, image->width);
+        }
+        bits += row_bytes;
+    }
+    r->line++;
+    return 1;
+}
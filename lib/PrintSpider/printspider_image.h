@@ -0,0 +1,88 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef PRINTSPIDER_IMAGE_H
+#define PRINTSPIDER_IMAGE_H
+
+#include <stdint.h>
+
+#include "printspider_dither.h"
+#include "printspider_pgm.h"
+
+/*
+Images stored in flash, read one image line at a time straight into the packed 1-bit lines taken by
+printspider_swath_push, so no image data is copied to RAM. Images are made from PGM, PPM or PNG files by
+tools/ps_image.py, which writes a header with the PROGMEM image data and its printspider_image_t.
+
+Every image line has `channels` channels of `width` pixels: one for the black cartridge, cyan, magenta
+and yellow for the color cartridge. Two formats are supported:
+- PRINTSPIDER_IMAGE_PACKED: 1 bit per pixel, MSB first, set for pixels that fire, (width + 7) / 8 bytes
+  per channel. The image is dithered on the host.
+- PRINTSPIDER_IMAGE_RLE: 8-bit brightness pixels (0 is full ink, see printspider_dither.h), every channel
+  of every line compressed separately with PackBits: a control byte `n` of 0..127 is followed by n + 1
+  literal pixels, a control byte of 129..255 by one pixel repeated 257 - n times, 128 is skipped. The
+  image is dithered on the device while it is read.
+
+Lines can be read in any order with printspider_image_seek, for reverse passes. RLE lines have no fixed
+size, so RLE images carry an index with the offset of every line in `data`; without it seeking backwards
+reads the image again from the start.
+*/
+
+enum printspider_image_format_en {
+	PRINTSPIDER_IMAGE_PACKED = 0,
+	PRINTSPIDER_IMAGE_RLE = 1
+};
+
+typedef struct printspider_image_t {
+	uint8_t format;
+	uint8_t channels;
+	// Pixels in a line of one channel.
+	uint8_t width;
+	uint16_t lines;
+	// Image data in flash.
+	const uint8_t *data;
+	// Offset of every line in data for RLE images, in flash, or NULL.
+	const uint16_t *index;
+} printspider_image_t;
+
+typedef struct printspider_image_reader_t {
+	const printspider_image_t *image;
+	// Next byte to read from flash.
+	const uint8_t *pos;
+	// Lines read so far.
+	uint16_t line;
+} printspider_image_reader_t;
+
+/*
+Start reading `image` from the first line.
+*/
+void printspider_image_open(printspider_image_reader_t *r, const printspider_image_t *image);
+
+/*
+Continue reading at line `line`, so printspider_image_read_line reads that line next.
+*/
+void printspider_image_seek(printspider_image_reader_t *r, uint16_t line);
+
+/*
+Read the next image line into `bits`, which receives the packed 1-bit rows of all channels one after
+another, `channels` * (`width` + 7) / 8 bytes. RLE images are dithered with `dither[c]` for channel `c`,
+using `pixels` of `width` bytes as scratch; both are unused for packed images. Returns 1 if a line was
+read, 0 after the last line.
+*/
+int printspider_image_read_line(printspider_image_reader_t *r, printspider_dither_t *dither, uint8_t *pixels,
+	uint8_t *bits);
+
+#endif
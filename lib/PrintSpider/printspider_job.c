@@ -0,0 +1,105 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Playback and encoding of compiled print jobs.
+#include "printspider_job.h"
+
+#include <stddef.h>
+#include <string.h>
+
+void printspider_job_open(printspider_job_reader_t *r,
+                          const printspider_job_t *job) {
+    r->pos = job->data;
+}
+
+const uint16_t *printspider_job_next_packet(printspider_job_reader_t *r,
+                                            uint16_t *pairs, int *len) {
+    const uint8_t *src = r->pos;
+    uint8_t h = pgm_read_byte(src++);
+    if (h == 0) {
+        // The reader stays at the end.
+        *len = 0;
+        return NULL;
+    }
+    if (h & 0x80) {
+        *len = ((h & 0x7f) << 8) | pgm_read_byte(src++);
+        r->pos = src;
+        return NULL;
+    }
+    int n = h > PRINTSPIDER_JOB_PACKET_LEN ? PRINTSPIDER_JOB_PACKET_LEN : h;
+    int i = 0;
+    while (i < h) {
+        uint8_t control = pgm_read_byte(src++);
+        if (control < 128) {
+            int k = control + 1;
+            if (i < n) {
+                memcpy_P(&pairs[i], src, 2 * (k < n - i ? k : n - i));
+            }
+            src += 2 * k;
+            i += k;
+        } else if (control > 128) {
+            uint16_t v = pgm_read_byte(src) | (pgm_read_byte(src + 1) << 8);
+            src += 2;
+            for (int k = 257 - control; k > 0; k--, i++) {
+                if (i < n) pairs[i] = v;
+            }
+        }
+    }
+    r->pos = src;
+    *len = n;
+    return pairs;
+}
+
+// Writes one PackBits item of literal pairs.
+static uint8_t *put_literal(uint8_t *out, const uint16_t *pairs, int n) {
+    *out++ = n - 1;
+    for (int i = 0; i < n; i++) {
+        *out++ = pairs[i] & 0xff;
+        *out++ = pairs[i] >> 8;
+    }
+    return out;
+}
+
+int printspider_job_encode_packet(uint8_t *out, const uint16_t *pairs,
+                                  int len) {
+    uint8_t *p = out;
+    *p++ = len;
+    int literal = 0;
+    int i = 0;
+    while (i < len) {
+        int run = 1;
+        while (i + run < len && run < 128 && pairs[i + run] == pairs[i]) run++;
+        if (run < 2) {
+            literal++;
+            i++;
+            continue;
+        }
+        if (literal) p = put_literal(p, &pairs[i - literal], literal);
+        literal = 0;
+        *p++ = 257 - run;
+        *p++ = pairs[i] & 0xff;
+        *p++ = pairs[i] >> 8;
+        i += run;
+    }
+    if (literal) p = put_literal(p, &pairs[i - literal], literal);
+    return p - out;
+}
+
+int printspider_job_encode_idle(uint8_t *out, uint16_t len) {
+    out[0] = 0x80 | (len >> 8);
+    out[1] = len & 0xff;
+    return 2;
+}
@@ -0,0 +1,91 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef PRINTSPIDER_JOB_H
+#define PRINTSPIDER_JOB_H
+
+#include <stdint.h>
+
+#include "printspider.h"
+#include "printspider_pgm.h"
+
+/*
+Compiled print jobs: the whole output of a print, every data packet of every row already generated and
+converted to PORTD/PORTB port pairs (see printspider_port.h), stored compressed in flash. Jobs are made on
+the host by tools/ps_job, which runs the image through dithering, the swath scheduler, the power budget
+and the waveform generator the same way the firmware does, so playing a job back only has to decompress
+the packets and write them to the lines. The port pairs are made for the cartridge pins of src/main.c
+without PRINT_STREAM.
+
+The job data is a sequence of records, each starting with a header byte `h`:
+- 0: end of the job.
+- 1..127: a data packet of h port pairs, followed by PackBits items until the packet is complete: a
+  control byte `n` of 0..127 is followed by n + 1 literal pairs, a control byte of 129..255 by one pair
+  repeated 257 - n times, 128 is skipped. Pairs are stored low byte (PORTD) first, as they are in memory.
+- 128..255: a blank row, ((h & 0x7f) << 8) + the next byte words with all lines low.
+*/
+
+//Room for one data packet in port pairs, must be at least the template length + PRINTSPIDER_IDLE_WORDS + 1
+#ifndef PRINTSPIDER_JOB_PACKET_LEN
+#define PRINTSPIDER_JOB_PACKET_LEN 40
+#endif
+
+//Most bytes an encoded data packet of `len` pairs takes
+#define PRINTSPIDER_JOB_PACKET_BYTES(len) (1 + 3 * (len))
+
+//Longest blank row record, in words
+#define PRINTSPIDER_JOB_IDLE_MAX 0x7fff
+
+typedef struct printspider_job_t {
+	// Waveform template the job was compiled for, see printspider_waveform_type_en.
+	uint8_t waveform;
+	// Firings of the job.
+	uint16_t rows;
+	// Job data in flash.
+	const uint8_t *data;
+} printspider_job_t;
+
+typedef struct printspider_job_reader_t {
+	// Next record to read from flash.
+	const uint8_t *pos;
+} printspider_job_reader_t;
+
+/*
+Start playing `job` from the first packet.
+*/
+void printspider_job_open(printspider_job_reader_t *r, const printspider_job_t *job);
+
+/*
+Decompress the next data packet into `pairs` of PRINTSPIDER_JOB_PACKET_LEN elements and return `pairs`,
+with `len` set to the amount of pairs. For a blank row returns NULL with `len` set to the amount of idle
+words, like printspider_cache_next_packet, and at the end of the job NULL with `len` 0.
+*/
+const uint16_t *printspider_job_next_packet(printspider_job_reader_t *r, uint16_t *pairs, int *len);
+
+/*
+Encode the data packet of `len` port pairs, 1 to PRINTSPIDER_JOB_PACKET_LEN, into `out`, which must have
+room for PRINTSPIDER_JOB_PACKET_BYTES(len) bytes. Returns the amount of bytes written. For the compiler on
+the host.
+*/
+int printspider_job_encode_packet(uint8_t *out, const uint16_t *pairs, int len);
+
+/*
+Encode a blank row of `len` words, up to PRINTSPIDER_JOB_IDLE_MAX, into `out`. Returns the amount of
+bytes written, 2.
+*/
+int printspider_job_encode_idle(uint8_t *out, uint16_t len);
+
+#endif
@@ -0,0 +1,115 @@
+// Generated by tools/gen_nozzle_maps.py from the nozzle order tables
+// in printspider.c. Do not edit.
+
+static const printspider_nozmap_t nozmap_color_c[] PROGMEM = {
+    {8, 0x02}, {13, 0x02}, {4, 0x02}, {9, 0x02}, {0, 0x02}, {5, 0x02},
+    {10, 0x02}, {1, 0x02}, {6, 0x02}, {11, 0x02}, {2, 0x02}, {7, 0x02},
+    {12, 0x02}, {3, 0x02}, {8, 0x04}, {13, 0x04}, {4, 0x04}, {9, 0x04},
+    {0, 0x04}, {5, 0x04}, {10, 0x04}, {1, 0x04}, {6, 0x04}, {11, 0x04},
+    {2, 0x04}, {7, 0x04}, {12, 0x04}, {3, 0x04}, {8, 0x08}, {13, 0x08},
+    {4, 0x08}, {9, 0x08}, {0, 0x08}, {5, 0x08}, {10, 0x08}, {1, 0x08},
+    {6, 0x08}, {11, 0x08}, {2, 0x08}, {7, 0x08}, {12, 0x08}, {3, 0x08},
+    {8, 0x10}, {13, 0x10}, {4, 0x10}, {9, 0x10}, {0, 0x10}, {5, 0x10},
+    {10, 0x10}, {1, 0x10}, {6, 0x10}, {11, 0x10}, {2, 0x10}, {7, 0x10},
+    {12, 0x10}, {3, 0x10}, {8, 0x20}, {13, 0x20}, {4, 0x20}, {9, 0x20},
+    {0, 0x20}, {5, 0x20}, {10, 0x20}, {1, 0x20}, {6, 0x20}, {11, 0x20},
+    {2, 0x20}, {7, 0x20}, {12, 0x20}, {3, 0x20}, {8, 0x40}, {13, 0x40},
+    {4, 0x40}, {9, 0x40}, {0, 0x40}, {5, 0x40}, {10, 0x40}, {1, 0x40},
+    {6, 0x40}, {11, 0x40}, {2, 0x40}, {7, 0x40}, {12, 0x40}, {3, 0x40},
+};
+
+static const printspider_nozmap_t nozmap_color_m[] PROGMEM = {
+    {25, 0x02}, {16, 0x02}, {21, 0x02}, {26, 0x02}, {17, 0x02}, {22, 0x02},
+    {27, 0x02}, {18, 0x02}, {23, 0x02}, {14, 0x02}, {19, 0x02}, {24, 0x02},
+    {15, 0x02}, {20, 0x02}, {25, 0x04}, {16, 0x04}, {21, 0x04}, {26, 0x04},
+    {17, 0x04}, {22, 0x04}, {27, 0x04}, {18, 0x04}, {23, 0x04}, {14, 0x04},
+    {19, 0x04}, {24, 0x04}, {15, 0x04}, {20, 0x04}, {25, 0x08}, {16, 0x08},
+    {21, 0x08}, {26, 0x08}, {17, 0x08}, {22, 0x08}, {27, 0x08}, {18, 0x08},
+    {23, 0x08}, {14, 0x08}, {19, 0x08}, {24, 0x08}, {15, 0x08}, {20, 0x08},
+    {25, 0x10}, {16, 0x10}, {21, 0x10}, {26, 0x10}, {17, 0x10}, {22, 0x10},
+    {27, 0x10}, {18, 0x10}, {23, 0x10}, {14, 0x10}, {19, 0x10}, {24, 0x10},
+    {15, 0x10}, {20, 0x10}, {25, 0x20}, {16, 0x20}, {21, 0x20}, {26, 0x20},
+    {17, 0x20}, {22, 0x20}, {27, 0x20}, {18, 0x20}, {23, 0x20}, {14, 0x20},
+    {19, 0x20}, {24, 0x20}, {15, 0x20}, {20, 0x20}, {25, 0x40}, {16, 0x40},
+    {21, 0x40}, {26, 0x40}, {17, 0x40}, {22, 0x40}, {27, 0x40}, {18, 0x40},
+    {23, 0x40}, {14, 0x40}, {19, 0x40}, {24, 0x40}, {15, 0x40}, {20, 0x40},
+};
+
+static const printspider_nozmap_t nozmap_color_y[] PROGMEM = {
+    {28, 0x02}, {33, 0x02}, {38, 0x02}, {29, 0x02}, {34, 0x02}, {39, 0x02},
+    {30, 0x02}, {35, 0x02}, {40, 0x02}, {31, 0x02}, {36, 0x02}, {41, 0x02},
+    {32, 0x02}, {37, 0x02}, {28, 0x04}, {33, 0x04}, {38, 0x04}, {29, 0x04},
+    {34, 0x04}, {39, 0x04}, {30, 0x04}, {35, 0x04}, {40, 0x04}, {31, 0x04},
+    {36, 0x04}, {41, 0x04}, {32, 0x04}, {37, 0x04}, {28, 0x08}, {33, 0x08},
+    {38, 0x08}, {29, 0x08}, {34, 0x08}, {39, 0x08}, {30, 0x08}, {35, 0x08},
+    {40, 0x08}, {31, 0x08}, {36, 0x08}, {41, 0x08}, {32, 0x08}, {37, 0x08},
+    {28, 0x10}, {33, 0x10}, {38, 0x10}, {29, 0x10}, {34, 0x10}, {39, 0x10},
+    {30, 0x10}, {35, 0x10}, {40, 0x10}, {31, 0x10}, {36, 0x10}, {41, 0x10},
+    {32, 0x10}, {37, 0x10}, {28, 0x20}, {33, 0x20}, {38, 0x20}, {29, 0x20},
+    {34, 0x20}, {39, 0x20}, {30, 0x20}, {35, 0x20}, {40, 0x20}, {31, 0x20},
+    {36, 0x20}, {41, 0x20}, {32, 0x20}, {37, 0x20}, {28, 0x40}, {33, 0x40},
+    {38, 0x40}, {29, 0x40}, {34, 0x40}, {39, 0x40}, {30, 0x40}, {35, 0x40},
+    {40, 0x40}, {31, 0x40}, {36, 0x40}, {41, 0x40}, {32, 0x40}, {37, 0x40},
+};
+
+static const printspider_nozmap_t nozmap_black_0[] PROGMEM = {
+    {34, 0x01}, {28, 0x01}, {36, 0x01}, {30, 0x01}, {38, 0x01}, {40, 0x01},
+    {32, 0x01}, {33, 0x01}, {39, 0x01}, {31, 0x01}, {37, 0x01}, {29, 0x01},
+    {35, 0x01}, {41, 0x01}, {34, 0x02}, {28, 0x02}, {36, 0x02}, {30, 0x02},
+    {38, 0x02}, {40, 0x02}, {32, 0x02}, {33, 0x02}, {39, 0x02}, {31, 0x02},
+    {37, 0x02}, {29, 0x02}, {35, 0x02}, {41, 0x02}, {20, 0x01}, {14, 0x01},
+    {22, 0x01}, {16, 0x01}, {24, 0x01}, {26, 0x01}, {18, 0x01}, {19, 0x01},
+    {25, 0x01}, {17, 0x01}, {23, 0x01}, {15, 0x01}, {21, 0x01}, {27, 0x01},
+    {20, 0x02}, {14, 0x02}, {22, 0x02}, {16, 0x02}, {24, 0x02}, {26, 0x02},
+    {18, 0x02}, {19, 0x02}, {25, 0x02}, {17, 0x02}, {23, 0x02}, {15, 0x02},
+    {21, 0x02}, {27, 0x02}, {6, 0x01}, {0, 0x01}, {8, 0x01}, {2, 0x01},
+    {10, 0x01}, {12, 0x01}, {4, 0x01}, {5, 0x01}, {11, 0x01}, {3, 0x01},
+    {9, 0x01}, {1, 0x01}, {7, 0x01}, {13, 0x01}, {6, 0x02}, {0, 0x02},
+    {8, 0x02}, {2, 0x02}, {10, 0x02}, {12, 0x02}, {4, 0x02}, {5, 0x02},
+    {11, 0x02}, {3, 0x02}, {9, 0x02}, {1, 0x02}, {7, 0x02}, {13, 0x02},
+    {34, 0x10}, {28, 0x10}, {36, 0x10}, {30, 0x10}, {38, 0x10}, {40, 0x10},
+    {32, 0x10}, {33, 0x10}, {39, 0x10}, {31, 0x10}, {37, 0x10}, {29, 0x10},
+    {35, 0x10}, {41, 0x10}, {34, 0x20}, {28, 0x20}, {36, 0x20}, {30, 0x20},
+    {38, 0x20}, {40, 0x20}, {32, 0x20}, {33, 0x20}, {39, 0x20}, {31, 0x20},
+    {37, 0x20}, {29, 0x20}, {35, 0x20}, {41, 0x20}, {20, 0x10}, {14, 0x10},
+    {22, 0x10}, {16, 0x10}, {24, 0x10}, {26, 0x10}, {18, 0x10}, {19, 0x10},
+    {25, 0x10}, {17, 0x10}, {23, 0x10}, {15, 0x10}, {21, 0x10}, {27, 0x10},
+    {20, 0x20}, {14, 0x20}, {22, 0x20}, {16, 0x20}, {24, 0x20}, {26, 0x20},
+    {18, 0x20}, {19, 0x20}, {25, 0x20}, {17, 0x20}, {23, 0x20}, {15, 0x20},
+    {21, 0x20}, {27, 0x20}, {6, 0x10}, {0, 0x10}, {8, 0x10}, {2, 0x10},
+    {10, 0x10}, {12, 0x10}, {4, 0x10}, {5, 0x10}, {11, 0x10}, {3, 0x10},
+    {9, 0x10}, {1, 0x10}, {7, 0x10}, {13, 0x10}, {6, 0x20}, {0, 0x20},
+    {8, 0x20}, {2, 0x20}, {10, 0x20}, {12, 0x20}, {4, 0x20}, {5, 0x20},
+    {11, 0x20}, {3, 0x20}, {9, 0x20}, {1, 0x20}, {7, 0x20}, {13, 0x20},
+};
+
+static const printspider_nozmap_t nozmap_black_1[] PROGMEM = {
+    {33, 0x04}, {39, 0x04}, {31, 0x04}, {37, 0x04}, {29, 0x04}, {35, 0x04},
+    {41, 0x04}, {34, 0x04}, {28, 0x04}, {36, 0x04}, {30, 0x04}, {38, 0x04},
+    {40, 0x04}, {32, 0x04}, {33, 0x08}, {39, 0x08}, {31, 0x08}, {37, 0x08},
+    {29, 0x08}, {35, 0x08}, {41, 0x08}, {34, 0x08}, {28, 0x08}, {36, 0x08},
+    {30, 0x08}, {38, 0x08}, {40, 0x08}, {32, 0x08}, {19, 0x04}, {25, 0x04},
+    {17, 0x04}, {23, 0x04}, {15, 0x04}, {21, 0x04}, {27, 0x04}, {20, 0x04},
+    {14, 0x04}, {22, 0x04}, {16, 0x04}, {24, 0x04}, {26, 0x04}, {18, 0x04},
+    {19, 0x08}, {25, 0x08}, {17, 0x08}, {23, 0x08}, {15, 0x08}, {21, 0x08},
+    {27, 0x08}, {20, 0x08}, {14, 0x08}, {22, 0x08}, {16, 0x08}, {24, 0x08},
+    {26, 0x08}, {18, 0x08}, {5, 0x04}, {11, 0x04}, {3, 0x04}, {9, 0x04},
+    {1, 0x04}, {7, 0x04}, {13, 0x04}, {6, 0x04}, {0, 0x04}, {8, 0x04},
+    {2, 0x04}, {10, 0x04}, {12, 0x04}, {4, 0x04}, {5, 0x08}, {11, 0x08},
+    {3, 0x08}, {9, 0x08}, {1, 0x08}, {7, 0x08}, {13, 0x08}, {6, 0x08},
+    {0, 0x08}, {8, 0x08}, {2, 0x08}, {10, 0x08}, {12, 0x08}, {4, 0x08},
+    {33, 0x40}, {39, 0x40}, {31, 0x40}, {37, 0x40}, {29, 0x40}, {35, 0x40},
+    {41, 0x40}, {34, 0x40}, {28, 0x40}, {36, 0x40}, {30, 0x40}, {38, 0x40},
+    {40, 0x40}, {32, 0x40}, {33, 0x80}, {39, 0x80}, {31, 0x80}, {37, 0x80},
+    {29, 0x80}, {35, 0x80}, {41, 0x80}, {34, 0x80}, {28, 0x80}, {36, 0x80},
+    {30, 0x80}, {38, 0x80}, {40, 0x80}, {32, 0x80}, {19, 0x40}, {25, 0x40},
+    {17, 0x40}, {23, 0x40}, {15, 0x40}, {21, 0x40}, {27, 0x40}, {20, 0x40},
+    {14, 0x40}, {22, 0x40}, {16, 0x40}, {24, 0x40}, {26, 0x40}, {18, 0x40},
+    {19, 0x80}, {25, 0x80}, {17, 0x80}, {23, 0x80}, {15, 0x80}, {21, 0x80},
+    {27, 0x80}, {20, 0x80}, {14, 0x80}, {22, 0x80}, {16, 0x80}, {24, 0x80},
+    {26, 0x80}, {18, 0x80}, {5, 0x40}, {11, 0x40}, {3, 0x40}, {9, 0x40},
+    {1, 0x40}, {7, 0x40}, {13, 0x40}, {6, 0x40}, {0, 0x40}, {8, 0x40},
+    {2, 0x40}, {10, 0x40}, {12, 0x40}, {4, 0x40}, {5, 0x80}, {11, 0x80},
+    {3, 0x80}, {9, 0x80}, {1, 0x80}, {7, 0x80}, {13, 0x80}, {6, 0x80},
+    {0, 0x80}, {8, 0x80}, {2, 0x80}, {10, 0x80}, {12, 0x80}, {4, 0x80},
+};
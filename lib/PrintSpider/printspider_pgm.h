@@ -0,0 +1,36 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef PRINTSPIDER_PGM_H
+#define PRINTSPIDER_PGM_H
+
+/*
+Access to constant tables kept in flash. On AVR these are the avr-libc PROGMEM routines, elsewhere the
+tables are ordinary constant data.
+*/
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#include <stdint.h>
+#include <string.h>
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define memcpy_P(d, s, n) memcpy((d), (s), (n))
+#endif
+
+#endif
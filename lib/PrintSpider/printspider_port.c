@@ -0,0 +1,50 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Translation of waveform words into GPIO port values.
+#include "printspider_port.h"
+
+#include <string.h>
+
+// Port pair bit for a pin: pins 0..7 land in the low byte, 8..15 in the high
+// byte, the same split digitalWriteFast does between PORTD and PORTB.
+static uint16_t pin_bit(uint8_t pin) {
+    if (pin / 8) {
+        return (uint16_t)(1 << (pin % 8)) << 8;
+    }
+    return 1 << (pin % 8);
+}
+
+void printspider_portmap_init(printspider_portmap_t *m, const uint8_t *pins,
+                              int n) {
+    memset(m, 0, sizeof(*m));
+    if (n > PRINTSPIDER_PORT_LINES) n = PRINTSPIDER_PORT_LINES;
+    for (int line = 0; line < n; line++) {
+        uint16_t bit = pin_bit(pins[line]);
+        int group = line / 4;
+        for (int v = 0; v < 16; v++) {
+            if (v & (1 << (line % 4))) m->nibble[group][v] |= bit;
+        }
+        m->mask |= bit;
+    }
+}
+
+void printspider_portmap_convert(const printspider_portmap_t *m, uint16_t *buf,
+                                 int len) {
+    for (int i = 0; i < len; i++) {
+        buf[i] = printspider_portmap_word(m, buf[i]);
+    }
+}
@@ -0,0 +1,61 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef PRINTSPIDER_PORT_H
+#define PRINTSPIDER_PORT_H
+
+#include <stdint.h>
+
+/*
+Routines to translate the 16-bit words generated by printspider_generate_waveform into the raw byte
+values of two 8-bit GPIO ports, so the output stage can write a whole word with two port stores instead
+of setting every line separately. Pins are numbered like on the Arduino Uno: pins 0..7 are bits of the
+first port (PORTD) and pins 8..15 are bits of the second port (PORTB).
+
+A converted word ("port pair") keeps the first port byte in the low byte and the second port byte in the
+high byte, so it fits in the same uint16_t slot the waveform word came from and buffers can be converted
+in place.
+*/
+
+//Number of output lines in a waveform word
+#define PRINTSPIDER_PORT_LINES 12
+
+typedef struct printspider_portmap_t {
+	// Port pair for every value of each of the three 4-bit groups of a waveform word.
+	uint16_t nibble[3][16];
+	// Port pair with all the bits used by the bus set.
+	uint16_t mask;
+} printspider_portmap_t;
+
+/*
+Build the translation tables in `m` from the `n` pin numbers in `pins`, where `pins[i]` is the pin that
+carries bit `i` of the waveform word.
+*/
+void printspider_portmap_init(printspider_portmap_t *m, const uint8_t *pins, int n);
+
+/*
+Translate a single waveform word into a port pair.
+*/
+static inline uint16_t printspider_portmap_word(const printspider_portmap_t *m, uint16_t w) {
+	return m->nibble[0][w & 0x0f] | m->nibble[1][(w >> 4) & 0x0f] | m->nibble[2][(w >> 8) & 0x0f];
+}
+
+/*
+Translate `len` waveform words in `buf` into port pairs, in place.
+*/
+void printspider_portmap_convert(const printspider_portmap_t *m, uint16_t *buf, int len);
+
+#endif
@@ -0,0 +1,85 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Generation of data packets as port pairs.
+#include "printspider_portgen.h"
+
+#include <stddef.h>
+
+#include "printspider_pgm.h"
+
+// Waveform word bits of the data and power lines.
+#define WORD_D1 (1 << 0)
+#define WORD_F3 (1 << 10)
+#define WORD_F5 (1 << 11)
+
+int printspider_portgen_init(printspider_portgen_t *g,
+                             const printspider_portmap_t *m,
+                             const printspider_waveform_step_t *steps,
+                             int len) {
+    g->steps = NULL;
+    if (!steps || len > PRINTSPIDER_PORTGEN_STEPS) return -1;
+    for (int i = 0; i < len; i++) {
+        for (int last = 0; last < 2; last++) {
+            g->base[last][i] =
+                printspider_portmap_word(m, pgm_read_word(&steps[i].word[last]));
+        }
+        g->bit[i] = pgm_read_byte(&steps[i].bit);
+    }
+    for (int d = 0; d < 3; d++) {
+        g->data[d] = printspider_portmap_word(m, WORD_D1 << d);
+    }
+    g->f3 = printspider_portmap_word(m, WORD_F3);
+    g->f5 = printspider_portmap_word(m, WORD_F5);
+    g->len = len;
+    g->steps = steps;
+    return 0;
+}
+
+int printspider_portgen_next_packet(const printspider_portgen_t *g,
+                                    printspider_waveform_cursor_t *c,
+                                    uint16_t *w) {
+    uint8_t j = c->packet;
+    uint8_t empty = c->is_empty || j >= PRINTSPIDER_PACKETS;
+    // Advances the cursor and gives the length with idle words and padding.
+    int len = printspider_waveform_skip_packet(c);
+    int p = 0;
+    if (!empty && len) {
+        uint8_t n1 = c->nozdata[j];
+        uint8_t n2 = c->nozdata[14 + j];
+        uint8_t n3 = c->nozdata[28 + j];
+        // Power lines are only pulsed for the nozzle groups that fire.
+        uint8_t power = n1 | n2 | n3;
+        uint16_t gate = 0xffff;
+        if (!(power & 0x0f)) gate &= ~g->f3;
+        if (!(power & 0xf0)) gate &= ~g->f5;
+        const uint16_t *base = g->base[j == PRINTSPIDER_PACKETS - 1];
+        // A data line is driven high for a bit that is not set.
+        n1 = ~n1;
+        n2 = ~n2;
+        n3 = ~n3;
+        for (; p < g->len; p++) {
+            uint16_t v = base[p] & gate;
+            uint8_t bit = g->bit[p];
+            if (n1 & bit) v |= g->data[0];
+            if (n2 & bit) v |= g->data[1];
+            if (n3 & bit) v |= g->data[2];
+            w[p] = v;
+        }
+    }
+    for (; p < len; p++) w[p] = 0;
+    return len;
+}
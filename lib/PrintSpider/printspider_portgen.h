@@ -0,0 +1,71 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef PRINTSPIDER_PORTGEN_H
+#define PRINTSPIDER_PORTGEN_H
+
+#include <stdint.h>
+
+#include "printspider.h"
+#include "printspider_port.h"
+
+/*
+Generation of data packets straight as port pairs (see printspider_port.h), instead of generating waveform
+words and converting them afterwards. The select, clock, CSYNC and power lines of every template step are
+converted once per template; a packet then only has to gate the power lines and OR in the port bits of the
+data lines D1..D3 for every step, which saves the three table lookups per word of the conversion and the
+flash reads of the steps.
+
+The output is identical to printspider_waveform_next_packet followed by printspider_portmap_convert, so the
+output stage writes the same words either way. The data lines still have to be shifted by software: the
+cartridge takes a data bit on both edges of DCLK, with the select lines changing between the bits, which no
+hardware shift register of the AVR can produce.
+*/
+
+//Template steps room, must be at least the template length
+#ifndef PRINTSPIDER_PORTGEN_STEPS
+#define PRINTSPIDER_PORTGEN_STEPS 32
+#endif
+
+typedef struct printspider_portgen_t {
+	// Template steps the tables were built from, NULL if none.
+	const printspider_waveform_step_t *steps;
+	uint8_t len;
+	// Port pair of every step for a normal ([0]) and for the last ([1]) packet, power lines included.
+	uint16_t base[2][PRINTSPIDER_PORTGEN_STEPS];
+	// Nozzle data bit sent in every step, 0 for none.
+	uint8_t bit[PRINTSPIDER_PORTGEN_STEPS];
+	// Port pair bits of the data lines D1, D2, D3 and of the power lines F3 and F5.
+	uint16_t data[3];
+	uint16_t f3;
+	uint16_t f5;
+} printspider_portgen_t;
+
+/*
+Build the tables in `g` for the `len` precomputed template steps `steps`, with the port map `m`. Returns 0, or
+-1 if there are no steps or more than PRINTSPIDER_PORTGEN_STEPS; `g` is left unusable then.
+*/
+int printspider_portgen_init(printspider_portgen_t *g, const printspider_portmap_t *m,
+	const printspider_waveform_step_t *steps, int len);
+
+/*
+Same as printspider_waveform_next_packet, but puts port pairs in `w`. The cursor must be for the steps `g`
+was built from.
+*/
+int printspider_portgen_next_packet(const printspider_portgen_t *g, printspider_waveform_cursor_t *c,
+	uint16_t *w);
+
+#endif
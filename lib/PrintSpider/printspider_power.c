@@ -0,0 +1,128 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Limiting the nozzles fired at once per power line.
+#include "printspider_power.h"
+
+#include <string.h>
+
+static const uint8_t nibble_bits[16] = {0, 1, 1, 2, 1, 2, 2, 3,
+                                        1, 2, 2, 3, 2, 3, 3, 4};
+
+// Nozzles set in power group `shift` (0 for F3, 4 for F5) of packet `j`.
+static uint8_t group_count(const uint8_t *nozdata, uint8_t j, uint8_t shift) {
+    return nibble_bits[(nozdata[j] >> shift) & 0x0f] +
+           nibble_bits[(nozdata[14 + j] >> shift) & 0x0f] +
+           nibble_bits[(nozdata[28 + j] >> shift) & 0x0f];
+}
+
+// Moves up to `left` nozzles of a power group from `from` to `out`, starting
+// at nozzle `start` of the group. Returns the amount moved.
+static uint8_t move_group(uint8_t *from, uint8_t *out, uint8_t j,
+                          uint8_t shift, uint8_t left, uint8_t start) {
+    uint8_t n = group_count(from, j, shift);
+    if (n <= left) {
+        for (uint8_t line = 0; line < 3; line++) {
+            uint8_t m = from[line * 14 + j] & (0x0f << shift);
+            out[line * 14 + j] |= m;
+            from[line * 14 + j] &= ~m;
+        }
+        return n;
+    }
+    uint8_t moved = 0;
+    uint8_t idx = start;
+    for (uint8_t k = 0; k < PRINTSPIDER_POWER_GROUP_NOZZLES && moved < left;
+         k++) {
+        uint8_t i = (idx >> 2) * 14 + j;
+        uint8_t bit = 1 << ((idx & 3) + shift);
+        if (from[i] & bit) {
+            from[i] &= ~bit;
+            out[i] |= bit;
+            moved++;
+        }
+        if (++idx == PRINTSPIDER_POWER_GROUP_NOZZLES) idx = 0;
+    }
+    return moved;
+}
+
+static uint16_t count_all(const uint8_t *nozdata) {
+    uint16_t n = 0;
+    for (uint8_t i = 0; i < PRINTSPIDER_NOZDATA_SZ; i++) {
+        n += nibble_bits[nozdata[i] & 0x0f] + nibble_bits[nozdata[i] >> 4];
+    }
+    return n;
+}
+
+static void row_done(printspider_power_t *p, uint16_t left) {
+    p->rows++;
+    if (left) {
+        p->deferred_rows++;
+        p->deferred_nozzles += left;
+    }
+    if (++p->start == PRINTSPIDER_POWER_GROUP_NOZZLES) p->start = 0;
+}
+
+void printspider_power_init(printspider_power_t *p, uint8_t budget) {
+    memset(p, 0, sizeof(*p));
+    p->budget = budget;
+}
+
+uint16_t printspider_power_limit(printspider_power_t *p, uint8_t *nozdata,
+                                 uint8_t *out) {
+    for (uint8_t j = 0; j < PRINTSPIDER_PACKETS; j++) {
+        for (uint8_t shift = 0; shift <= 4; shift += 4) {
+            uint8_t left = p->budget;
+            // Deferred nozzles go first, so they are late as little as possible.
+            if (p->carried) {
+                left -= move_group(p->carry, out, j, shift, left, p->start);
+            }
+            // A nozzle fires once per row, one fired for the last row waits
+            // with its new drop for the next one.
+            uint8_t held[3];
+            for (uint8_t line = 0; line < 3; line++) {
+                uint8_t i = line * 14 + j;
+                held[line] = nozdata[i] & out[i] & (0x0f << shift);
+                nozdata[i] &= ~held[line];
+            }
+            move_group(nozdata, out, j, shift, left, p->start);
+            for (uint8_t line = 0; line < 3; line++) {
+                nozdata[line * 14 + j] |= held[line];
+            }
+        }
+    }
+    // A nozzle deferred twice in a row is fired once, the other drop is lost.
+    for (uint8_t i = 0; i < PRINTSPIDER_NOZDATA_SZ; i++) {
+        uint8_t both = p->carry[i] & nozdata[i];
+        p->dropped_nozzles += nibble_bits[both & 0x0f] + nibble_bits[both >> 4];
+        p->carry[i] |= nozdata[i];
+    }
+    p->carried = count_all(p->carry);
+    row_done(p, p->carried);
+    return p->carried;
+}
+
+uint16_t printspider_power_take(printspider_power_t *p, uint8_t *pending,
+                                uint8_t *out) {
+    uint16_t left = 0;
+    for (uint8_t j = 0; j < PRINTSPIDER_PACKETS; j++) {
+        for (uint8_t shift = 0; shift <= 4; shift += 4) {
+            uint8_t n = group_count(pending, j, shift);
+            left += n - move_group(pending, out, j, shift, p->budget, p->start);
+        }
+    }
+    row_done(p, left);
+    return left;
+}
@@ -0,0 +1,86 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef PRINTSPIDER_POWER_H
+#define PRINTSPIDER_POWER_H
+
+#include <stdint.h>
+
+#include "printspider.h"
+
+/*
+Power budget scheduler. The nozzles of a data packet are powered in two groups: data bits 0..3 of the
+three data lines by the F3 pulse and bits 4..7 by the F5 pulse (see printspider_generate_waveform), so
+one packet fires up to 12 nozzles per power line at the same time. The scheduler limits the nozzles
+fired per packet and power group to a budget, and fires the rest later, either:
+- with the following rows (printspider_power_limit): the deferred nozzles are fired first in the next
+  row, so the rows keep their rate and a drop lands a row or, in long dense areas, a few rows late, or
+- in extra sub-passes of the same row (printspider_power_take): every drop lands in place, the row takes
+  more time.
+Which nozzles of a group are fired first rotates from row to row, so no nozzle is always deferred.
+
+With printspider_power_limit a nozzle that is requested again while it is still deferred fires once for
+both, so areas denser than the budget lose drops: a solid black area under a budget of 6 fires 6 of 12
+nozzles per group and row. The lost drops are counted in dropped_nozzles.
+*/
+
+//Nozzles in one power group of a packet
+#define PRINTSPIDER_POWER_GROUP_NOZZLES 12
+
+typedef struct printspider_power_t {
+	// Nozzles fired at most per packet and power group.
+	uint8_t budget;
+	// First nozzle of a group to consider, rotates every row.
+	uint8_t start;
+	// Nozzles deferred to the next row by printspider_power_limit.
+	uint8_t carry[PRINTSPIDER_NOZDATA_SZ];
+	uint16_t carried;
+	// Rows (or sub-passes) sent, rows that left nozzles for later and the amount of nozzles left.
+	uint16_t rows;
+	uint16_t deferred_rows;
+	uint16_t deferred_nozzles;
+	// Nozzles requested again while still deferred by printspider_power_limit, fired once for both.
+	uint16_t dropped_nozzles;
+} printspider_power_t;
+
+/*
+Initialize `p` with a budget of `budget` nozzles per packet and power group, 1 to
+PRINTSPIDER_POWER_GROUP_NOZZLES. The full group size disables the limit.
+*/
+void printspider_power_init(printspider_power_t *p, uint8_t budget);
+
+/*
+Fill the cleared nozzle data `out` with the nozzles deferred from the last row, then with the nozzles of
+`nozdata`, within the budget. The nozzles that don't fit are deferred to the next call. `nozdata` is
+consumed. Returns the amount of deferred nozzles.
+*/
+uint16_t printspider_power_limit(printspider_power_t *p, uint8_t *nozdata, uint8_t *out);
+
+/*
+Move nozzles from `pending` to the cleared nozzle data `out`, within the budget. Returns the amount of
+nozzles left in `pending`; call again with a new `out` until it returns 0.
+*/
+uint16_t printspider_power_take(printspider_power_t *p, uint8_t *pending, uint8_t *out);
+
+/*
+Return the amount of nozzles deferred by printspider_power_limit. After the last row, keep calling it
+with empty rows until this is 0.
+*/
+static inline uint16_t printspider_power_pending(const printspider_power_t *p) {
+	return p->carried;
+}
+
+#endif
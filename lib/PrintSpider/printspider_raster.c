@@ -0,0 +1,293 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Rasterizing of text and barcodes one image line at a time.
+#include "printspider_raster.h"
+
+#include "printspider_pgm.h"
+
+#define FONT_FIRST ' '
+#define FONT_LAST '~'
+#define FONT_COLUMNS 5
+#define FONT_ROWS 7
+
+// 5x7 font of ASCII 32..126, one byte per column with the top pixel in bit 0.
+static const uint8_t font[FONT_LAST - FONT_FIRST + 1][FONT_COLUMNS] PROGMEM = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5f, 0x00, 0x00},
+    {0x00, 0x07, 0x00, 0x07, 0x00}, {0x14, 0x7f, 0x14, 0x7f, 0x14},
+    {0x24, 0x2a, 0x7f, 0x2a, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62},
+    {0x36, 0x49, 0x55, 0x22, 0x50}, {0x00, 0x05, 0x03, 0x00, 0x00},
+    {0x00, 0x1c, 0x22, 0x41, 0x00}, {0x00, 0x41, 0x22, 0x1c, 0x00},
+    {0x14, 0x08, 0x3e, 0x08, 0x14}, {0x08, 0x08, 0x3e, 0x08, 0x08},
+    {0x00, 0x50, 0x30, 0x00, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08},
+    {0x00, 0x60, 0x60, 0x00, 0x00}, {0x20, 0x10, 0x08, 0x04, 0x02},
+    {0x3e, 0x51, 0x49, 0x45, 0x3e}, {0x00, 0x42, 0x7f, 0x40, 0x00},
+    {0x42, 0x61, 0x51, 0x49, 0x46}, {0x21, 0x41, 0x45, 0x4b, 0x31},
+    {0x18, 0x14, 0x12, 0x7f, 0x10}, {0x27, 0x45, 0x45, 0x45, 0x39},
+    {0x3c, 0x4a, 0x49, 0x49, 0x30}, {0x01, 0x71, 0x09, 0x05, 0x03},
+    {0x36, 0x49, 0x49, 0x49, 0x36}, {0x06, 0x49, 0x49, 0x29, 0x1e},
+    {0x00, 0x36, 0x36, 0x00, 0x00}, {0x00, 0x56, 0x36, 0x00, 0x00},
+    {0x08, 0x14, 0x22, 0x41, 0x00}, {0x14, 0x14, 0x14, 0x14, 0x14},
+    {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x51, 0x09, 0x06},
+    {0x32, 0x49, 0x79, 0x41, 0x3e}, {0x7e, 0x11, 0x11, 0x11, 0x7e},
+    {0x7f, 0x49, 0x49, 0x49, 0x36}, {0x3e, 0x41, 0x41, 0x41, 0x22},
+    {0x7f, 0x41, 0x41, 0x22, 0x1c}, {0x7f, 0x49, 0x49, 0x49, 0x41},
+    {0x7f, 0x09, 0x09, 0x09, 0x01}, {0x3e, 0x41, 0x49, 0x49, 0x7a},
+    {0x7f, 0x08, 0x08, 0x08, 0x7f}, {0x00, 0x41, 0x7f, 0x41, 0x00},
+    {0x20, 0x40, 0x41, 0x3f, 0x01}, {0x7f, 0x08, 0x14, 0x22, 0x41},
+    {0x7f, 0x40, 0x40, 0x40, 0x40}, {0x7f, 0x02, 0x0c, 0x02, 0x7f},
+    {0x7f, 0x04, 0x08, 0x10, 0x7f}, {0x3e, 0x41, 0x41, 0x41, 0x3e},
+    {0x7f, 0x09, 0x09, 0x09, 0x06}, {0x3e, 0x41, 0x51, 0x21, 0x5e},
+    {0x7f, 0x09, 0x19, 0x29, 0x46}, {0x46, 0x49, 0x49, 0x49, 0x31},
+    {0x01, 0x01, 0x7f, 0x01, 0x01}, {0x3f, 0x40, 0x40, 0x40, 0x3f},
+    {0x1f, 0x20, 0x40, 0x20, 0x1f}, {0x3f, 0x40, 0x38, 0x40, 0x3f},
+    {0x63, 0x14, 0x08, 0x14, 0x63}, {0x07, 0x08, 0x70, 0x08, 0x07},
+    {0x61, 0x51, 0x49, 0x45, 0x43}, {0x00, 0x7f, 0x41, 0x41, 0x00},
+    {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x7f, 0x00},
+    {0x04, 0x02, 0x01, 0x02, 0x04}, {0x40, 0x40, 0x40, 0x40, 0x40},
+    {0x00, 0x01, 0x02, 0x04, 0x00}, {0x20, 0x54, 0x54, 0x54, 0x78},
+    {0x7f, 0x48, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x20},
+    {0x38, 0x44, 0x44, 0x48, 0x7f}, {0x38, 0x54, 0x54, 0x54, 0x18},
+    {0x08, 0x7e, 0x09, 0x01, 0x02}, {0x0c, 0x52, 0x52, 0x52, 0x3e},
+    {0x7f, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7d, 0x40, 0x00},
+    {0x20, 0x40, 0x44, 0x3d, 0x00}, {0x7f, 0x10, 0x28, 0x44, 0x00},
+    {0x00, 0x41, 0x7f, 0x40, 0x00}, {0x7c, 0x04, 0x18, 0x04, 0x78},
+    {0x7c, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38},
+    {0x7c, 0x14, 0x14, 0x14, 0x08}, {0x08, 0x14, 0x14, 0x18, 0x7c},
+    {0x7c, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x20},
+    {0x04, 0x3f, 0x44, 0x40, 0x20}, {0x3c, 0x40, 0x40, 0x20, 0x7c},
+    {0x1c, 0x20, 0x40, 0x20, 0x1c}, {0x3c, 0x40, 0x30, 0x40, 0x3c},
+    {0x44, 0x28, 0x10, 0x28, 0x44}, {0x0c, 0x50, 0x50, 0x50, 0x3c},
+    {0x44, 0x64, 0x54, 0x4c, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00},
+    {0x00, 0x00, 0x7f, 0x00, 0x00}, {0x00, 0x41, 0x36, 0x08, 0x00},
+    {0x10, 0x08, 0x08, 0x10, 0x08},
+};
+
+#define CODE128_MODULES 11
+#define CODE128_QUIET 10
+#define CODE128_SHIFT_C 99
+#define CODE128_SHIFT_B 100
+#define CODE128_START_B 104
+#define CODE128_START_C 105
+#define CODE128_STOP 0x18eb
+#define CODE128_STOP_MODULES 13
+
+// Modules of the Code128 symbols 0..105, first one in bit 10, set for bars.
+static const uint16_t code128[106] PROGMEM = {
+    0x6cc, 0x66c, 0x666, 0x498, 0x48c, 0x44c, 0x4c8, 0x4c4, 0x464, 0x648,
+    0x644, 0x624, 0x59c, 0x4dc, 0x4ce, 0x5cc, 0x4ec, 0x4e6, 0x672, 0x65c,
+    0x64e, 0x6e4, 0x674, 0x76e, 0x74c, 0x72c, 0x726, 0x764, 0x734, 0x732,
+    0x6d8, 0x6c6, 0x636, 0x518, 0x458, 0x446, 0x588, 0x468, 0x462, 0x688,
+    0x628, 0x622, 0x5b8, 0x58e, 0x46e, 0x5d8, 0x5c6, 0x476, 0x776, 0x68e,
+    0x62e, 0x6e8, 0x6e2, 0x6ee, 0x758, 0x746, 0x716, 0x768, 0x762, 0x71a,
+    0x77a, 0x642, 0x78a, 0x530, 0x50c, 0x4b0, 0x486, 0x42c, 0x426, 0x590,
+    0x584, 0x4d0, 0x4c2, 0x434, 0x432, 0x612, 0x650, 0x7ba, 0x614, 0x47a,
+    0x53c, 0x4bc, 0x49e, 0x5e4, 0x4f4, 0x4f2, 0x7a4, 0x794, 0x792, 0x6de,
+    0x6f6, 0x7b6, 0x578, 0x51e, 0x45e, 0x5e8, 0x5e2, 0x7a8, 0x7a2, 0x5de,
+    0x5ee, 0x75e, 0x7ae, 0x684, 0x690, 0x69c,
+};
+
+// Parts of a Code128 barcode, in drawing order.
+enum code128_stage_en {
+    STAGE_QUIET_START,
+    STAGE_START,
+    STAGE_DATA,
+    STAGE_STOP,
+    STAGE_QUIET_END,
+    STAGE_DONE
+};
+
+enum code128_set_en { SET_B, SET_C };
+
+// Sets pixels start..start + n - 1 of a packed line, up to width.
+static void fill(uint8_t *bits, int width, int start, int n) {
+    int end = start + n;
+    if (end > width) end = width;
+    if (start >= end) return;
+    int first = start >> 3;
+    int last = (end - 1) >> 3;
+    uint8_t head = 0xff >> (start & 7);
+    uint8_t tail = 0xff << (7 - ((end - 1) & 7));
+    if (first == last) {
+        bits[first] |= head & tail;
+        return;
+    }
+    bits[first] |= head;
+    for (int i = first + 1; i < last; i++) {
+        bits[i] = 0xff;
+    }
+    bits[last] |= tail;
+}
+
+// Moves to the next font column of the text, returns 0 at the end.
+static int next_text_column(printspider_raster_t *r) {
+    if (r->stage < FONT_COLUMNS - 1) {
+        r->stage++;
+    } else if (r->stage == FONT_COLUMNS - 1) {
+        // The blank column goes only between characters.
+        if (!r->text[r->pos]) return 0;
+        r->stage = FONT_COLUMNS;
+        r->column = 0;
+        return 1;
+    } else {
+        if (!r->text[r->pos]) return 0;
+        r->pos++;
+        r->stage = 0;
+    }
+    uint8_t c = r->text[r->pos - 1];
+    if (c < FONT_FIRST || c > FONT_LAST) c = '?';
+    r->column = pgm_read_byte(&font[c - FONT_FIRST][r->stage]);
+    return 1;
+}
+
+// Length of the run of digits at the start of s, up to 255.
+static uint8_t count_digits(const char *s) {
+    uint8_t n = 0;
+    while (n < 255 && s[n] >= '0' && s[n] <= '9') n++;
+    return n;
+}
+
+// Returns the next data symbol of the text, switching code sets on the way,
+// or -1 at the end of the text.
+static int next_data_symbol(printspider_raster_t *r) {
+    const char *s = &r->text[r->pos];
+    if (!*s) return -1;
+    if (r->set == SET_C) {
+        if (r->digits >= 2) {
+            r->pos += 2;
+            r->digits -= 2;
+            return (s[0] - '0') * 10 + (s[1] - '0');
+        }
+        r->set = SET_B;
+        return CODE128_SHIFT_B;
+    }
+    if (!r->digits) r->digits = count_digits(s);
+    // An odd digit goes in code set B first, so the rest pair up.
+    if (r->digits >= 4 && !(r->digits & 1)) {
+        r->set = SET_C;
+        return CODE128_SHIFT_C;
+    }
+    if (r->digits) r->digits--;
+    r->pos++;
+    uint8_t c = *s;
+    if (c < ' ' || c > 127) c = '?';
+    return c - ' ';
+}
+
+// Loads the modules of the next part of the barcode, returns 0 at the end.
+static int next_symbol(printspider_raster_t *r) {
+    int value;
+    switch (r->stage) {
+        case STAGE_QUIET_START:
+            r->pattern = 0;
+            r->bits = CODE128_QUIET;
+            r->stage = STAGE_START;
+            return 1;
+        case STAGE_START:
+            value = r->set == SET_C ? CODE128_START_C : CODE128_START_B;
+            r->checksum = value % 103;
+            r->weight = 1;
+            r->stage = STAGE_DATA;
+            break;
+        case STAGE_DATA:
+            value = next_data_symbol(r);
+            if (value < 0) {
+                value = r->checksum;
+                r->stage = STAGE_STOP;
+            } else {
+                r->checksum = (r->checksum + r->weight * value) % 103;
+                r->weight = (r->weight + 1) % 103;
+            }
+            break;
+        case STAGE_STOP:
+            r->pattern = CODE128_STOP;
+            r->bits = CODE128_STOP_MODULES;
+            r->stage = STAGE_QUIET_END;
+            return 1;
+        case STAGE_QUIET_END:
+            r->pattern = 0;
+            r->bits = CODE128_QUIET;
+            r->stage = STAGE_DONE;
+            return 1;
+        default:
+            return 0;
+    }
+    r->pattern = pgm_read_word(&code128[value]);
+    r->bits = CODE128_MODULES;
+    return 1;
+}
+
+// Moves to the next module of the barcode, returns 0 at the end.
+static int next_module(printspider_raster_t *r) {
+    if (!r->bits && !next_symbol(r)) return 0;
+    r->bits--;
+    r->column = (r->pattern >> r->bits) & 1;
+    return 1;
+}
+
+static void raster_init(printspider_raster_t *r, const char *text, int kind,
+                        int y, uint8_t height, uint8_t scale) {
+    r->text = text;
+    r->kind = kind;
+    r->y = y;
+    r->height = height;
+    r->scale = scale ? scale : 1;
+    r->pos = 0;
+    r->column = 0;
+    r->repeat = 0;
+    r->stage = 0;
+    r->pattern = 0;
+    r->bits = 0;
+    r->set = SET_B;
+    r->checksum = 0;
+    r->weight = 0;
+    r->digits = 0;
+}
+
+void printspider_raster_text(printspider_raster_t *r, const char *text, int y,
+                             uint8_t scale) {
+    raster_init(r, text, PRINTSPIDER_RASTER_TEXT, y, FONT_ROWS * scale, scale);
+    // Starts as if after a blank column, to load the first character.
+    r->stage = FONT_COLUMNS;
+}
+
+void printspider_raster_code128(printspider_raster_t *r, const char *text,
+                                int y, uint8_t height, uint8_t module) {
+    raster_init(r, text, PRINTSPIDER_RASTER_CODE128, y, height, module);
+    r->stage = STAGE_QUIET_START;
+    r->digits = count_digits(text);
+    if (r->digits >= 4 && !(r->digits & 1)) r->set = SET_C;
+}
+
+int printspider_raster_next_line(printspider_raster_t *r, uint8_t *bits,
+                                 int width) {
+    if (!r->repeat) {
+        int more = r->kind == PRINTSPIDER_RASTER_TEXT ? next_text_column(r)
+                                                      : next_module(r);
+        if (!more) return 0;
+        r->repeat = r->scale;
+    }
+    r->repeat--;
+    if (r->kind == PRINTSPIDER_RASTER_TEXT) {
+        uint8_t column = r->column;
+        for (int y = r->y; column; column >>= 1, y += r->scale) {
+            if (column & 1) fill(bits, width, y, r->scale);
+        }
+    } else if (r->column) {
+        fill(bits, width, r->y, r->height);
+    }
+    return 1;
+}
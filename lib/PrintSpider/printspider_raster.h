@@ -0,0 +1,91 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef PRINTSPIDER_RASTER_H
+#define PRINTSPIDER_RASTER_H
+
+#include <stdint.h>
+
+/*
+Rasterizer of text and Code128 barcodes for labels, date codes and lot numbers. Instead of drawing into an
+image, it makes the packed 1-bit image lines (see PRINTSPIDER_ROW_BIT) one at a time in print order, ready
+for printspider_swath_push or printspider_set_row_black / printspider_set_row_color, so the content can
+change from one label to the next and needs no memory besides the line. Pixel 0 of a line is the first
+nozzle of the row; a line is one firing, so text and bars run along the print direction.
+
+Text is drawn with a 5x7 ASCII font in flash, every font pixel `scale` nozzles high and `scale` lines wide,
+with one blank font column between characters. Code128 barcodes use code set B for text and switch to code
+set C for runs of 4 or more digits, which takes half the width for numbers. The symbol has quiet zones of
+10 modules on both ends; every module is `module` lines wide and the bars are `height` nozzles high.
+
+Every line costs at most a few operations per set pixel or per byte of a bar; a barcode looks at the text
+only at the start of a symbol, every 11 modules.
+*/
+
+enum printspider_raster_kind_en {
+	PRINTSPIDER_RASTER_TEXT = 0,
+	PRINTSPIDER_RASTER_CODE128 = 1
+};
+
+typedef struct printspider_raster_t {
+	// Characters, must stay unchanged until the drawing is finished.
+	const char *text;
+	uint8_t kind;
+	// First pixel and height in pixels of the drawing, and lines per font column or module.
+	uint8_t y;
+	uint8_t height;
+	uint8_t scale;
+	// Next character of the text.
+	uint8_t pos;
+	// Pixels of the current font column, first one in bit 0, or 1 for a bar and 0 for a space.
+	uint8_t column;
+	// Lines left of the current column or module.
+	uint8_t repeat;
+	// Text: font column of the current character, 5 for the blank one. Code128: part of the symbol being
+	// drawn.
+	uint8_t stage;
+	// Code128: modules of the current symbol and the count of them left, the next one is bit bits - 1.
+	uint16_t pattern;
+	uint8_t bits;
+	// Code128: code set, checksum and weight of the next symbol, both modulo 103.
+	uint8_t set;
+	uint8_t checksum;
+	uint8_t weight;
+	// Code128: digits from pos on, counted at the start of a run.
+	uint8_t digits;
+} printspider_raster_t;
+
+/*
+Start drawing the zero terminated `text` with its top at pixel `y` and font pixels of `scale` x `scale`.
+The text takes 7 * `scale` pixels and (6 * characters - 1) * `scale` lines.
+*/
+void printspider_raster_text(printspider_raster_t *r, const char *text, int y, uint8_t scale);
+
+/*
+Start drawing `text` as a Code128 barcode with bars from pixel `y` on, `height` pixels high, and `module`
+lines per module. Characters outside of code set B are drawn as '?'.
+*/
+void printspider_raster_code128(printspider_raster_t *r, const char *text, int y, uint8_t height,
+	uint8_t module);
+
+/*
+Set the pixels of the next line of the drawing in the packed line `bits` of `width` pixels, leaving the
+other pixels as they are; pixels past `width` are dropped. Several drawings can be combined on one line
+this way. Returns 1, or 0 when the drawing is finished and the line was left unchanged.
+*/
+int printspider_raster_next_line(printspider_raster_t *r, uint8_t *bits, int width);
+
+#endif
@@ -0,0 +1,122 @@
+// Generated by tools/gen_waveform_steps.py from the templates in
+// printspider.c. Do not edit.
+
+static const printspider_waveform_step_t tpl_color_a_steps[] PROGMEM = {
+    {{0x0000, 0x0000}, 0x00},
+    {{0xc008, 0xc008}, 0x01},
+    {{0xc108, 0xc108}, 0x01},
+    {{0xc148, 0xc148}, 0x02},
+    {{0x0040, 0x0040}, 0x02},
+    {{0x4000, 0x4008}, 0x04},
+    {{0x4100, 0x4108}, 0x04},
+    {{0x4110, 0x4118}, 0x08},
+    {{0x0010, 0x0010}, 0x08},
+    {{0x4000, 0x4008}, 0x10},
+    {{0x4100, 0x4108}, 0x10},
+    {{0x4300, 0x4308}, 0x20},
+    {{0x0600, 0x0600}, 0x20},
+    {{0x4400, 0x4408}, 0x40},
+    {{0x4500, 0x4508}, 0x40},
+    {{0x4520, 0x4528}, 0x80},
+    {{0x0420, 0x0420}, 0x80},
+    {{0x0400, 0x0400}, 0x80},
+    {{0x4000, 0x4008}, 0x00},
+    {{0x4000, 0x4008}, 0x00},
+    {{0x4080, 0x4088}, 0x00},
+    {{0x0880, 0x0880}, 0x00},
+    {{0x0800, 0x0800}, 0x00},
+    {{0x0800, 0x0800}, 0x00},
+    {{0x0800, 0x0800}, 0x00},
+    {{0x0800, 0x0800}, 0x00},
+    {{0x0800, 0x0800}, 0x00},
+};
+
+static const printspider_waveform_step_t tpl_color_b_steps[] PROGMEM = {
+    {{0x0000, 0x0000}, 0x00},
+    {{0xc008, 0xc008}, 0x00},
+    {{0xc108, 0xc108}, 0x01},
+    {{0xc148, 0xc148}, 0x01},
+    {{0x0040, 0x0040}, 0x02},
+    {{0x0000, 0x0000}, 0x02},
+    {{0x4100, 0x4108}, 0x04},
+    {{0x4110, 0x4118}, 0x04},
+    {{0x0010, 0x0010}, 0x08},
+    {{0x4000, 0x4008}, 0x08},
+    {{0x4100, 0x4108}, 0x10},
+    {{0x4300, 0x4308}, 0x10},
+    {{0x0600, 0x0600}, 0x20},
+    {{0x4400, 0x4408}, 0x20},
+    {{0x4500, 0x4508}, 0x40},
+    {{0x4520, 0x4528}, 0x40},
+    {{0x0420, 0x0420}, 0x80},
+    {{0x0400, 0x0400}, 0x80},
+    {{0x4000, 0x4008}, 0x00},
+    {{0x4000, 0x4008}, 0x00},
+    {{0x4080, 0x4088}, 0x00},
+    {{0x0880, 0x0880}, 0x00},
+    {{0x0800, 0x0800}, 0x00},
+    {{0x0800, 0x0800}, 0x00},
+    {{0x0800, 0x0800}, 0x00},
+    {{0x0800, 0x0800}, 0x00},
+    {{0x0800, 0x0800}, 0x00},
+};
+
+static const printspider_waveform_step_t tpl_black_a_steps[] PROGMEM = {
+    {{0x0000, 0x0000}, 0x00},
+    {{0xc008, 0xc008}, 0x01},
+    {{0xc108, 0xc108}, 0x01},
+    {{0xc148, 0xc148}, 0x02},
+    {{0x0040, 0x0040}, 0x02},
+    {{0xc008, 0xc008}, 0x04},
+    {{0xc108, 0xc108}, 0x04},
+    {{0xc118, 0xc118}, 0x08},
+    {{0x0010, 0x0010}, 0x08},
+    {{0x4000, 0x4008}, 0x10},
+    {{0x4100, 0x4108}, 0x10},
+    {{0x4300, 0x4308}, 0x20},
+    {{0x0600, 0x0600}, 0x20},
+    {{0x0400, 0x0400}, 0x40},
+    {{0x0500, 0x0500}, 0x40},
+    {{0x0520, 0x0520}, 0x80},
+    {{0x0420, 0x0420}, 0x80},
+    {{0x0400, 0x0400}, 0x80},
+    {{0x4000, 0x4008}, 0x00},
+    {{0x4000, 0x4008}, 0x00},
+    {{0x4080, 0x4088}, 0x00},
+    {{0x0880, 0x0880}, 0x00},
+    {{0x0800, 0x0800}, 0x00},
+    {{0x0800, 0x0800}, 0x00},
+    {{0x0800, 0x0800}, 0x00},
+    {{0x0800, 0x0800}, 0x00},
+    {{0x0800, 0x0800}, 0x00},
+};
+
+static const printspider_waveform_step_t tpl_black_b_steps[] PROGMEM = {
+    {{0x0000, 0x0000}, 0x00},
+    {{0xc008, 0xc008}, 0x00},
+    {{0xc108, 0xc108}, 0x01},
+    {{0xc148, 0xc148}, 0x01},
+    {{0x0040, 0x0040}, 0x02},
+    {{0x0000, 0x0000}, 0x02},
+    {{0xc108, 0xc108}, 0x04},
+    {{0xc118, 0xc118}, 0x04},
+    {{0x0010, 0x0010}, 0x08},
+    {{0x4000, 0x4008}, 0x08},
+    {{0x4100, 0x4108}, 0x10},
+    {{0x4300, 0x4308}, 0x10},
+    {{0x0600, 0x0600}, 0x20},
+    {{0x0400, 0x0400}, 0x20},
+    {{0x0500, 0x0500}, 0x40},
+    {{0x0520, 0x0520}, 0x40},
+    {{0x0420, 0x0420}, 0x80},
+    {{0x0400, 0x0400}, 0x80},
+    {{0x4000, 0x4008}, 0x80},
+    {{0x4000, 0x4008}, 0x00},
+    {{0x4080, 0x4088}, 0x00},
+    {{0x0880, 0x0880}, 0x00},
+    {{0x0800, 0x0800}, 0x00},
+    {{0x0800, 0x0800}, 0x00},
+    {{0x0800, 0x0800}, 0x00},
+    {{0x0800, 0x0800}, 0x00},
+    {{0x0800, 0x0800}, 0x00},
+};
@@ -0,0 +1,130 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Assembling firings from image lines for cartridges with offset nozzle rows.
+#include "printspider_swath.h"
+
+#include <string.h>
+
+// A channel delayed by k > 0 offsets has a ring of k * offset lines, the
+// rings one after another.
+static uint8_t *delay_ring(const printspider_swath_t *s, uint8_t k) {
+    // Rings of delays 1..k-1 take (1 + ... + k-1) * offset lines.
+    return s->buffer + (k * (k - 1) / 2) * s->offset * s->row_bytes;
+}
+
+static void set_row(const printspider_swath_t *s, uint8_t *nozdata,
+                    const uint8_t *bits, uint8_t c) {
+    if (s->black) {
+        printspider_set_row_black(nozdata, bits, c);
+    } else {
+        printspider_set_row_color(nozdata, bits, c);
+    }
+}
+
+static void swath_init(printspider_swath_t *s, uint8_t *buffer, uint8_t black,
+                       uint8_t channels, uint8_t row_bytes, uint8_t offset) {
+    s->buffer = buffer;
+    s->black = black;
+    s->channels = channels;
+    s->row_bytes = row_bytes;
+    s->offset = offset;
+    s->reverse = 0;
+    s->redundant = 0;
+    s->dead = NULL;
+    printspider_swath_reset(s);
+}
+
+void printspider_swath_init_color(printspider_swath_t *s, uint8_t *buffer) {
+    swath_init(s, buffer, 0, 3, PRINTSPIDER_COLOR_ROW_BYTES,
+               PRINTSPIDER_COLOR_ROW_OFFSET);
+}
+
+void printspider_swath_init_black(printspider_swath_t *s, uint8_t *buffer) {
+    swath_init(s, buffer, 1, 2, PRINTSPIDER_BLACK_ROW_BYTES,
+               PRINTSPIDER_BLACK_ROW_OFFSET);
+}
+
+void printspider_swath_reset(printspider_swath_t *s) {
+    memset(s->buffer, 0, (s->channels * (s->channels - 1) / 2) * s->offset *
+                             s->row_bytes);
+    s->pos = 0;
+    s->pending = 0;
+    s->phase = 0;
+}
+
+void printspider_swath_set_reverse(printspider_swath_t *s, uint8_t reverse) {
+    s->reverse = reverse;
+    printspider_swath_reset(s);
+}
+
+void printspider_swath_set_redundant(printspider_swath_t *s, uint8_t redundant,
+                                    const uint8_t *dead) {
+    s->redundant = s->black && redundant;
+    s->dead = dead;
+}
+
+// Splits a black image line between both nozzle rows: every dot goes to the
+// row picked by the checkerboard of the line parity, or to the other row if
+// that nozzle failed.
+static void split_line(const printspider_swath_t *s, const uint8_t *line,
+                       uint8_t parts[2][PRINTSPIDER_BLACK_ROW_BYTES]) {
+    uint8_t first = s->phase ? 0x55 : 0xaa;
+    for (uint8_t i = 0; i < PRINTSPIDER_BLACK_ROW_BYTES; i++) {
+        uint8_t dead0 = s->dead ? s->dead[i] : 0;
+        uint8_t dead1 = s->dead ? s->dead[PRINTSPIDER_BLACK_ROW_BYTES + i] : 0;
+        uint8_t pick = ~dead0 & (first | dead1);
+        parts[0][i] = line[i] & pick;
+        parts[1][i] = line[i] & ~pick & ~dead1;
+    }
+}
+
+void printspider_swath_push(printspider_swath_t *s, const uint8_t *line,
+                            uint8_t *nozdata) {
+    uint8_t depth = (s->channels - 1) * s->offset;
+    uint8_t parts[2][PRINTSPIDER_BLACK_ROW_BYTES];
+    if (line && s->redundant) split_line(s, line, parts);
+    for (uint8_t c = 0; c < s->channels; c++) {
+        // The black cartridge prints the same line with both rows, or its
+        // share of it in the redundant mode.
+        const uint8_t *bits =
+            line && !s->black ? line + c * s->row_bytes : line;
+        if (line && s->redundant) bits = parts[c];
+        // Delay of the channel in offsets, mirrored on a reverse pass.
+        uint8_t k = s->reverse ? s->channels - 1 - c : c;
+        if (k == 0) {
+            if (bits) set_row(s, nozdata, bits, c);
+            continue;
+        }
+        // The slot holds the line pushed k * offset lines ago; print it and
+        // put the new line in its place.
+        uint8_t *slot =
+            delay_ring(s, k) + (s->pos % (k * s->offset)) * s->row_bytes;
+        set_row(s, nozdata, slot, c);
+        if (bits) {
+            memcpy(slot, bits, s->row_bytes);
+        } else {
+            memset(slot, 0, s->row_bytes);
+        }
+    }
+    if (++s->pos == depth) s->pos = 0;
+    s->phase ^= 1;
+    if (line) {
+        s->pending = depth;
+    } else if (s->pending) {
+        s->pending--;
+    }
+}
@@ -0,0 +1,127 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef PRINTSPIDER_SWATH_H
+#define PRINTSPIDER_SWATH_H
+
+#include <stdint.h>
+
+#include "printspider.h"
+
+/*
+Swath scheduler. The nozzle rows of a cartridge are offset from each other in the print direction, so
+a single firing prints different image lines with every nozzle row: firing `y` prints line `y` with the
+first nozzle row (cyan, or the first black row), line `y - PRINTSPIDER_COLOR_ROW_OFFSET` with magenta,
+line `y - 2 * PRINTSPIDER_COLOR_ROW_OFFSET` with yellow, and line `y - PRINTSPIDER_BLACK_ROW_OFFSET`
+with the second black row.
+
+The scheduler takes every image line once, as packed 1-bit rows, and keeps the delayed channels of the
+last lines in a circular buffer of PRINTSPIDER_SWATH_COLOR_SZ or PRINTSPIDER_SWATH_BLACK_SZ bytes
+provided by the caller. Every pushed line gives the nozzle data of one firing. After the last image line,
+push empty lines while printspider_swath_pending is not zero to print the rest of the delayed channels.
+
+On a reverse pass the carriage moves the other way and the image lines are pushed last to first. The
+nozzle row that trails on a forward pass leads then, so the delays are mirrored: the last nozzle row
+(yellow, or the second black row) prints the pushed line right away and the first one is delayed the
+most.
+
+The black cartridge normally prints every image line with both of its rows, so every dot gets two drops.
+In the redundant mode (printspider_swath_set_redundant) every dot is fired by only one of the two nozzles
+covering it, alternating between the rows from one line to the next and from one pixel to the next. Every
+nozzle then fires at most every other firing, half the duty at full density, which lets the carriage move
+faster. A map of failed nozzles moves their dots to the nozzle of the other row; dots with both nozzles
+failed are dropped.
+*/
+
+//Buffer size for the color cartridge: magenta is delayed by one offset, yellow by two
+#define PRINTSPIDER_SWATH_COLOR_SZ (3 * PRINTSPIDER_COLOR_ROW_OFFSET * PRINTSPIDER_COLOR_ROW_BYTES)
+
+//Buffer size for the black cartridge: the second row is delayed by one offset
+#define PRINTSPIDER_SWATH_BLACK_SZ (PRINTSPIDER_BLACK_ROW_OFFSET * PRINTSPIDER_BLACK_ROW_BYTES)
+
+//Size of a map of failed black nozzles: packed rows of the first and the second nozzle row
+#define PRINTSPIDER_SWATH_DEAD_SZ (2 * PRINTSPIDER_BLACK_ROW_BYTES)
+
+typedef struct printspider_swath_t {
+	uint8_t *buffer;
+	// 1 for the black cartridge, where both nozzle rows print the same image line.
+	uint8_t black;
+	// Nozzle rows.
+	uint8_t channels;
+	// Bytes in a packed row of one channel.
+	uint8_t row_bytes;
+	// Delay in lines between two nozzle rows.
+	uint8_t offset;
+	// 1 on a reverse pass.
+	uint8_t reverse;
+	// Line counter modulo the longest delay, selects the buffer slots.
+	uint8_t pos;
+	// Firings left until the last pushed image line is printed by all nozzle rows.
+	uint8_t pending;
+	// 1 to split black image lines between both nozzle rows.
+	uint8_t redundant;
+	// Parity of the pushed lines, picks the nozzle row of every dot in the redundant mode.
+	uint8_t phase;
+	// Map of failed nozzles for the redundant mode, or NULL.
+	const uint8_t *dead;
+} printspider_swath_t;
+
+/*
+Initialize `s` for the color cartridge, using `buffer` of PRINTSPIDER_SWATH_COLOR_SZ bytes. Image lines
+are the packed cyan, magenta and yellow rows of PRINTSPIDER_COLOR_ROW_BYTES bytes each, one after another.
+*/
+void printspider_swath_init_color(printspider_swath_t *s, uint8_t *buffer);
+
+/*
+Initialize `s` for the black cartridge, using `buffer` of PRINTSPIDER_SWATH_BLACK_SZ bytes. Image lines
+are packed rows of PRINTSPIDER_BLACK_ROW_BYTES bytes.
+*/
+void printspider_swath_init_black(printspider_swath_t *s, uint8_t *buffer);
+
+/*
+Clear the buffered lines, to start a new image.
+*/
+void printspider_swath_reset(printspider_swath_t *s);
+
+/*
+Set the print direction, `reverse` is 1 for a pass with the carriage moving backwards. Clears the buffered
+lines like printspider_swath_reset, so the previous pass has to be finished first.
+*/
+void printspider_swath_set_reverse(printspider_swath_t *s, uint8_t reverse);
+
+/*
+Turn the redundant mode of the black cartridge on with `redundant` 1, or off. `dead` is NULL or a map of
+PRINTSPIDER_SWATH_DEAD_SZ bytes with the bits of failed nozzles set, the same as image lines of the first
+and the second nozzle row, and must stay unchanged while it is in use. Takes effect with the next pushed
+line; ignored for the color cartridge.
+*/
+void printspider_swath_set_redundant(printspider_swath_t *s, uint8_t redundant, const uint8_t *dead);
+
+/*
+Take the next image line `line`, or an empty line if `line` is NULL, and enable the nozzles of the firing
+it completes in the nozzle data `nozdata`, which should be cleared by the caller.
+*/
+void printspider_swath_push(printspider_swath_t *s, const uint8_t *line, uint8_t *nozdata);
+
+/*
+Return the number of firings needed after the last pushed image line until it has been printed by all
+nozzle rows.
+*/
+static inline uint8_t printspider_swath_pending(const printspider_swath_t *s) {
+	return s->pending;
+}
+
+#endif
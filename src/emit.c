@@ -0,0 +1,155 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "emit.h"
+
+#include <util/atomic.h>
+
+#include "printspider_port.h"
+
+static printspider_portmap_t portmap;
+#ifndef PRINT_DUAL
+static printspider_cache_t cache;
+#ifdef EMIT_DIRECT_PORTS
+static printspider_portgen_t portgen;
+#endif
+#endif
+
+void emit_setup(const uint8_t *bus, uint8_t len) {
+    printspider_portmap_init(&portmap, bus, len);
+#ifdef PRINT_DUAL
+    DDRC |= EMIT_DUAL_MASK;
+    PORTC &= ~EMIT_DUAL_MASK;
+#else
+    printspider_cache_init(&cache, &portmap);
+#ifdef EMIT_DIRECT_PORTS
+    printspider_cache_use_portgen(&cache, &portgen);
+#endif
+#endif
+}
+
+void emit_convert(uint16_t *buffer, int len) {
+    printspider_portmap_convert(&portmap, buffer, len);
+}
+
+void emit_pairs(const uint16_t *pairs, int len) {
+    if (len <= 0) return;
+    uint16_t count = len;
+    uint8_t sreg = SREG;
+    cli();
+    // Pins of the two ports that are not part of the bus keep their state.
+    uint8_t keep_d = PORTD & ~(uint8_t)portmap.mask;
+    uint8_t keep_b = PORTB & ~(uint8_t)(portmap.mask >> 8);
+    uint8_t d, b;
+    // 12 cycles per word plus padding: ld 2+2, or 1+1, out 1+1, sbiw 2,
+    // brne 2. PORTD (data lines) is written one cycle before PORTB (clock).
+    __asm__ __volatile__(
+        "1:\n\t"
+        "ld %[d], %a[p]+\n\t"
+        "ld %[b], %a[p]+\n\t"
+        "or %[d], %[kd]\n\t"
+        "or %[b], %[kb]\n\t"
+        "out %[portd], %[d]\n\t"
+        "out %[portb], %[b]\n\t"
+        ".rept %[pad]\n\t"
+        "nop\n\t"
+        ".endr\n\t"
+        "sbiw %[n], 1\n\t"
+        "brne 1b\n\t"
+        : [p] "+e"(pairs), [n] "+w"(count), [d] "=&r"(d), [b] "=&r"(b)
+        : [kd] "r"(keep_d), [kb] "r"(keep_b),
+          [portd] "I"(_SFR_IO_ADDR(PORTD)), [portb] "I"(_SFR_IO_ADDR(PORTB)),
+          [pad] "n"(EMIT_WORD_CYCLES - EMIT_LOOP_CYCLES)
+        : "memory");
+    SREG = sreg;
+}
+
+void emit_idle(int len) {
+    if (len <= 0) return;
+    uint16_t count = len;
+    PORTD &= ~(uint8_t)portmap.mask;
+    PORTB &= ~(uint8_t)(portmap.mask >> 8);
+#ifdef PRINT_DUAL
+    PORTC &= ~EMIT_DUAL_MASK;
+#endif
+    // 4 cycles per word plus padding: sbiw 2, brne 2.
+    __asm__ __volatile__(
+        "1:\n\t"
+        ".rept %[pad]\n\t"
+        "nop\n\t"
+        ".endr\n\t"
+        "sbiw %[n], 1\n\t"
+        "brne 1b\n\t"
+        : [n] "+w"(count)
+        : [pad] "n"(EMIT_WORD_CYCLES - 4));
+}
+
+#ifdef PRINT_DUAL
+void emit_triples(const uint8_t *triples, int len) {
+    if (len <= 0) return;
+    uint16_t count = len;
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t keep_d = PORTD & ~(uint8_t)portmap.mask;
+    uint8_t keep_b = PORTB & ~(uint8_t)(portmap.mask >> 8);
+    uint8_t keep_c = PORTC & ~EMIT_DUAL_MASK;
+    uint8_t d, b, c;
+    // 16 cycles per word plus padding: ld 2+2+2, or 1+1+1, out 1+1+1, sbiw 2,
+    // brne 2. The data lines of both cartridges change within two cycles of
+    // the clock.
+    __asm__ __volatile__(
+        "1:\n\t"
+        "ld %[d], %a[p]+\n\t"
+        "ld %[b], %a[p]+\n\t"
+        "ld %[c], %a[p]+\n\t"
+        "or %[d], %[kd]\n\t"
+        "or %[b], %[kb]\n\t"
+        "or %[c], %[kc]\n\t"
+        "out %[portd], %[d]\n\t"
+        "out %[portc], %[c]\n\t"
+        "out %[portb], %[b]\n\t"
+        ".rept %[pad]\n\t"
+        "nop\n\t"
+        ".endr\n\t"
+        "sbiw %[n], 1\n\t"
+        "brne 1b\n\t"
+        : [p] "+e"(triples), [n] "+w"(count), [d] "=&r"(d), [b] "=&r"(b),
+          [c] "=&r"(c)
+        : [kd] "r"(keep_d), [kb] "r"(keep_b), [kc] "r"(keep_c),
+          [portd] "I"(_SFR_IO_ADDR(PORTD)), [portb] "I"(_SFR_IO_ADDR(PORTB)),
+          [portc] "I"(_SFR_IO_ADDR(PORTC)),
+          [pad] "n"(EMIT_WORD_CYCLES - EMIT_TRIPLE_LOOP_CYCLES)
+        : "memory");
+    SREG = sreg;
+}
+
+void emit_dual_begin(printspider_dual_cursor_t *cursor,
+                     const printspider_waveform_desc_t *a,
+                     const uint8_t *nozdata_a,
+                     const printspider_waveform_desc_t *b,
+                     const uint8_t *nozdata_b) {
+    printspider_dual_begin(cursor, &portmap, a, nozdata_a, b, nozdata_b);
+}
+#else
+const uint16_t *emit_next_packet(printspider_waveform_cursor_t *cursor,
+                                 int *len) {
+    return printspider_cache_next_packet(&cache, cursor, len);
+}
+
+void emit_get_cache_stats(printspider_cache_stats_t *stats) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { *stats = cache.stats; }
+}
+#endif
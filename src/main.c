@@ -17,14 +17,194 @@ limitations under the License.
 #include <stdio.h>
 
 #include "Arduino.h"
+#include "emit.h"
+#include "pipeline.h"
 #include "printspider.h"
+#include "printspider_dither.h"
+#include "printspider_dual.h"
+#include "printspider_image.h"
+#include "printspider_job.h"
+#include "printspider_power.h"
+#include "printspider_raster.h"
+#include "printspider_swath.h"
+#include "profile.h"
+#include "stream.h"
+#include "trigger.h"
+#include "uart.h"
 
-#define WAVEFORM_LEN 600
+// Dithering of the image rows, see printspider_dither.h.
+#ifndef DITHER_MODE
+#define DITHER_MODE PRINTSPIDER_DITHER_DIFFUSION
+#endif
+#ifndef DITHER_SEED
+#define DITHER_SEED 1
+#endif
+
+// Passes over the same span every repetition of the image is printed in, for
+// up to PRINT_PASSES drops per dot. Above 1 the image is dithered in the
+// multi-pass mode of printspider_dither.h, which spreads the drops of every
+// pixel over the passes.
+#ifndef PRINT_PASSES
+#define PRINT_PASSES 1
+#endif
+
+#if PRINT_PASSES < 1 || PRINT_PASSES > PRINTSPIDER_DITHER_MAX_PASSES
+#error "PRINT_PASSES is out of range"
+#endif
+
+// Nozzles fired at most per packet and power line (F3/F5), see
+// printspider_power.h. Defaults to half of the 12 nozzles of a group for
+// black, and no limit for color. The nozzles over the budget are fired in
+// extra passes of the same row, so no drop is lost.
+// #define POWER_BUDGET 6
+
+// Uncomment to fire the nozzles over the power budget with the next row
+// instead, so rows keep their rate. A nozzle requested again before it was
+// fired fires once for both: drops are lost in areas denser than the budget,
+// solid black comes out at half density with the default budget.
+// #define POWER_NEXT_ROW
+
+// Uncomment to emit rows from the Timer2 interrupt while the next row is
+// being prepared, see pipeline.h.
+// #define PRINT_PIPELINED
+
+// Uncomment to start every row at the next position step of a quadrature
+// encoder on A0 and A1 instead of at a fixed rate, see trigger.h. Needs
+// PRINT_PIPELINED. Set it as a build flag, like env:uno_trigger does, as the
+// pipeline depends on it too.
+// #define PRINT_TRIGGERED
+
+#if PRINT_PASSES > 1 && defined(PRINT_STREAM)
+#error "PRINT_PASSES only prints the built in images"
+#endif
+
+#if defined(PRINT_TRIGGERED) && !defined(PRINT_PIPELINED)
+#error "PRINT_TRIGGERED needs PRINT_PIPELINED"
+#endif
+
+// Uncomment to print rows received over the serial port instead of the
+// built in image, see stream.h. Frees pins 0 and 1 for the USART.
+// #define PRINT_STREAM
+
+// Uncomment to time every stage of the print path, see profile.h. The report
+// is sent over the serial port after printing, or on request of the host
+// with PRINT_STREAM.
+// #define PRINT_PROFILE
+
+// Number of times the image is printed.
+#ifndef PRINT_ROWS
+#define PRINT_ROWS 1
+#endif
+
+// Uncomment to print every repetition of the image as a pass of its own, every
+// other one with the carriage moving backwards, see printspider_swath.h.
+// #define PRINT_BIDIRECTIONAL
+
+// Blank firings at both ends of a bidirectional pass, the range of the
+// alignment below.
+#ifndef BIDI_ALIGN_MAX
+#define BIDI_ALIGN_MAX 8
+#endif
+
+// Shift of the image in forward and reverse passes, in firings, towards the
+// direction the carriage moves. The passes line up when the sum of both is the
+// distance the dots of a reverse pass land ahead of the forward ones.
+#ifndef BIDI_ALIGN_FORWARD
+#define BIDI_ALIGN_FORWARD 0
+#endif
+#ifndef BIDI_ALIGN_REVERSE
+#define BIDI_ALIGN_REVERSE 0
+#endif
+
+// Set to print with a color and a black cartridge at once, see
+// printspider_dual.h: the color cartridge takes the bus below, the black one
+// shares S1..S5 and DCLK with it and has its own lines on A0..A5. Both demo
+// images are printed together. Set it as a build flag, like env:uno_dual
+// does, as the output stage depends on it too.
+// #define PRINT_DUAL
+
+// Firings the black cartridge trails the color one with PRINT_DUAL, for the
+// distance between the nozzles of both cartridges in the print direction.
+#ifndef DUAL_BLACK_DELAY
+#define DUAL_BLACK_DELAY 0
+#endif
+
+#ifdef PRINT_DUAL
+#if defined(PRINT_STREAM) || defined(PRINT_PIPELINED) || \
+    defined(PRINT_BIDIRECTIONAL)
+#error "PRINT_DUAL only prints the built in images, without the pipeline"
+#endif
+#ifndef PRINT_COLOR
+#define PRINT_COLOR
+#endif
+#endif
+
+// Set to print labels drawn on the fly instead of the built in image: a lot
+// number and its Code128 barcode, see printspider_raster.h. The number counts
+// up from LABEL_FIRST with every repetition, no image is kept in memory.
+// #define PRINT_LABEL
+
+// Number of the first label.
+#ifndef LABEL_FIRST
+#define LABEL_FIRST 1
+#endif
+
+// Lines per barcode module.
+#ifndef LABEL_MODULE
+#define LABEL_MODULE 2
+#endif
+
+#if defined(PRINT_LABEL) &&                                    \
+    (defined(PRINT_STREAM) || defined(PRINT_DUAL) ||           \
+     defined(PRINT_BIDIRECTIONAL) || PRINT_PASSES > 1)
+#error "PRINT_LABEL only prints forward passes of one cartridge"
+#endif
+
+// Uncomment to fire every black dot with one of the two nozzle rows instead
+// of both, alternating between them, see printspider_swath_set_redundant.
+// Every nozzle fires at most every other row, and failed nozzles listed in
+// DEAD_NOZZLES are left out. With PRINT_DUAL it applies to the black
+// cartridge.
+// #define PRINT_REDUNDANT
+
+// Failed black nozzles, numbered 0..167 in the first nozzle row and 168..335
+// in the second one, the dots of which PRINT_REDUNDANT fires with the other
+// row. Set it as a build flag, e.g. -DDEAD_NOZZLES=12,200.
+// #define DEAD_NOZZLES 12, 200
+
+#if defined(PRINT_REDUNDANT) && defined(PRINT_COLOR) && !defined(PRINT_DUAL)
+#error "PRINT_REDUNDANT needs the black cartridge"
+#endif
+
+// Set to play the print job compiled by tools/ps_job into include/demo_job.h
+// instead of printing the built in image, see printspider_job.h. The packets
+// are only decompressed and written to the lines, PRINT_ROWS times; the
+// cartridge, dithering and power budget are those the job was compiled with.
+// #define PRINT_JOB
+
+#if defined(PRINT_JOB) &&                                                  \
+    (defined(PRINT_STREAM) || defined(PRINT_PIPELINED) ||                  \
+     defined(PRINT_DUAL) || defined(PRINT_BIDIRECTIONAL) ||                \
+     defined(PRINT_LABEL) || defined(PRINT_REDUNDANT) || PRINT_PASSES > 1)
+#error "PRINT_JOB only plays the compiled job"
+#endif
+
+#if BIDI_ALIGN_FORWARD < -BIDI_ALIGN_MAX || \
+    BIDI_ALIGN_FORWARD > BIDI_ALIGN_MAX ||  \
+    BIDI_ALIGN_REVERSE < -BIDI_ALIGN_MAX || BIDI_ALIGN_REVERSE > BIDI_ALIGN_MAX
+#error "Bidirectional alignment is out of BIDI_ALIGN_MAX range"
+#endif
 
 // GPIO numbers for the lines that are connected (via level converters) to the
 // printer cartridge.
+#ifdef PRINT_STREAM
+// Pins 0 and 1 are taken by the USART.
+#define PIN_NUM_CART_D1 12
+#define PIN_NUM_CART_D2 13
+#else
 #define PIN_NUM_CART_D1 0
 #define PIN_NUM_CART_D2 1
+#endif
 #define PIN_NUM_CART_D3 2
 #define PIN_NUM_CART_CSYNC 3
 #define PIN_NUM_CART_S1 4
@@ -35,6 +215,8 @@ limitations under the License.
 #define PIN_NUM_CART_DCLK 9
 #define PIN_NUM_CART_F3 10
 #define PIN_NUM_CART_F5 11
+// With PRINT_DUAL the black cartridge's own lines are fixed to PORTC: D1 on
+// A0, D2 on A1, D3 on A2, CSYNC on A3, F3 on A4 and F5 on A5.
 
 // Output settings.
 static uint8_t gpio_bus[] = {
@@ -52,190 +234,248 @@ static uint8_t gpio_bus[] = {
     PIN_NUM_CART_F5      // 11
 };
 
-/**
- * Each array row is the row of pixels from image offsetted from each other by
- * PRINTSPIDER_COLOR_ROW_OFFSET. Number of elementsof each row is
- * PRINTSPIDER_COLOR_NOZZLES_IN_ROW. Each row consist of only one color channel.
- * Each pixel element is one byte value.
- */
-typedef struct color_image_part_t {
-    // Cayan color channel. First image row.
-    const uint8_t *cayan_row;
-    // Magenta color channel. This row should be taken from image by offsetting
-    // y position from first row position by PRINTSPIDER_COLOR_ROW_OFFSET.
-    const uint8_t *magenta_row;
-    // Yellow color channel. This row should be taken from image by offsetting y
-    // position from second row position by PRINTSPIDER_COLOR_ROW_OFFSET.
-    const uint8_t *yellow_row;
-} color_image_part_t;
+static printspider_waveform_desc_t selected_waveform;
 
-/**
- * Each array row is the row of pixels from image offsetted from each other by
- * PRINTSPIDER_BLACK_ROW_OFFSET. Number of elementsof each row is
- * PRINTSPIDER_BLACK_NOZZLES_IN_ROW. Pixel element is one byte grayscale value.
- */
-typedef struct black_image_part_t {
-    // First image row.
-    const uint8_t *first_row;
-    // Second image row. This row should be taken from image by offsetting y
-    // position from first row position by PRINTSPIDER_BLACK_ROW_OFFSET.
-    const uint8_t *second_row;
-} black_image_part_t;
+// Dither state per color channel or black nozzle row.
+static printspider_dither_t dither[3];
 
-static printspider_waveform_desc_t selected_waveform;
+static printspider_power_t power;
 
-void digitalWriteFast(uint8_t pin, uint8_t x) {
-    if (pin / 8) {  // pin >= 8
-        PORTB ^= (-x ^ PORTB) & (1 << (pin % 8));
-    } else {
-        PORTD ^= (-x ^ PORTD) & (1 << (pin % 8));
-    }
-}
+#ifdef PRINT_DUAL
+static printspider_waveform_desc_t black_waveform;
+static printspider_dither_t black_dither;
+static printspider_power_t black_power;
 
-void out_to_pins(uint16_t *buffer, int len) {
-    for (int i = 0; i < len; i++) {
-        for (int p = 0; p < sizeof(gpio_bus); p++) {
-            digitalWrite(gpio_bus[p], buffer[i] >> p & 1);
+/**
+ * Sends nozzle data of both cartridges to output pins, merged packet by
+ * packet.
+ */
+void send_dual_out(const uint8_t *nozdata, const uint8_t *black_nozdata) {
+    static printspider_dual_cursor_t cursor;
+    emit_dual_begin(&cursor, &selected_waveform, nozdata, &black_waveform,
+                    black_nozdata);
+    for (;;) {
+        int len;
+        PROFILE_BEGIN(start);
+        const uint8_t *triples = printspider_dual_next_packet(&cursor, &len);
+        PROFILE_END(PROFILE_WAVEFORM, start);
+        if (!triples && !len) break;
+        PROFILE_BEGIN(emit_start);
+        if (triples) {
+            emit_triples(triples, len);
+        } else {
+            emit_idle(len);
         }
+        PROFILE_END(PROFILE_EMIT, emit_start);
     }
-    // delayMicroseconds(10);
 }
+#endif
 
 /**
  * Send nozzle data to output pins.
  */
 void send_nozdata_out(uint8_t *nozdata) {
-    static uint16_t waveform_buffer[WAVEFORM_LEN];
-    memset(waveform_buffer, 0, sizeof(uint16_t) * WAVEFORM_LEN);
-    int generated_len =
-        printspider_generate_waveform(waveform_buffer, selected_waveform.data,
-                                      nozdata, selected_waveform.len);
-    out_to_pins(waveform_buffer, generated_len);
+#ifdef PRINT_DUAL
+    // The black cartridge idles.
+    static const uint8_t blank[PRINTSPIDER_NOZDATA_SZ];
+    send_dual_out(nozdata, blank);
+#else
+    // The waveform is generated and sent one packet at a time, so only one
+    // packet has to fit in memory. Repeated packets come from the cache, and
+    // blank rows are only waited out.
+    printspider_waveform_cursor_t cursor;
+    printspider_waveform_begin_fast(&cursor, &selected_waveform, nozdata);
+    for (;;) {
+        int len;
+        PROFILE_BEGIN(start);
+        const uint16_t *pairs = emit_next_packet(&cursor, &len);
+        PROFILE_END(PROFILE_WAVEFORM, start);
+        if (!pairs && !len) break;
+        PROFILE_BEGIN(emit_start);
+        if (pairs) {
+            emit_pairs(pairs, len);
+        } else {
+            emit_idle(len);
+        }
+        PROFILE_END(PROFILE_EMIT, emit_start);
+    }
+#endif
 }
 
 /**
- * Sends image data to cartridge.
- * @param color_image_part image data part.
+ * Returns cleared nozzle data buffer for the next firing.
  */
-void send_image_row_color(color_image_part_t *color_image_part) {
-    uint8_t nozdata[PRINTSPIDER_NOZDATA_SZ];
+uint8_t *output_begin() {
+#ifdef PRINT_PIPELINED
+    PROFILE_BEGIN(start);
+    uint8_t *nozdata = pipeline_acquire();
+    PROFILE_END(PROFILE_WAIT, start);
+    return nozdata;
+#else
+    static uint8_t nozdata[PRINTSPIDER_NOZDATA_SZ];
     memset(nozdata, 0, sizeof(nozdata));
-    for (int c = 0; c < 3; c++) {
-        for (int y = 0; y < PRINTSPIDER_COLOR_NOZZLES_IN_ROW; y++) {
-            uint8_t v;
-            if (c == 0) {
-                v = color_image_part->cayan_row[y];
-            } else if (c == 1) {
-                v = color_image_part->magenta_row[y];
-            } else if (c == 2) {
-                v = color_image_part->yellow_row[y];
-            }
-            // Note the v returned is 0 for black, 255 for the color. We need to
-            // invert that here as we're printing on white.
-            v = 255 - v;
-            // Random-dither. The chance of the nozzle firing is equal to
-            // (v/256).
-            if (v > (rand() & 255)) {
-                // Note: The actual nozzles for the color cart start around y=14
-                printspider_set_nozzle_color(
-                    nozdata, y + PRINTSPIDER_COLOR_VERTICAL_OFFSET, c);
-            }
-        }
-    }
-    // Send nozzle data.
+    return nozdata;
+#endif
+}
+
+/**
+ * Sends the firing filled in buffer returned by output_begin.
+ */
+void output_end(uint8_t *nozdata) {
+#ifdef PRINT_PIPELINED
+    pipeline_commit();
+#else
     send_nozdata_out(nozdata);
+#endif
 }
 
 /**
- * Sends black image data to cartridge.
- * @param black_image_part image data array.
+ * Returns cleared nozzle data buffer for the next row.
  */
-void send_image_row_black(black_image_part_t *black_image_part) {
-    uint8_t nozdata[PRINTSPIDER_NOZDATA_SZ];
+uint8_t *row_begin() {
+    profile_row_begin();
+    static uint8_t nozdata[PRINTSPIDER_NOZDATA_SZ];
     memset(nozdata, 0, sizeof(nozdata));
-    for (int row = 0; row < 2; row++) {
-        for (int y = 0; y < PRINTSPIDER_BLACK_NOZZLES_IN_ROW; y++) {
-            // We take anything but white in any color channel of the image to
-            // mean we want black there.
-            uint8_t color;
-            if (row == 0) {
-                color = black_image_part->first_row[y];
-            } else if (row == 1) {
-                color = black_image_part->second_row[y];
-            }
-            if (color != 0xff) {
-                // Random-dither 50%, as firing all nozzles is a bit hard on the
-                // power supply.
-                if (rand() & 1) {
-                    printspider_set_nozzle_black(nozdata, y, row);
-                }
-            }
-        }
+    return nozdata;
+}
+
+/**
+ * Sends the row filled in buffer returned by row_begin, within the power
+ * budget.
+ */
+void row_end(uint8_t *nozdata) {
+#ifndef POWER_NEXT_ROW
+    uint16_t left;
+    do {
+        uint8_t *out = output_begin();
+        PROFILE_BEGIN(start);
+        left = printspider_power_take(&power, nozdata, out);
+        PROFILE_END(PROFILE_POWER, start);
+        output_end(out);
+    } while (left);
+#else
+    uint8_t *out = output_begin();
+    PROFILE_BEGIN(start);
+    printspider_power_limit(&power, nozdata, out);
+    PROFILE_END(PROFILE_POWER, start);
+    output_end(out);
+#endif
+    profile_row_end();
+}
+
+/**
+ * Sets up one dither state per nozzle row, so every print starts from the
+ * same state.
+ */
+void setup_dither() {
+    for (int i = 0; i < 3; i++) {
+#if PRINT_PASSES > 1
+        printspider_dither_init(&dither[i], PRINTSPIDER_DITHER_MULTIPASS,
+                                DITHER_SEED + i);
+        printspider_dither_set_passes(&dither[i], PRINT_PASSES);
+#else
+        printspider_dither_init(&dither[i], DITHER_MODE, DITHER_SEED + i);
+#endif
     }
-    // Send nozzle data.
-    send_nozdata_out(nozdata);
 }
 
+/**
+ * Starts a pass of the multi-pass mode in every dither state, see
+ * printspider_dither_begin_pass.
+ * @param pass pass counted from 0.
+ */
+void begin_pass(uint8_t pass) {
+    for (int i = 0; i < 3; i++) {
+        printspider_dither_begin_pass(&dither[i], pass);
+    }
+#ifdef PRINT_DUAL
+    printspider_dither_begin_pass(&black_dither, pass);
+#endif
+}
+
+/**
+ * Sets up the limit of nozzles fired at once.
+ */
+void setup_power() {
+#if defined(POWER_BUDGET)
+    printspider_power_init(&power, POWER_BUDGET);
+#elif defined(PRINT_COLOR)
+    printspider_power_init(&power, PRINTSPIDER_POWER_GROUP_NOZZLES);
+#else
+    // Firing all black nozzles at once is a bit hard on the power supply,
+    // the rest are fired with the following rows.
+    printspider_power_init(&power, PRINTSPIDER_POWER_GROUP_NOZZLES / 2);
+#endif
+}
+
+#ifdef PRINT_DUAL
+/**
+ * Sends the rows of both cartridges, each within its own power budget.
+ */
+void dual_row_end(uint8_t *nozdata, uint8_t *black_nozdata) {
+    static uint8_t out[PRINTSPIDER_NOZDATA_SZ];
+    static uint8_t black_out[PRINTSPIDER_NOZDATA_SZ];
+#ifndef POWER_NEXT_ROW
+    uint16_t left, black_left;
+    do {
+        memset(out, 0, sizeof(out));
+        memset(black_out, 0, sizeof(black_out));
+        PROFILE_BEGIN(start);
+        left = printspider_power_take(&power, nozdata, out);
+        black_left = printspider_power_take(&black_power, black_nozdata,
+                                            black_out);
+        PROFILE_END(PROFILE_POWER, start);
+        send_dual_out(out, black_out);
+    } while (left || black_left);
+#else
+    memset(out, 0, sizeof(out));
+    memset(black_out, 0, sizeof(black_out));
+    PROFILE_BEGIN(start);
+    printspider_power_limit(&power, nozdata, out);
+    printspider_power_limit(&black_power, black_nozdata, black_out);
+    PROFILE_END(PROFILE_POWER, start);
+    send_dual_out(out, black_out);
+#endif
+    profile_row_end();
+}
+
+/**
+ * Sets up the black cartridge next to the color one. Returns 0 if the
+ * templates can't share the select and clock lines.
+ */
+int setup_dual() {
+    black_waveform = printspider_get_waveform(PRINTSPIDER_WAVEFORM_BLACK_B);
+#if PRINT_PASSES > 1
+    printspider_dither_init(&black_dither, PRINTSPIDER_DITHER_MULTIPASS,
+                            DITHER_SEED + 3);
+    printspider_dither_set_passes(&black_dither, PRINT_PASSES);
+#else
+    printspider_dither_init(&black_dither, DITHER_MODE, DITHER_SEED + 3);
+#endif
+#ifdef POWER_BUDGET
+    printspider_power_init(&black_power, POWER_BUDGET);
+#else
+    printspider_power_init(&black_power, PRINTSPIDER_POWER_GROUP_NOZZLES / 2);
+#endif
+    return printspider_dual_compatible(&selected_waveform, &black_waveform);
+}
+#endif
+
 void setup_gpio() {
     for (int i = 0; i < 12; i++) {
         int pin = gpio_bus[i];
         pinMode(pin, OUTPUT);
-        digitalWrite(pin, LOW);
+        digitalWriteFast(pin, LOW);
     }
+    emit_setup(gpio_bus, sizeof(gpio_bus));
 }
 
 // #define PRINT_COLOR
 
-#ifdef PRINT_COLOR
-static const uint8_t cayan_row_value[] = {
-    255, 252, 249, 246, 243, 240, 237, 234, 231, 228, 225, 222, 219, 216,
-    213, 210, 207, 204, 201, 198, 195, 192, 189, 186, 183, 180, 177, 174,
-    171, 168, 165, 162, 159, 156, 153, 150, 147, 144, 141, 138, 135, 132,
-    129, 126, 123, 120, 117, 114, 111, 108, 105, 102, 99,  96,  93,  90,
-    87,  84,  81,  78,  75,  72,  69,  66,  63,  60,  57,  54,  51,  48,
-    45,  42,  39,  36,  33,  30,  27,  24,  21,  18,  15,  12,  9,   6};
-static const uint8_t magenta_row_value[] = {
-    1,   4,   7,   10,  13,  16,  19,  22,  25,  28,  31,  34,  37,  40,
-    43,  46,  49,  52,  55,  58,  61,  64,  67,  70,  73,  76,  79,  82,
-    85,  88,  91,  94,  97,  100, 103, 106, 109, 112, 115, 118, 121, 124,
-    127, 130, 133, 136, 139, 142, 145, 148, 151, 154, 157, 160, 163, 166,
-    169, 172, 175, 178, 181, 184, 187, 190, 193, 196, 199, 202, 205, 208,
-    211, 214, 217, 220, 223, 226, 229, 232, 235, 238, 241, 244, 247, 250};
-static const uint8_t yellow_row_value[] = {
-    255, 252, 249, 246, 243, 240, 237, 234, 231, 228, 225, 222, 219, 216,
-    213, 210, 207, 204, 201, 198, 195, 192, 189, 186, 183, 180, 177, 174,
-    171, 168, 165, 162, 159, 156, 153, 150, 147, 144, 141, 138, 135, 132,
-    129, 126, 123, 120, 117, 114, 111, 108, 105, 102, 99,  96,  93,  90,
-    87,  84,  81,  78,  75,  72,  69,  66,  63,  60,  57,  54,  51,  48,
-    45,  42,  39,  36,  33,  30,  27,  24,  21,  18,  15,  12,  9,   6};
-#else
-static const uint8_t first_row_value[] = {
-    1,   2,   3,   4,   5,   6,   7,   8,   9,   10,  11,  12,  13,  14,
-    15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,
-    29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,  41,  42,
-    43,  44,  45,  46,  47,  48,  49,  50,  51,  52,  53,  54,  55,  56,
-    57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,
-    71,  72,  73,  74,  75,  76,  77,  78,  79,  80,  81,  82,  83,  84,
-    85,  87,  89,  91,  93,  95,  97,  99,  101, 103, 105, 107, 109, 111,
-    113, 115, 117, 119, 121, 123, 125, 127, 129, 131, 133, 135, 137, 139,
-    141, 143, 145, 147, 149, 151, 153, 155, 157, 159, 161, 163, 165, 167,
-    169, 171, 173, 175, 177, 179, 181, 183, 185, 187, 189, 191, 193, 195,
-    197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221, 223,
-    225, 227, 229, 231, 233, 235, 237, 239, 241, 243, 245, 247, 249, 251};
-static const uint8_t second_row_value[] = {
-    1,   2,   3,   4,   5,   6,   7,   8,   9,   10,  11,  12,  13,  14,
-    15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,
-    29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,  41,  42,
-    43,  44,  45,  46,  47,  48,  49,  50,  51,  52,  53,  54,  55,  56,
-    57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,
-    71,  72,  73,  74,  75,  76,  77,  78,  79,  80,  81,  82,  83,  84,
-    85,  87,  89,  91,  93,  95,  97,  99,  101, 103, 105, 107, 109, 111,
-    113, 115, 117, 119, 121, 123, 125, 127, 129, 131, 133, 135, 137, 139,
-    141, 143, 145, 147, 149, 151, 153, 155, 157, 159, 161, 163, 165, 167,
-    169, 171, 173, 175, 177, 179, 181, 183, 185, 187, 189, 191, 193, 195,
-    197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221, 223,
-    225, 227, 229, 231, 233, 235, 237, 239, 241, 243, 245, 247, 249, 251};
-#endif
+// Uncomment to generate the waveform by walking the template instead of
+// from its precomputed steps, to compare the two in the PROFILE_WAVEFORM
+// stage of the profile report.
+// #define WAVEFORM_TEMPLATE_WALK
 
 // Selecting printsider waveform.
 static void select_waveform() {
@@ -244,32 +484,433 @@ static void select_waveform() {
 #else
     selected_waveform = printspider_get_waveform(PRINTSPIDER_WAVEFORM_BLACK_B);
 #endif
+#ifdef WAVEFORM_TEMPLATE_WALK
+    selected_waveform.steps = NULL;
+#endif
 }
 
-void print() {
+// Image printed at start, see printspider_image.h.
 #ifdef PRINT_COLOR
-    color_image_part_t color_part;
-    color_image_part_t *color_part_adr = &color_part;
-    color_part_adr->cayan_row = cayan_row_value;
-    color_part_adr->magenta_row = magenta_row_value;
-    color_part_adr->yellow_row = yellow_row_value;
-    send_image_row_color(color_part_adr);
+#include "demo_color.h"
+#define DEMO_IMAGE demo_color
 #else
-    black_image_part_t black_part;
-    black_image_part_t *black_part_adr = &black_part;
-    black_part_adr->first_row = first_row_value;
-    black_part_adr->second_row = second_row_value;
-    send_image_row_black(black_part_adr);
+#include "demo_black.h"
+#define DEMO_IMAGE demo_black
 #endif
+
+// Combines image lines for the offset nozzle rows.
+static printspider_swath_t swath;
+#ifdef PRINT_COLOR
+static uint8_t swath_buffer[PRINTSPIDER_SWATH_COLOR_SZ];
+#else
+static uint8_t swath_buffer[PRINTSPIDER_SWATH_BLACK_SZ];
+#endif
+
+#ifdef PRINT_REDUNDANT
+/**
+ * Splits the black image lines between both nozzle rows, around the nozzles
+ * in DEAD_NOZZLES.
+ * @param s swath of the black cartridge.
+ */
+void setup_redundant(printspider_swath_t *s) {
+    static uint8_t dead[PRINTSPIDER_SWATH_DEAD_SZ];
+#ifdef DEAD_NOZZLES
+    static const uint16_t dead_nozzles[] = {DEAD_NOZZLES};
+    for (unsigned i = 0; i < sizeof(dead_nozzles) / sizeof(dead_nozzles[0]);
+         i++) {
+        uint16_t row = dead_nozzles[i] / PRINTSPIDER_BLACK_NOZZLES_IN_ROW;
+        uint16_t p = dead_nozzles[i] % PRINTSPIDER_BLACK_NOZZLES_IN_ROW;
+        if (row > 1) continue;
+        dead[row * PRINTSPIDER_BLACK_ROW_BYTES + p / 8] |= 0x80 >> (p % 8);
+    }
+#endif
+    printspider_swath_set_redundant(s, 1, dead);
+}
+#endif
+
+// Rows printed, for the stream status without the pipeline.
+static uint16_t rows_printed;
+
+/**
+ * Prints the firing completed by the image line, see printspider_swath_push.
+ * @param line packed image line, or NULL for an empty line.
+ */
+void print_line(const uint8_t *line) {
+    uint8_t *nozdata = row_begin();
+    PROFILE_BEGIN(start);
+    printspider_swath_push(&swath, line, nozdata);
+    PROFILE_END(PROFILE_NOZZLES, start);
+    row_end(nozdata);
+    rows_printed++;
+}
+
+/**
+ * Prints what is left of the last image lines in the delayed nozzle rows and
+ * the nozzles deferred by the power budget.
+ */
+void print_swath_tail() {
+    while (printspider_swath_pending(&swath)) {
+        print_line(NULL);
+    }
+    while (printspider_power_pending(&power)) {
+        row_end(row_begin());
+        rows_printed++;
+    }
+}
+
+/**
+ * Prints an image from flash, dithering 8-bit images on the way.
+ * @param image image made by tools/ps_image.py.
+ * @param reverse 1 to print the lines last to first.
+ */
+void print_image(const printspider_image_t *image, uint8_t reverse) {
+    static uint8_t pixels[PRINTSPIDER_BLACK_NOZZLES_IN_ROW];
+    static uint8_t line[3 * PRINTSPIDER_COLOR_ROW_BYTES];
+    printspider_image_reader_t reader;
+    printspider_image_open(&reader, image);
+    for (uint16_t i = 0; i < image->lines; i++) {
+        PROFILE_BEGIN(start);
+        if (reverse) {
+            uint16_t src_line = image->lines - 1 - i;
+            printspider_image_seek(&reader, src_line);
+            // A line gets the same matrix row of the ordered and multi-pass
+            // dithers in either direction, and every pass dithers it the same.
+            for (int c = 0; c < 3; c++) {
+                printspider_dither_seek_row(&dither[c], src_line);
+            }
+        }
+        printspider_image_read_line(&reader, dither, pixels, line);
+        PROFILE_END(PROFILE_DITHER, start);
+        print_line(line);
+    }
 }
 
+void print() { print_image(&DEMO_IMAGE, 0); }
+
+#ifdef PRINT_LABEL
+#ifdef PRINT_COLOR
+#define LABEL_WIDTH PRINTSPIDER_COLOR_NOZZLES_IN_ROW
+#define LABEL_TEXT_SCALE 1
+#else
+#define LABEL_WIDTH PRINTSPIDER_BLACK_NOZZLES_IN_ROW
+#define LABEL_TEXT_SCALE 2
+#endif
+
+/**
+ * Prints a label drawn line by line, the lot number above its barcode.
+ * @param number lot number.
+ */
+void print_label(uint16_t number) {
+    static char text[12];
+    static uint8_t line[3 * PRINTSPIDER_COLOR_ROW_BYTES];
+    printspider_raster_t label_text;
+    printspider_raster_t barcode;
+    snprintf(text, sizeof(text), "LOT %05u", (unsigned)number);
+    printspider_raster_text(&label_text, text, 0, LABEL_TEXT_SCALE);
+    printspider_raster_code128(&barcode, text, 8 * LABEL_TEXT_SCALE,
+                               LABEL_WIDTH - 8 * LABEL_TEXT_SCALE,
+                               LABEL_MODULE);
+    for (;;) {
+        PROFILE_BEGIN(start);
+        memset(line, 0, sizeof(line));
+        int more = printspider_raster_next_line(&label_text, line, LABEL_WIDTH);
+        more |= printspider_raster_next_line(&barcode, line, LABEL_WIDTH);
+#ifdef PRINT_COLOR
+        // Composite black, the same pixels in cyan, magenta and yellow.
+        memcpy(&line[PRINTSPIDER_COLOR_ROW_BYTES], line,
+               PRINTSPIDER_COLOR_ROW_BYTES);
+        memcpy(&line[2 * PRINTSPIDER_COLOR_ROW_BYTES], line,
+               PRINTSPIDER_COLOR_ROW_BYTES);
+#endif
+        PROFILE_END(PROFILE_DITHER, start);
+        if (!more) break;
+        print_line(line);
+    }
+}
+#endif
+
+#ifdef PRINT_JOB
+#include "demo_job.h"
+#define JOB demo_job
+
+/**
+ * Plays a compiled print job, packet by packet.
+ * @param job job made by tools/ps_job.
+ */
+void play_job(const printspider_job_t *job) {
+    static uint16_t pairs[PRINTSPIDER_JOB_PACKET_LEN];
+    printspider_job_reader_t reader;
+    printspider_job_open(&reader, job);
+    for (;;) {
+        int len;
+        PROFILE_BEGIN(start);
+        const uint16_t *p = printspider_job_next_packet(&reader, pairs, &len);
+        PROFILE_END(PROFILE_WAVEFORM, start);
+        if (!p && !len) break;
+        PROFILE_BEGIN(emit_start);
+        if (p) {
+            emit_pairs(p, len);
+        } else {
+            emit_idle(len);
+        }
+        PROFILE_END(PROFILE_EMIT, emit_start);
+    }
+}
+#endif
+
+#ifdef PRINT_BIDIRECTIONAL
+/**
+ * Prints an image as one pass of the carriage. Passes in both directions
+ * take the same amount of firings, so they cover the same span.
+ * @param image image made by tools/ps_image.py.
+ * @param reverse 1 for a pass with the carriage moving backwards.
+ */
+void print_pass(const printspider_image_t *image, uint8_t reverse) {
+    int align = reverse ? BIDI_ALIGN_REVERSE : BIDI_ALIGN_FORWARD;
+    printspider_swath_set_reverse(&swath, reverse);
+    for (int i = 0; i < BIDI_ALIGN_MAX + align; i++) {
+        print_line(NULL);
+    }
+    print_image(image, reverse);
+    // The delayed nozzle rows and the blank end of the pass, which also takes
+    // the nozzles deferred by the power budget.
+    for (int i = printspider_swath_pending(&swath) + BIDI_ALIGN_MAX - align;
+         i > 0; i--) {
+        print_line(NULL);
+    }
+    print_swath_tail();
+}
+#endif
+
+#ifdef PRINT_DUAL
+#include "demo_black.h"
+
+static printspider_swath_t black_swath;
+static uint8_t black_swath_buffer[PRINTSPIDER_SWATH_BLACK_SZ];
+
+/**
+ * Prints the firing completed by the image lines of both cartridges.
+ * @param line packed color image line, or NULL for an empty line.
+ * @param black_line packed black image line, or NULL for an empty line.
+ */
+void print_dual_line(const uint8_t *line, const uint8_t *black_line) {
+    static uint8_t black_nozdata[PRINTSPIDER_NOZDATA_SZ];
+    uint8_t *nozdata = row_begin();
+    memset(black_nozdata, 0, sizeof(black_nozdata));
+    PROFILE_BEGIN(start);
+    printspider_swath_push(&swath, line, nozdata);
+    printspider_swath_push(&black_swath, black_line, black_nozdata);
+    PROFILE_END(PROFILE_NOZZLES, start);
+    dual_row_end(nozdata, black_nozdata);
+    rows_printed++;
+}
+
+/**
+ * Prints what is left in the delayed nozzle rows and power budgets of both
+ * cartridges.
+ */
+void print_dual_tail() {
+    while (printspider_swath_pending(&swath) ||
+           printspider_swath_pending(&black_swath) ||
+           printspider_power_pending(&power) ||
+           printspider_power_pending(&black_power)) {
+        print_dual_line(NULL, NULL);
+    }
+}
+
+/**
+ * Prints a color and a black image from flash at once, the black one
+ * DUAL_BLACK_DELAY firings later.
+ * @param image color image made by tools/ps_image.py.
+ * @param black_image black image made by tools/ps_image.py.
+ */
+void print_dual(const printspider_image_t *image,
+                const printspider_image_t *black_image) {
+    static uint8_t pixels[PRINTSPIDER_BLACK_NOZZLES_IN_ROW];
+    static uint8_t line[3 * PRINTSPIDER_COLOR_ROW_BYTES];
+    static uint8_t black_line[PRINTSPIDER_BLACK_ROW_BYTES];
+    printspider_image_reader_t reader;
+    printspider_image_reader_t black_reader;
+    printspider_image_open(&reader, image);
+    printspider_image_open(&black_reader, black_image);
+    uint16_t lines = black_image->lines + DUAL_BLACK_DELAY;
+    if (image->lines > lines) lines = image->lines;
+    for (uint16_t i = 0; i < lines; i++) {
+        PROFILE_BEGIN(start);
+        int color = printspider_image_read_line(&reader, dither, pixels, line);
+        int black = i >= DUAL_BLACK_DELAY &&
+                    printspider_image_read_line(&black_reader, &black_dither,
+                                                pixels, black_line);
+        PROFILE_END(PROFILE_DITHER, start);
+        print_dual_line(color ? line : NULL, black ? black_line : NULL);
+    }
+}
+#endif
+
+#ifdef PRINT_STREAM
+/**
+ * Prints the row last received by stream_poll.
+ */
+void print_stream_row() {
+    uint8_t *nozdata = row_begin();
+    PROFILE_BEGIN(start);
+#ifdef PRINT_COLOR
+    for (int c = 0; c < 3; c++) {
+        printspider_set_row_color(nozdata, stream_row_bits(c), c);
+    }
+#else
+    for (int row = 0; row < 2; row++) {
+        printspider_set_row_black(nozdata, stream_row_bits(row), row);
+    }
+#endif
+    PROFILE_END(PROFILE_NOZZLES, start);
+    row_end(nozdata);
+    rows_printed++;
+}
+
+/**
+ * Sends row counters to the host.
+ */
+void send_stream_status() {
+    stream_status_t status;
+#ifdef PRINT_PIPELINED
+    pipeline_stats_t stats;
+    pipeline_get_stats(&stats);
+    status.rows = stats.rows;
+    status.underruns = stats.underruns;
+#else
+    status.rows = rows_printed;
+    status.underruns = 0;
+#endif
+    status.deferred_rows = power.deferred_rows;
+    status.deferred_nozzles = power.deferred_nozzles;
+    status.dropped_nozzles = power.dropped_nozzles;
+    stream_send_status(&status);
+}
+#endif
+
+#ifdef PRINT_PROFILE
+/**
+ * Sends a line of the profile report, see profile_dump.
+ */
+void send_profile_line(const char *line) {
+#ifdef PRINT_STREAM
+    stream_send_profile(line);
+#else
+    uart_write_buffer((const uint8_t *)line, strlen(line));
+    uart_write('\r');
+    uart_write('\n');
+#endif
+}
+#endif
+
 void setup() {
     setup_gpio();
     select_waveform();
+    setup_dither();
+    setup_power();
+    profile_init();
+#ifdef PRINT_PIPELINED
+    pipeline_start(&selected_waveform);
+#endif
+#ifdef PRINT_TRIGGERED
+    trigger_start();
+#endif
+
+#ifdef PRINT_COLOR
+    printspider_swath_init_color(&swath, swath_buffer);
+#else
+    printspider_swath_init_black(&swath, swath_buffer);
+#ifdef PRINT_REDUNDANT
+    setup_redundant(&swath);
+#endif
+#endif
 
-    print();
+#ifdef PRINT_STREAM
+#ifdef PRINT_COLOR
+    stream_begin(3, 3, PRINTSPIDER_COLOR_NOZZLES_IN_ROW, dither);
+#else
+    stream_begin(2, 1, PRINTSPIDER_BLACK_NOZZLES_IN_ROW, dither);
+#endif
+#else
+#if defined(PRINT_DUAL)
+    printspider_swath_init_black(&black_swath, black_swath_buffer);
+#ifdef PRINT_REDUNDANT
+    setup_redundant(&black_swath);
+#endif
+    // Nothing is printed with templates that can't share the lines.
+    if (setup_dual()) {
+        for (int i = 0; i < PRINT_ROWS * PRINT_PASSES; i++) {
+            if (PRINT_PASSES > 1) begin_pass(i % PRINT_PASSES);
+            print_dual(&DEMO_IMAGE, &demo_black);
+            // Passes cover the same span.
+            if (PRINT_PASSES > 1) print_dual_tail();
+        }
+        print_dual_tail();
+    }
+#elif defined(PRINT_JOB)
+    for (int i = 0; i < PRINT_ROWS; i++) {
+        play_job(&JOB);
+    }
+#elif defined(PRINT_LABEL)
+    for (int i = 0; i < PRINT_ROWS; i++) {
+        print_label(LABEL_FIRST + i);
+    }
+    print_swath_tail();
+#elif defined(PRINT_BIDIRECTIONAL)
+    for (int i = 0; i < PRINT_ROWS * PRINT_PASSES; i++) {
+        if (PRINT_PASSES > 1) begin_pass(i % PRINT_PASSES);
+        print_pass(&DEMO_IMAGE, i & 1);
+    }
+#else
+    for (int i = 0; i < PRINT_ROWS * PRINT_PASSES; i++) {
+        if (PRINT_PASSES > 1) begin_pass(i % PRINT_PASSES);
+        print();
+        // Passes cover the same span.
+        if (PRINT_PASSES > 1) print_swath_tail();
+    }
+    print_swath_tail();
+#endif
+#ifdef PRINT_PIPELINED
+    pipeline_flush();
+#endif
+#ifdef PRINT_PROFILE
+    // The cartridge is done with, D1 and D2 on pins 0 and 1 carry the
+    // report now.
+    uart_init(PROFILE_BAUD);
+    profile_dump(send_profile_line);
+#endif
+#endif
 }
 
 void loop() {
+#ifdef PRINT_STREAM
+    // Print for as long as the host keeps sending rows.
+    switch (stream_poll()) {
+        case STREAM_EVENT_ROW:
+            print_stream_row();
+            break;
+        case STREAM_EVENT_LINE:
+            print_line(stream_row_bits(0));
+            break;
+        case STREAM_EVENT_END:
+            print_swath_tail();
+#ifdef PRINT_PIPELINED
+            pipeline_flush();
+#endif
+            send_stream_status();
+            break;
+        case STREAM_EVENT_STATUS:
+            send_stream_status();
+            break;
+#ifdef PRINT_PROFILE
+        case STREAM_EVENT_PROFILE:
+            profile_dump(send_profile_line);
+            stream_send_profile("");
+            break;
+#endif
+    }
+#else
     // Printing executes only once at start in setup method.
+#endif
 }
\ No newline at end of file
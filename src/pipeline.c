@@ -0,0 +1,234 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "pipeline.h"
+
+// The pipeline only emits the rows of one cartridge.
+#ifndef PRINT_DUAL
+
+#include <string.h>
+#include <util/atomic.h>
+
+#include "Arduino.h"
+#include "emit.h"
+#include "profile.h"
+
+// Timer2 runs at clk/64.
+#define PIPELINE_TIMER_TOP ((F_CPU / 1000000UL) * PIPELINE_GAP_US / 64 - 1)
+
+#if PIPELINE_TIMER_TOP > 255
+#error "PIPELINE_GAP_US is out of Timer2 range"
+#endif
+
+#if PIPELINE_ROWS < 2
+#error "PIPELINE_ROWS needs a row being emitted and one being filled"
+#endif
+
+static printspider_waveform_desc_t pipeline_waveform;
+
+// Ring of nozzle data buffers: the row being emitted or next to emit, the
+// rows queued after it, then the free buffers.
+static uint8_t nozdata[PIPELINE_ROWS][PRINTSPIDER_NOZDATA_SZ];
+static volatile uint8_t head;
+// Committed rows not finished yet, the one being emitted included.
+static volatile uint8_t queued;
+// Set while the interrupt is in the middle of a row.
+static volatile uint8_t row_active;
+// Set between the first commit and pipeline_flush.
+static volatile uint8_t running;
+#ifndef PRINT_TRIGGERED
+// Start of the row being emitted, and the time from the start of the last
+// row to the slot of the row after it.
+static uint32_t row_start_us;
+static uint32_t row_us;
+// Slot the next row should have started in, while the bus is idle.
+static uint32_t idle_since_us;
+#endif
+#ifdef PRINT_TRIGGERED
+// Set for a trigger that came while the last row was still out.
+static volatile uint8_t late;
+// Time of the trigger the next row is started for.
+static uint32_t trigger_us;
+#endif
+
+static volatile pipeline_stats_t stats;
+
+static printspider_waveform_cursor_t cursor;
+
+// Sets the interrupt to come PIPELINE_GAP_US from now.
+static void schedule_packet(void) {
+    TCNT2 = 0;
+    TIFR2 = _BV(OCF2A);
+    TIMSK2 = _BV(OCIE2A);
+}
+
+// Starts emitting the row at head.
+static void start_row(void) {
+    row_active = 1;
+#ifndef PRINT_TRIGGERED
+    row_start_us = micros();
+#endif
+    printspider_waveform_begin_fast(&cursor, &pipeline_waveform,
+                                    nozdata[head]);
+}
+
+// Generates and emits the next data packet of the active row, and sets up
+// the interrupt for the packet after it.
+static void emit_packet(void) {
+    int len;
+    PROFILE_BEGIN(start);
+    const uint16_t *pairs = emit_next_packet(&cursor, &len);
+    PROFILE_END(PROFILE_WAVEFORM, start);
+#ifdef PRINT_TRIGGERED
+    if (cursor.packet == 1) {
+        uint32_t latency = micros() - trigger_us;
+        if (latency > 0xffff) latency = 0xffff;
+        if (latency < stats.latency_min_us) stats.latency_min_us = latency;
+        if (latency > stats.latency_max_us) stats.latency_max_us = latency;
+    }
+#endif
+    // Blank packets keep the bus low for as long as a packet takes.
+    PROFILE_BEGIN(emit_start);
+    if (pairs) {
+        emit_pairs(pairs, len);
+    } else {
+        emit_idle(len);
+    }
+    PROFILE_END(PROFILE_EMIT, emit_start);
+    if (cursor.pos >= cursor.total) {
+        row_active = 0;
+        if (++head == PIPELINE_ROWS) head = 0;
+        queued--;
+        stats.rows++;
+#ifdef PRINT_TRIGGERED
+        // Rows start on triggers, a late one after the gap.
+        if (!late || !queued) {
+            TIMSK2 = 0;
+            return;
+        }
+#endif
+    }
+    schedule_packet();
+}
+
+ISR(TIMER2_COMPA_vect) {
+    if (!row_active) {
+#ifdef PRINT_TRIGGERED
+        // Only enabled for a late row that is queued.
+        late = 0;
+#else
+        if (!queued) {
+            // The slot the next row should have started in passed, the
+            // interrupt is off until the next commit.
+            uint32_t now = micros();
+            row_us = now - row_start_us;
+            idle_since_us = now;
+            TIMSK2 = 0;
+            return;
+        }
+#endif
+        start_row();
+    }
+    emit_packet();
+}
+
+void pipeline_start(const printspider_waveform_desc_t *waveform) {
+    pipeline_waveform = *waveform;
+    stats.latency_min_us = 0xffff;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        TCCR2A = _BV(WGM21);  // CTC
+        TCCR2B = _BV(CS22);   // clk/64
+        OCR2A = PIPELINE_TIMER_TOP;
+        TIMSK2 = 0;
+    }
+}
+
+uint8_t *pipeline_acquire(void) {
+    // Wait for a free buffer, rows leave the ring as they are finished. The
+    // interrupt moves head on and takes the row off queued when it finishes
+    // one, so both are read together.
+    uint8_t index;
+    uint8_t full;
+    do {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            index = head + queued;
+            full = queued == PIPELINE_ROWS;
+        }
+    } while (full);
+    if (index >= PIPELINE_ROWS) index -= PIPELINE_ROWS;
+    uint8_t *buffer = nozdata[index];
+    memset(buffer, 0, PRINTSPIDER_NOZDATA_SZ);
+    return buffer;
+}
+
+void pipeline_commit(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        queued++;
+        // The interrupt is off while the bus is idle, the row starts after
+        // the gap.
+        uint8_t idle = !row_active && !(TIMSK2 & _BV(OCIE2A));
+#ifdef PRINT_TRIGGERED
+        if (idle && late) schedule_packet();
+#else
+        if (idle) {
+            // An underrun for every row time since the slot the row should
+            // have started in.
+            if (running) {
+                stats.underruns += 1 + (micros() - idle_since_us) / row_us;
+            }
+            schedule_packet();
+        }
+#endif
+        running = 1;
+    }
+}
+
+void pipeline_flush(void) {
+    while (queued) {
+    }
+    running = 0;
+}
+
+#ifdef PRINT_TRIGGERED
+void pipeline_trigger(uint32_t us) {
+    if (!running) return;
+    stats.triggers++;
+    if (row_active || late) {
+        // Still busy with the last row: start the next one right after it,
+        // or drop the trigger if one is already waiting.
+        stats.missed_triggers++;
+        if (!late) {
+            late = 1;
+            trigger_us = us;
+        }
+        return;
+    }
+    if (!queued) {
+        stats.missed_triggers++;
+        stats.underruns++;
+        return;
+    }
+    trigger_us = us;
+    start_row();
+    emit_packet();
+}
+#endif
+
+void pipeline_get_stats(pipeline_stats_t *out) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { *out = stats; }
+}
+
+#endif
@@ -0,0 +1,173 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "profile.h"
+
+#ifdef PRINT_PROFILE
+
+#include <stdio.h>
+#include <string.h>
+#include <util/atomic.h>
+
+#include "emit.h"
+#include "pipeline.h"
+#include "trigger.h"
+
+static const char stage_names[PROFILE_STAGES][9] PROGMEM = {
+    "dither", "nozzles", "power", "wait", "waveform", "emit", "row"};
+
+static volatile profile_stage_t stages[PROFILE_STAGES];
+// Cycles of taking a duration with nothing in between.
+static uint16_t overhead;
+
+volatile uint16_t profile_overflows;
+
+static uint32_t row_start;
+static uint32_t rows;
+// profile_now() at the end of the first and the last row.
+static uint32_t first_row_end;
+static uint32_t last_row_end;
+
+void profile_init(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        // Normal mode at clk/1, replacing the PWM setup of the Arduino core.
+        TCCR1A = 0;
+        TCCR1B = _BV(CS10);
+        TCNT1 = 0;
+        profile_overflows = 0;
+        TIFR1 = _BV(TOV1);
+        TIMSK1 = _BV(TOIE1);
+#ifndef PRINT_PIPELINED
+        // Nothing else uses millis() or micros() then, so the Timer0
+        // interrupt of the Arduino core is stopped instead of landing in the
+        // timed stages every 1024 us.
+        TIMSK0 &= ~_BV(TOIE0);
+#endif
+    }
+    uint32_t start = profile_now();
+    overhead = profile_now() - start;
+    profile_reset();
+}
+
+void profile_reset(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        memset((void *)stages, 0, sizeof(stages));
+        for (uint8_t i = 0; i < PROFILE_STAGES; i++) {
+            stages[i].min = 0xffffffffUL;
+        }
+        rows = 0;
+    }
+}
+
+ISR(TIMER1_OVF_vect) { profile_overflows++; }
+
+void profile_record(uint8_t stage, uint32_t cycles) {
+    cycles = cycles > overhead ? cycles - overhead : 0;
+    uint8_t bucket = 0;
+    for (uint32_t v = cycles >> PROFILE_BUCKET_SHIFT;
+         v && bucket < PROFILE_BUCKETS - 1; v >>= 1) {
+        bucket++;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        volatile profile_stage_t *s = &stages[stage];
+        s->count++;
+        s->sum += cycles;
+        if (cycles < s->min) s->min = cycles;
+        if (cycles > s->max) s->max = cycles;
+        if (s->buckets[bucket] != 0xffff) s->buckets[bucket]++;
+    }
+}
+
+void profile_row_begin(void) { row_start = profile_now(); }
+
+void profile_row_end(void) {
+    uint32_t now = profile_now();
+    profile_record(PROFILE_ROW, now - row_start);
+    if (!rows) first_row_end = now;
+    last_row_end = now;
+    rows++;
+}
+
+void profile_get(uint8_t stage, profile_stage_t *out) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        memcpy(out, (const void *)&stages[stage], sizeof(*out));
+    }
+}
+
+void profile_dump(void (*write_line)(const char *line)) {
+    char line[128];
+    int n = snprintf(line, sizeof(line), "stage count min max mean");
+    for (uint8_t i = 0; i < PROFILE_BUCKETS - 1; i++) {
+        n += snprintf(line + n, sizeof(line) - n, " <%u",
+                      1u << (PROFILE_BUCKET_SHIFT + i));
+    }
+    snprintf(line + n, sizeof(line) - n, " >=%u",
+             1u << (PROFILE_BUCKET_SHIFT + PROFILE_BUCKETS - 2));
+    write_line(line);
+
+    for (uint8_t i = 0; i < PROFILE_STAGES; i++) {
+        profile_stage_t s;
+        profile_get(i, &s);
+        if (!s.count) s.min = 0;
+        strcpy_P(line, stage_names[i]);
+        n = strlen(line);
+        n += snprintf(line + n, sizeof(line) - n, " %lu %lu %lu %lu",
+                      (unsigned long)s.count, (unsigned long)s.min,
+                      (unsigned long)s.max,
+                      s.count ? (unsigned long)(s.sum / s.count) : 0ul);
+        for (uint8_t b = 0; b < PROFILE_BUCKETS; b++) {
+            n += snprintf(line + n, sizeof(line) - n, " %u", s.buckets[b]);
+        }
+        write_line(line);
+    }
+
+    uint32_t us = (last_row_end - first_row_end) / (F_CPU / 1000000UL);
+    // The first row only starts the time.
+    uint32_t periods = rows > 1 ? rows - 1 : 1;
+    uint16_t underruns = 0;
+#ifdef PRINT_PIPELINED
+    pipeline_stats_t pipeline;
+    pipeline_get_stats(&pipeline);
+    underruns = pipeline.underruns;
+#endif
+    snprintf(line, sizeof(line), "rows %lu us %lu us_per_row %lu underruns %u",
+             (unsigned long)rows, (unsigned long)us,
+             (unsigned long)(us / periods), underruns);
+    write_line(line);
+
+#ifdef PRINT_TRIGGERED
+    trigger_stats_t encoder;
+    trigger_get_stats(&encoder);
+    snprintf(line, sizeof(line),
+             "triggers %u missed_triggers %u latency_min_us %u "
+             "latency_max_us %u encoder_position %d encoder_errors %u",
+             pipeline.triggers, pipeline.missed_triggers,
+             pipeline.triggers ? pipeline.latency_min_us : 0,
+             pipeline.latency_max_us, encoder.position, encoder.errors);
+    write_line(line);
+#endif
+
+#ifndef PRINT_DUAL
+    printspider_cache_stats_t cache;
+    emit_get_cache_stats(&cache);
+    snprintf(line, sizeof(line),
+             "cache_hits %u cache_misses %u cache_blank_rows %u", cache.hits,
+             cache.misses, cache.blank_rows);
+    write_line(line);
+#endif
+}
+
+#endif
@@ -0,0 +1,245 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "stream.h"
+
+#include <string.h>
+
+#include "printspider.h"
+#include "uart.h"
+
+enum {
+    STATE_SYNC,
+    STATE_TYPE,
+    STATE_LEN_LO,
+    STATE_LEN_HI,
+    STATE_PAYLOAD,
+    STATE_CRC
+};
+
+static uint8_t stream_channels;
+static uint8_t stream_line_channels;
+static uint8_t stream_nozzles;
+static uint8_t stream_row_bytes;
+static printspider_dither_t *stream_dither;
+
+static uint8_t state;
+static uint8_t frame_type;
+static uint16_t frame_len;
+static uint16_t frame_pos;
+static uint8_t frame_crc;
+// Bytes taken out of the receive buffer and not yet returned as credit.
+static uint8_t consumed;
+
+// Row being received, 1 bit per nozzle, channels one after another. Only
+// valid after a good crc.
+static uint8_t row_bits[3 * PRINTSPIDER_BLACK_ROW_BYTES];
+// Pixels of the channel being received in STREAM_ROW_BYTES frames.
+static uint8_t pixels[PRINTSPIDER_BLACK_NOZZLES_IN_ROW];
+// Dither state of the frame being received, only taken over after a good crc
+// so a bad frame leaves the dither where it was. Cheaper than a buffer for
+// all pixels of a row.
+static printspider_dither_t frame_dither[3];
+
+static uint16_t frames;
+static uint16_t crc_errors;
+static uint16_t frame_errors;
+static uint16_t overruns;
+
+static uint8_t crc8_update(uint8_t crc, uint8_t c) {
+    crc ^= c;
+    for (uint8_t i = 0; i < 8; i++) {
+        crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return crc;
+}
+
+static void send_frame(uint8_t type, const uint8_t *payload, uint16_t len) {
+    uint8_t header[4] = {STREAM_SYNC, type, len & 0xff, len >> 8};
+    uint8_t crc = 0;
+    for (uint8_t i = 1; i < 4; i++) crc = crc8_update(crc, header[i]);
+    for (uint16_t i = 0; i < len; i++) crc = crc8_update(crc, payload[i]);
+    uart_write_buffer(header, sizeof(header));
+    uart_write_buffer(payload, len);
+    uart_write(crc);
+}
+
+static void send_credit(uint16_t credit) {
+    uint8_t payload[2] = {credit & 0xff, credit >> 8};
+    send_frame(STREAM_CREDIT, payload, sizeof(payload));
+}
+
+// Returns expected payload length of a frame type, -1 for unknown types.
+static int payload_length(uint8_t type) {
+    uint8_t channels = stream_channels;
+    switch (type) {
+        case STREAM_LINE_PACKED:
+            channels = stream_line_channels;
+            // fall through
+        case STREAM_ROW_PACKED:
+            return channels * stream_row_bytes;
+        case STREAM_LINE_BYTES:
+            channels = stream_line_channels;
+            // fall through
+        case STREAM_ROW_BYTES:
+            return channels * stream_nozzles;
+        case STREAM_STATUS_REQUEST:
+        case STREAM_END:
+        case STREAM_PROFILE_REQUEST:
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+static void payload_byte(uint8_t c) {
+    if (frame_type == STREAM_ROW_PACKED || frame_type == STREAM_LINE_PACKED) {
+        row_bits[frame_pos] = c;
+        return;
+    }
+    // 8-bit pixels, dither every channel as soon as it is complete.
+    uint8_t channel = frame_pos / stream_nozzles;
+    uint8_t i = frame_pos % stream_nozzles;
+    pixels[i] = c;
+    if (i == stream_nozzles - 1) {
+        printspider_dither_row(&frame_dither[channel], pixels,
+                               row_bits + channel * stream_row_bytes,
+                               stream_nozzles);
+    }
+}
+
+// Handles a complete frame, returns the event it produces.
+static uint8_t frame_done(uint8_t crc) {
+    if (crc != frame_crc) {
+        crc_errors++;
+        return STREAM_EVENT_NONE;
+    }
+    if (frame_type == STREAM_ROW_BYTES || frame_type == STREAM_LINE_BYTES) {
+        memcpy(stream_dither, frame_dither,
+               frame_len / stream_nozzles * sizeof(printspider_dither_t));
+    }
+    switch (frame_type) {
+        case STREAM_ROW_PACKED:
+        case STREAM_ROW_BYTES:
+            frames++;
+            return STREAM_EVENT_ROW;
+        case STREAM_LINE_PACKED:
+        case STREAM_LINE_BYTES:
+            frames++;
+            return STREAM_EVENT_LINE;
+        case STREAM_STATUS_REQUEST:
+            return STREAM_EVENT_STATUS;
+        case STREAM_PROFILE_REQUEST:
+            return STREAM_EVENT_PROFILE;
+        default:
+            return STREAM_EVENT_END;
+    }
+}
+
+void stream_begin(uint8_t channels, uint8_t line_channels, uint8_t nozzles,
+                  printspider_dither_t *dither) {
+    stream_channels = channels;
+    stream_line_channels = line_channels;
+    stream_nozzles = nozzles;
+    stream_row_bytes = (nozzles + 7) / 8;
+    stream_dither = dither;
+    state = STATE_SYNC;
+    consumed = 0;
+    uart_init(STREAM_BAUD);
+    send_credit(UART_RX_BUFFER_SIZE);
+}
+
+uint8_t stream_poll(void) {
+    int c;
+    uint8_t event = STREAM_EVENT_NONE;
+    while (event == STREAM_EVENT_NONE && (c = uart_read()) >= 0) {
+        if (++consumed == STREAM_CREDIT_CHUNK) {
+            send_credit(consumed);
+            consumed = 0;
+        }
+        switch (state) {
+            case STATE_SYNC:
+                if (c == STREAM_SYNC) state = STATE_TYPE;
+                break;
+            case STATE_TYPE:
+                frame_type = c;
+                frame_crc = crc8_update(0, c);
+                state = STATE_LEN_LO;
+                break;
+            case STATE_LEN_LO:
+                frame_len = c;
+                frame_crc = crc8_update(frame_crc, c);
+                state = STATE_LEN_HI;
+                break;
+            case STATE_LEN_HI:
+                frame_len |= (uint16_t)c << 8;
+                frame_crc = crc8_update(frame_crc, c);
+                frame_pos = 0;
+                if (payload_length(frame_type) != (int)frame_len) {
+                    // Look for the next frame instead of skipping a length
+                    // that may be garbage itself.
+                    frame_errors++;
+                    state = STATE_SYNC;
+                } else {
+                    state = frame_len ? STATE_PAYLOAD : STATE_CRC;
+                    if (frame_type == STREAM_ROW_BYTES ||
+                        frame_type == STREAM_LINE_BYTES) {
+                        memcpy(frame_dither, stream_dither,
+                               frame_len / stream_nozzles *
+                                   sizeof(printspider_dither_t));
+                    }
+                }
+                break;
+            case STATE_PAYLOAD:
+                frame_crc = crc8_update(frame_crc, c);
+                payload_byte(c);
+                if (++frame_pos == frame_len) state = STATE_CRC;
+                break;
+            case STATE_CRC:
+                event = frame_done(c);
+                state = STATE_SYNC;
+                break;
+        }
+    }
+    return event;
+}
+
+const uint8_t *stream_row_bits(uint8_t channel) {
+    return row_bits + channel * stream_row_bytes;
+}
+
+void stream_send_status(stream_status_t *status) {
+    overruns += uart_take_overruns();
+    status->frames = frames;
+    status->crc_errors = crc_errors;
+    status->frame_errors = frame_errors;
+    status->overruns = overruns;
+    const uint16_t fields[] = {status->rows,           status->underruns,
+                               status->deferred_rows,  status->deferred_nozzles,
+                               status->frames,         status->crc_errors,
+                               status->frame_errors,   status->overruns,
+                               status->dropped_nozzles};
+    uint8_t payload[sizeof(fields)];
+    for (uint8_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        payload[2 * i] = fields[i] & 0xff;
+        payload[2 * i + 1] = fields[i] >> 8;
+    }
+    send_frame(STREAM_STATUS, payload, sizeof(payload));
+}
+
+void stream_send_profile(const char *line) {
+    send_frame(STREAM_PROFILE, (const uint8_t *)line, strlen(line));
+}
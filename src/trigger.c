@@ -0,0 +1,78 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "trigger.h"
+
+#ifdef PRINT_TRIGGERED
+
+#include <util/atomic.h>
+
+#include "Arduino.h"
+#include "pipeline.h"
+
+// Encoder channels A and B on PC0 (A0) and PC1 (A1), PCINT8 and PCINT9.
+#define TRIGGER_PINS 0x03
+
+// Count for an old and a new channel state, index (old << 2) | new with the
+// states in the order 0, 1, 3, 2 going forward. 2 for an edge of both
+// channels.
+static const int8_t steps[16] PROGMEM = {0, 1, -1, 2, -1, 0, 2,  1,
+                                         1, 2, 0,  -1, 2, -1, 1, 0};
+
+static uint8_t state;
+static volatile int16_t position;
+// Position where the next row is due.
+static int16_t next;
+static volatile uint16_t errors;
+
+ISR(PCINT1_vect) {
+    uint8_t now = PINC & TRIGGER_PINS;
+    int8_t step = pgm_read_byte(&steps[(state << 2) | now]);
+    state = now;
+    if (step == 2) {
+        errors++;
+        return;
+    }
+    position += step;
+    if ((int16_t)(position - next) >= 0) {
+        next += TRIGGER_DIVIDER;
+        pipeline_trigger(micros());
+    }
+}
+
+void trigger_start(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        DDRC &= ~TRIGGER_PINS;
+        // Pull-ups for open collector encoders.
+        PORTC |= TRIGGER_PINS;
+        state = PINC & TRIGGER_PINS;
+        position = 0;
+        next = TRIGGER_DIVIDER;
+        errors = 0;
+        PCMSK1 |= TRIGGER_PINS;
+        PCIFR = _BV(PCIF1);
+        PCICR |= _BV(PCIE1);
+    }
+}
+
+void trigger_get_stats(trigger_stats_t *stats) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        stats->position = position;
+        stats->errors = errors;
+    }
+}
+
+#endif
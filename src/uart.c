@@ -0,0 +1,90 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "uart.h"
+
+#include <util/atomic.h>
+
+#include "Arduino.h"
+
+#if UART_RX_BUFFER_SIZE > 256 || (UART_RX_BUFFER_SIZE & (UART_RX_BUFFER_SIZE - 1))
+#error "UART_RX_BUFFER_SIZE must be a power of two up to 256"
+#endif
+
+static uint8_t rx_buffer[UART_RX_BUFFER_SIZE];
+static volatile uint8_t rx_head;
+static volatile uint8_t rx_tail;
+// Distinguishes a full buffer from an empty one when the size is 256.
+static volatile uint16_t rx_count;
+static volatile uint16_t rx_overruns;
+
+ISR(USART_RX_vect) {
+    uint8_t c = UDR0;
+    if (rx_count >= UART_RX_BUFFER_SIZE) {
+        rx_overruns++;
+        return;
+    }
+    rx_buffer[rx_head] = c;
+    rx_head = (rx_head + 1) & (UART_RX_BUFFER_SIZE - 1);
+    rx_count++;
+}
+
+void uart_init(uint32_t baud) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        UCSR0A = _BV(U2X0);
+        UBRR0 = (F_CPU / 8 + baud / 2) / baud - 1;
+        UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);
+        UCSR0B = _BV(RXEN0) | _BV(TXEN0) | _BV(RXCIE0);
+        rx_head = rx_tail = 0;
+        rx_count = 0;
+    }
+}
+
+uint16_t uart_available(void) {
+    uint16_t count;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { count = rx_count; }
+    return count;
+}
+
+int uart_read(void) {
+    uint8_t c;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (!rx_count) return -1;
+        c = rx_buffer[rx_tail];
+        rx_tail = (rx_tail + 1) & (UART_RX_BUFFER_SIZE - 1);
+        rx_count--;
+    }
+    return c;
+}
+
+uint16_t uart_take_overruns(void) {
+    uint16_t overruns;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        overruns = rx_overruns;
+        rx_overruns = 0;
+    }
+    return overruns;
+}
+
+void uart_write(uint8_t c) {
+    while (!(UCSR0A & _BV(UDRE0))) {
+    }
+    UDR0 = c;
+}
+
+void uart_write_buffer(const uint8_t *buffer, uint16_t len) {
+    while (len--) uart_write(*buffer++);
+}
@@ -0,0 +1,156 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Tests of printspider_cache.c against generating and converting the
+// packets, over a label of blank, text and solid rows, with the cache
+// converting its missed packets and generating them as port pairs.
+//
+// Run with: pio test -e native
+
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "printspider.h"
+#include "printspider_cache.h"
+#include "printspider_port.h"
+#include "printspider_portgen.h"
+
+// Cartridge pins of the firmware, bus[i] carries bit i of a waveform word.
+static const uint8_t bus[PRINTSPIDER_PORT_LINES] = {0, 1, 2, 3, 5, 7,
+                                                    4, 8, 9, 6, 10, 11};
+
+#define LABEL_ROWS 64
+#define WAVEFORM_BUFFER_LEN 600
+
+static uint8_t label[LABEL_ROWS][PRINTSPIDER_NOZDATA_SZ];
+static printspider_portmap_t portmap;
+static uint16_t ref[WAVEFORM_BUFFER_LEN];
+static uint16_t out[WAVEFORM_BUFFER_LEN];
+
+// Nozzle data of a label: mostly blank rows, rows of text in the middle of
+// the nozzles with blank margins, and solid bars.
+static void make_label(void) {
+    uint32_t x = 88172645UL;
+    memset(label, 0, sizeof(label));
+    for (int y = 0; y < LABEL_ROWS; y++) {
+        int kind = y % 16;
+        if (kind >= 4 && kind < 10) {
+            for (int i = 14; i < 28; i++) {
+                x ^= x << 13;
+                x ^= x >> 17;
+                x ^= x << 5;
+                label[y][i] = x & 0x7e;
+            }
+        } else if (kind >= 12) {
+            memset(label[y], 0xff, sizeof(label[y]));
+        }
+    }
+}
+
+// Generates and converts every packet of a row, the reference output.
+static int generate_converted(const printspider_waveform_desc_t *wf,
+                              const uint8_t *nozdata, uint16_t *w) {
+    int len = printspider_generate_waveform(w, wf->data, nozdata, wf->len);
+    printspider_portmap_convert(&portmap, w, len);
+    return len;
+}
+
+void setUp(void) {
+    printspider_portmap_init(&portmap, bus, PRINTSPIDER_PORT_LINES);
+    make_label();
+}
+
+void tearDown(void) {}
+
+static printspider_cache_t cache;
+static printspider_portgen_t portgen;
+
+// Gets every packet of a row from the cache; blank rows produce all-low
+// words.
+static int cached_row(const printspider_waveform_desc_t *wf,
+                      const uint8_t *nozdata, uint16_t *w) {
+    printspider_waveform_cursor_t cursor;
+    printspider_waveform_begin_fast(&cursor, wf, nozdata);
+    const uint16_t *pairs;
+    int len;
+    int total = 0;
+    while ((pairs = printspider_cache_next_packet(&cache, &cursor, &len)) ||
+           len) {
+        if (pairs) {
+            memcpy(&w[total], pairs, len * sizeof(*pairs));
+        } else {
+            memset(&w[total], 0, len * sizeof(*w));
+        }
+        total += len;
+    }
+    return total;
+}
+
+// Runs the label through the cache twice, so the second pass hits the
+// packets of the first.
+static void check_label(int use_portgen) {
+    char message[64];
+    for (int t = 0; t < 4; t++) {
+        printspider_waveform_desc_t wf = printspider_get_waveform(t);
+        printspider_cache_init(&cache, &portmap);
+        if (use_portgen) printspider_cache_use_portgen(&cache, &portgen);
+        for (int pass = 0; pass < 2; pass++) {
+            for (int y = 0; y < LABEL_ROWS; y++) {
+                int len = generate_converted(&wf, label[y], ref);
+                snprintf(message, sizeof(message), "template %d row %d", t,
+                         y);
+                TEST_ASSERT_EQUAL_INT_MESSAGE(
+                    len, cached_row(&wf, label[y], out), message);
+                TEST_ASSERT_EQUAL_MEMORY_MESSAGE(ref, out, len * 2, message);
+            }
+        }
+        // 6 of every 16 label rows are blank.
+        TEST_ASSERT_EQUAL_INT(2 * 6 * LABEL_ROWS / 16,
+                              cache.stats.blank_rows);
+        TEST_ASSERT_TRUE(cache.stats.hits > 0);
+    }
+}
+
+static void test_label_converted(void) {
+    check_label(0);
+}
+
+static void test_label_portgen(void) {
+    check_label(1);
+}
+
+// A cache cleared after the port map changed gives the pairs of the new map.
+static void test_clear(void) {
+    static const uint8_t reversed[PRINTSPIDER_PORT_LINES] = {
+        11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0};
+    printspider_waveform_desc_t wf = printspider_get_waveform(0);
+    printspider_cache_init(&cache, &portmap);
+    cached_row(&wf, label[12], out);
+    printspider_portmap_init(&portmap, reversed, PRINTSPIDER_PORT_LINES);
+    printspider_cache_clear(&cache);
+    int len = generate_converted(&wf, label[12], ref);
+    TEST_ASSERT_EQUAL_INT(len, cached_row(&wf, label[12], out));
+    TEST_ASSERT_EQUAL_MEMORY(ref, out, len * 2);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_label_converted);
+    RUN_TEST(test_label_portgen);
+    RUN_TEST(test_clear);
+    return UNITY_END();
+}
@@ -0,0 +1,173 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Tests of printspider_dual.c: packets of a color and a black row merged
+// into port triples, against the words of both rows generated on their own.
+//
+// Run with: pio test -e native
+
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "printspider.h"
+#include "printspider_dual.h"
+#include "printspider_port.h"
+
+// Cartridge pins of the firmware, bus[i] carries bit i of a waveform word.
+static const uint8_t bus[PRINTSPIDER_PORT_LINES] = {0, 1, 2, 3, 5, 7,
+                                                    4, 8, 9, 6, 10, 11};
+
+#define WAVEFORM_BUFFER_LEN 600
+
+static printspider_portmap_t portmap;
+static printspider_waveform_desc_t color;
+static printspider_waveform_desc_t black;
+static uint16_t wa[WAVEFORM_BUFFER_LEN];
+static uint16_t wb[WAVEFORM_BUFFER_LEN];
+static uint8_t triples[3 * WAVEFORM_BUFFER_LEN];
+
+void setUp(void) {
+    printspider_portmap_init(&portmap, bus, PRINTSPIDER_PORT_LINES);
+    color = printspider_get_waveform(PRINTSPIDER_WAVEFORM_COLOR_B);
+    black = printspider_get_waveform(PRINTSPIDER_WAVEFORM_BLACK_B);
+}
+
+void tearDown(void) {}
+
+static void random_row(uint32_t *seed, uint8_t *nozdata) {
+    for (int i = 0; i < PRINTSPIDER_NOZDATA_SZ; i++) {
+        *seed = *seed * 1103515245u + 12345u;
+        nozdata[i] = *seed >> 16;
+    }
+}
+
+// Merges both rows a packet at a time, blank packets as all-low triples.
+// Returns the amount of triples.
+static int merge_rows(const uint8_t *nozdata_a, const uint8_t *nozdata_b) {
+    printspider_dual_cursor_t cursor;
+    printspider_dual_begin(&cursor, &portmap, &color, nozdata_a, &black,
+                           nozdata_b);
+    const uint8_t *p;
+    int len;
+    int total = 0;
+    while ((p = printspider_dual_next_packet(&cursor, &len)) || len) {
+        if (p) {
+            memcpy(&triples[3 * total], p, 3 * len);
+        } else {
+            memset(&triples[3 * total], 0, 3 * len);
+        }
+        total += len;
+    }
+    return total;
+}
+
+// Words of a row; a blank row is a full waveform without nozzles when the
+// other row prints.
+static int row_words(const printspider_waveform_desc_t *wf,
+                     const uint8_t *nozdata, int other_blank, uint16_t *w) {
+    static const uint8_t blank[PRINTSPIDER_NOZDATA_SZ];
+    printspider_waveform_cursor_t cursor;
+    printspider_waveform_begin_fast(&cursor, wf, nozdata);
+    if (!other_blank && !memcmp(nozdata, blank, sizeof(blank))) {
+        cursor.is_empty = 0;
+    }
+    int total = 0;
+    int p;
+    while ((p = printspider_waveform_next_packet(&cursor, &w[total]))) {
+        total += p;
+    }
+    return total;
+}
+
+static void check_rows(const uint8_t *nozdata_a, const uint8_t *nozdata_b,
+                       const char *message) {
+    static const uint8_t blank[PRINTSPIDER_NOZDATA_SZ];
+    int blank_a = !memcmp(nozdata_a, blank, sizeof(blank));
+    int blank_b = !memcmp(nozdata_b, blank, sizeof(blank));
+    int len = row_words(&color, nozdata_a, blank_b, wa);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        len, row_words(&black, nozdata_b, blank_a, wb), message);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(len, merge_rows(nozdata_a, nozdata_b),
+                                  message);
+    for (int i = 0; i < len; i++) {
+        uint16_t pair = printspider_portmap_word(
+            &portmap, wa[i] | (wb[i] & PRINTSPIDER_DUAL_SHARED));
+        // The shared lines are the same in both waveforms.
+        TEST_ASSERT_EQUAL_HEX32_MESSAGE(wa[i] & PRINTSPIDER_DUAL_SHARED,
+                                        wb[i] & PRINTSPIDER_DUAL_SHARED,
+                                        message);
+        TEST_ASSERT_EQUAL_HEX32_MESSAGE(pair & 0xff, triples[3 * i], message);
+        TEST_ASSERT_EQUAL_HEX32_MESSAGE(pair >> 8, triples[3 * i + 1],
+                                        message);
+        TEST_ASSERT_EQUAL_HEX32_MESSAGE(
+            (wb[i] & 0x0f) | ((wb[i] >> 6) & 0x30), triples[3 * i + 2],
+            message);
+    }
+}
+
+// The templates drive the shared lines alike; one with a shared line
+// changed at any step, or of another length, is refused.
+static void test_compatible(void) {
+    uint16_t tp[PRINTSPIDER_DUAL_PACKET_LEN];
+    TEST_ASSERT_TRUE(printspider_dual_compatible(&color, &black));
+    for (int i = 0; i < black.len; i++) {
+        printspider_waveform_desc_t changed = black;
+        memcpy(tp, black.data, black.len * sizeof(*tp));
+        tp[i] ^= 1 << 8;
+        changed.data = tp;
+        changed.steps = NULL;
+        TEST_ASSERT_FALSE(printspider_dual_compatible(&color, &changed));
+        changed.data = black.data;
+        changed.len = black.len - 1;
+        TEST_ASSERT_FALSE(printspider_dual_compatible(&color, &changed));
+    }
+}
+
+static void test_random_rows(void) {
+    char message[32];
+    uint32_t seed = 5;
+    uint8_t nozdata_a[PRINTSPIDER_NOZDATA_SZ];
+    uint8_t nozdata_b[PRINTSPIDER_NOZDATA_SZ];
+    for (int n = 0; n < 64; n++) {
+        random_row(&seed, nozdata_a);
+        random_row(&seed, nozdata_b);
+        snprintf(message, sizeof(message), "row %d", n);
+        check_rows(nozdata_a, nozdata_b, message);
+    }
+}
+
+// A blank row next to a printing one gets its full waveform, with the data
+// lines high; two blank rows are all low.
+static void test_blank_rows(void) {
+    static const uint8_t blank[PRINTSPIDER_NOZDATA_SZ];
+    uint8_t nozdata[PRINTSPIDER_NOZDATA_SZ];
+    uint32_t seed = 9;
+    random_row(&seed, nozdata);
+    check_rows(blank, nozdata, "color blank");
+    check_rows(nozdata, blank, "black blank");
+    int len = merge_rows(blank, blank);
+    TEST_ASSERT_EQUAL_INT(printspider_waveform_length(color.len), len);
+    for (int i = 0; i < 3 * len; i++) TEST_ASSERT_EQUAL_HEX32(0, triples[i]);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_compatible);
+    RUN_TEST(test_random_rows);
+    RUN_TEST(test_blank_rows);
+    return UNITY_END();
+}
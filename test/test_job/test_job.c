@@ -0,0 +1,172 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Tests of printspider_job.c: label rows compiled as tools/ps_job does, each
+// row its own job, play back as the converted waveform.
+//
+// Run with: pio test -e native
+
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "printspider.h"
+#include "printspider_job.h"
+#include "printspider_port.h"
+
+// Cartridge pins of the firmware, bus[i] carries bit i of a waveform word.
+static const uint8_t bus[PRINTSPIDER_PORT_LINES] = {0, 1, 2, 3, 5, 7,
+                                                    4, 8, 9, 6, 10, 11};
+
+#define LABEL_ROWS 64
+#define WAVEFORM_BUFFER_LEN 600
+
+static uint8_t label[LABEL_ROWS][PRINTSPIDER_NOZDATA_SZ];
+static printspider_portmap_t portmap;
+static uint16_t ref[WAVEFORM_BUFFER_LEN];
+static uint16_t out[WAVEFORM_BUFFER_LEN];
+
+// Nozzle data of a label: mostly blank rows, rows of text in the middle of
+// the nozzles with blank margins, and solid bars.
+static void make_label(void) {
+    uint32_t x = 88172645UL;
+    memset(label, 0, sizeof(label));
+    for (int y = 0; y < LABEL_ROWS; y++) {
+        int kind = y % 16;
+        if (kind >= 4 && kind < 10) {
+            for (int i = 14; i < 28; i++) {
+                x ^= x << 13;
+                x ^= x >> 17;
+                x ^= x << 5;
+                label[y][i] = x & 0x7e;
+            }
+        } else if (kind >= 12) {
+            memset(label[y], 0xff, sizeof(label[y]));
+        }
+    }
+}
+
+// Generates and converts every packet of a row, the reference output.
+static int generate_converted(const printspider_waveform_desc_t *wf,
+                              const uint8_t *nozdata, uint16_t *w) {
+    int len = printspider_generate_waveform(w, wf->data, nozdata, wf->len);
+    printspider_portmap_convert(&portmap, w, len);
+    return len;
+}
+
+void setUp(void) {
+    printspider_portmap_init(&portmap, bus, PRINTSPIDER_PORT_LINES);
+    make_label();
+}
+
+void tearDown(void) {}
+
+// Job data of every label row. A packet of n pairs takes at most 1 + 3 * n
+// bytes.
+#define LABEL_JOB_BYTES (LABEL_ROWS * 4 * WAVEFORM_BUFFER_LEN)
+
+static uint8_t job[LABEL_JOB_BYTES];
+static int job_starts[LABEL_ROWS];
+
+// Compiles the label rows into `job`, with the offset of every row in
+// `job_starts`. Returns the amount of bytes.
+static int compile_label(const printspider_waveform_desc_t *wf) {
+    static const uint8_t blank[PRINTSPIDER_NOZDATA_SZ];
+    int pos = 0;
+    for (int y = 0; y < LABEL_ROWS; y++) {
+        job_starts[y] = pos;
+        int len = generate_converted(wf, label[y], ref);
+        if (!memcmp(label[y], blank, sizeof(blank))) {
+            pos += printspider_job_encode_idle(&job[pos], len);
+        } else {
+            printspider_waveform_cursor_t cursor;
+            printspider_waveform_begin(&cursor, wf->data, label[y], wf->len);
+            int n;
+            int i = 0;
+            while ((n = printspider_waveform_skip_packet(&cursor))) {
+                int bytes =
+                    printspider_job_encode_packet(&job[pos], &ref[i], n);
+                TEST_ASSERT_TRUE(bytes <= PRINTSPIDER_JOB_PACKET_BYTES(n));
+                pos += bytes;
+                i += n;
+            }
+        }
+        job[pos++] = 0;
+    }
+    return pos;
+}
+
+// Plays a compiled row back; blank rows produce all-low words.
+static int play_row(const uint8_t *row, uint16_t *w) {
+    printspider_job_t j = {0, 1, row};
+    printspider_job_reader_t reader;
+    printspider_job_open(&reader, &j);
+    uint16_t pairs[PRINTSPIDER_JOB_PACKET_LEN];
+    const uint16_t *p;
+    int len;
+    int total = 0;
+    while ((p = printspider_job_next_packet(&reader, pairs, &len)) || len) {
+        if (p) {
+            memcpy(&w[total], p, len * sizeof(*p));
+        } else {
+            memset(&w[total], 0, len * sizeof(*w));
+        }
+        total += len;
+    }
+    return total;
+}
+
+static void test_label(void) {
+    char message[64];
+    for (int t = 0; t < 4; t++) {
+        printspider_waveform_desc_t wf = printspider_get_waveform(t);
+        int bytes = compile_label(&wf);
+        TEST_ASSERT_TRUE(bytes <= LABEL_JOB_BYTES);
+        for (int y = 0; y < LABEL_ROWS; y++) {
+            int len = generate_converted(&wf, label[y], ref);
+            snprintf(message, sizeof(message), "template %d row %d", t, y);
+            TEST_ASSERT_EQUAL_INT_MESSAGE(
+                len, play_row(&job[job_starts[y]], out), message);
+            TEST_ASSERT_EQUAL_MEMORY_MESSAGE(ref, out, len * 2, message);
+        }
+    }
+}
+
+// Packets of all-different pairs and of a single repeated pair, the two
+// extremes of the run length coding.
+static void test_packet_extremes(void) {
+    uint16_t pairs[PRINTSPIDER_JOB_PACKET_LEN];
+    uint8_t data[PRINTSPIDER_JOB_PACKET_BYTES(PRINTSPIDER_JOB_PACKET_LEN) + 1];
+    for (int repeat = 0; repeat < 2; repeat++) {
+        for (int i = 0; i < PRINTSPIDER_JOB_PACKET_LEN; i++) {
+            pairs[i] = repeat ? 0x0a55 : i * 0x0101;
+        }
+        int bytes = printspider_job_encode_packet(data, pairs,
+                                                  PRINTSPIDER_JOB_PACKET_LEN);
+        TEST_ASSERT_TRUE(
+            bytes <= PRINTSPIDER_JOB_PACKET_BYTES(PRINTSPIDER_JOB_PACKET_LEN));
+        data[bytes] = 0;
+        TEST_ASSERT_EQUAL_INT(PRINTSPIDER_JOB_PACKET_LEN, play_row(data, out));
+        TEST_ASSERT_EQUAL_MEMORY(pairs, out, sizeof(pairs));
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_label);
+    RUN_TEST(test_packet_extremes);
+    return UNITY_END();
+}
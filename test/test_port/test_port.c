@@ -0,0 +1,78 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Tests of printspider_port.c, with the cartridge pins of the firmware.
+//
+// Run with: pio test -e native
+
+#include <unity.h>
+
+#include "printspider_port.h"
+
+// Cartridge pins of the firmware, bus[i] carries bit i of a waveform word.
+static const uint8_t bus[PRINTSPIDER_PORT_LINES] = {0, 1, 2, 3, 5, 7,
+                                                    4, 8, 9, 6, 10, 11};
+
+static printspider_portmap_t portmap;
+
+void setUp(void) {
+    printspider_portmap_init(&portmap, bus, PRINTSPIDER_PORT_LINES);
+}
+
+void tearDown(void) {}
+
+// Moves every bit of a waveform word to the bit of its pin, one at a time.
+static uint16_t map_bits(uint16_t w) {
+    uint16_t pair = 0;
+    for (int i = 0; i < PRINTSPIDER_PORT_LINES; i++) {
+        if (w & (1 << i)) pair |= 1 << bus[i];
+    }
+    return pair;
+}
+
+// All 4096 waveform words translate like their bits one at a time.
+static void test_word(void) {
+    for (uint16_t w = 0; w < 1 << PRINTSPIDER_PORT_LINES; w++) {
+        TEST_ASSERT_EQUAL_HEX32(map_bits(w),
+                                printspider_portmap_word(&portmap, w));
+    }
+}
+
+// The mask has the bit of every pin of the bus.
+static void test_mask(void) {
+    TEST_ASSERT_EQUAL_HEX32(map_bits((1 << PRINTSPIDER_PORT_LINES) - 1),
+                            portmap.mask);
+}
+
+// A buffer converted in place holds the translation of every word.
+static void test_convert(void) {
+    static uint16_t buf[1 << PRINTSPIDER_PORT_LINES];
+    for (int i = 0; i < 1 << PRINTSPIDER_PORT_LINES; i++) {
+        buf[i] = (i * 2654435761u) >> 20;
+    }
+    printspider_portmap_convert(&portmap, buf, 1 << PRINTSPIDER_PORT_LINES);
+    for (int i = 0; i < 1 << PRINTSPIDER_PORT_LINES; i++) {
+        TEST_ASSERT_EQUAL_HEX32(map_bits((i * 2654435761u) >> 20), buf[i]);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_word);
+    RUN_TEST(test_mask);
+    RUN_TEST(test_convert);
+    return UNITY_END();
+}
@@ -0,0 +1,118 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Tests of printspider_portgen.c against generating and converting the
+// packets, over a label of blank, text and solid rows.
+//
+// Run with: pio test -e native
+
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "printspider.h"
+#include "printspider_port.h"
+#include "printspider_portgen.h"
+
+// Cartridge pins of the firmware, bus[i] carries bit i of a waveform word.
+static const uint8_t bus[PRINTSPIDER_PORT_LINES] = {0, 1, 2, 3, 5, 7,
+                                                    4, 8, 9, 6, 10, 11};
+
+#define LABEL_ROWS 64
+#define WAVEFORM_BUFFER_LEN 600
+
+static uint8_t label[LABEL_ROWS][PRINTSPIDER_NOZDATA_SZ];
+static printspider_portmap_t portmap;
+static uint16_t ref[WAVEFORM_BUFFER_LEN];
+static uint16_t out[WAVEFORM_BUFFER_LEN];
+
+// Nozzle data of a label: mostly blank rows, rows of text in the middle of
+// the nozzles with blank margins, and solid bars.
+static void make_label(void) {
+    uint32_t x = 88172645UL;
+    memset(label, 0, sizeof(label));
+    for (int y = 0; y < LABEL_ROWS; y++) {
+        int kind = y % 16;
+        if (kind >= 4 && kind < 10) {
+            for (int i = 14; i < 28; i++) {
+                x ^= x << 13;
+                x ^= x >> 17;
+                x ^= x << 5;
+                label[y][i] = x & 0x7e;
+            }
+        } else if (kind >= 12) {
+            memset(label[y], 0xff, sizeof(label[y]));
+        }
+    }
+}
+
+// Generates and converts every packet of a row, the reference output.
+static int generate_converted(const printspider_waveform_desc_t *wf,
+                              const uint8_t *nozdata, uint16_t *w) {
+    int len = printspider_generate_waveform(w, wf->data, nozdata, wf->len);
+    printspider_portmap_convert(&portmap, w, len);
+    return len;
+}
+
+void setUp(void) {
+    printspider_portmap_init(&portmap, bus, PRINTSPIDER_PORT_LINES);
+    make_label();
+}
+
+void tearDown(void) {}
+
+// Port pairs of every template and label row match the converted waveform.
+static void test_label(void) {
+    char message[64];
+    for (int t = 0; t < 4; t++) {
+        printspider_waveform_desc_t wf = printspider_get_waveform(t);
+        printspider_portgen_t portgen;
+        TEST_ASSERT_EQUAL_INT(0, printspider_portgen_init(&portgen, &portmap,
+                                                          wf.steps, wf.len));
+        for (int y = 0; y < LABEL_ROWS; y++) {
+            int len = generate_converted(&wf, label[y], ref);
+            printspider_waveform_cursor_t cursor;
+            printspider_waveform_begin_fast(&cursor, &wf, label[y]);
+            int total = 0;
+            int p;
+            while ((p = printspider_portgen_next_packet(&portgen, &cursor,
+                                                        &out[total]))) {
+                total += p;
+            }
+            snprintf(message, sizeof(message), "template %d row %d", t, y);
+            TEST_ASSERT_EQUAL_INT_MESSAGE(len, total, message);
+            TEST_ASSERT_EQUAL_MEMORY_MESSAGE(ref, out, len * 2, message);
+        }
+    }
+}
+
+// Templates without precomputed steps, or with too many, are refused.
+static void test_init_refused(void) {
+    printspider_waveform_desc_t wf = printspider_get_waveform(0);
+    printspider_portgen_t portgen;
+    TEST_ASSERT_EQUAL_INT(-1, printspider_portgen_init(&portgen, &portmap,
+                                                       NULL, wf.len));
+    TEST_ASSERT_EQUAL_INT(
+        -1, printspider_portgen_init(&portgen, &portmap, wf.steps,
+                                     PRINTSPIDER_PORTGEN_STEPS + 1));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_label);
+    RUN_TEST(test_init_refused);
+    return UNITY_END();
+}
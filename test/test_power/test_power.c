@@ -0,0 +1,160 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Tests of printspider_power.c: solid and random black rows through the
+// budget, deferred to the next rows and split into sub-passes.
+//
+// Run with: pio test -e native
+
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "printspider.h"
+#include "printspider_power.h"
+
+#define POWER_ROWS 64
+
+static uint32_t seed;
+static char message[96];
+
+void setUp(void) {
+    seed = 1;
+}
+
+void tearDown(void) {}
+
+static int count_bits(uint8_t v) {
+    int n = 0;
+    for (; v; v &= v - 1) n++;
+    return n;
+}
+
+static int count_nozzles(const uint8_t *nozdata) {
+    int n = 0;
+    for (int i = 0; i < PRINTSPIDER_NOZDATA_SZ; i++) {
+        n += count_bits(nozdata[i]);
+    }
+    return n;
+}
+
+// A solid row, or a random one with up to 3 nozzles per group.
+static void make_row(int solid, uint8_t *nozdata) {
+    for (int i = 0; i < PRINTSPIDER_NOZDATA_SZ; i++) {
+        seed = seed * 1103515245u + 12345u;
+        nozdata[i] = solid ? 0xff : (seed >> 16) & 0x11;
+    }
+}
+
+// Whether any power group of any packet of `out` fires more than `budget`
+// nozzles.
+static int over_budget(const uint8_t *out, int budget) {
+    for (int j = 0; j < PRINTSPIDER_PACKETS; j++) {
+        for (int shift = 0; shift <= 4; shift += 4) {
+            int n = 0;
+            for (int line = 0; line < 3; line++) {
+                n += count_bits((out[line * 14 + j] >> shift) & 0x0f);
+            }
+            if (n > budget) return 1;
+        }
+    }
+    return 0;
+}
+
+// Every drop deferred to the next rows is fired or counted as dropped, and
+// only solid areas over the budget lose drops.
+static void test_limit(void) {
+    for (int solid = 0; solid < 2; solid++) {
+        for (uint8_t budget = 1; budget <= PRINTSPIDER_POWER_GROUP_NOZZLES;
+             budget++) {
+            printspider_power_t power;
+            printspider_power_init(&power, budget);
+            long requested = 0;
+            long fired = 0;
+            snprintf(message, sizeof(message), "%s rows, budget %u",
+                     solid ? "solid" : "random", budget);
+            for (int row = 0;
+                 row < POWER_ROWS || printspider_power_pending(&power);
+                 row++) {
+                uint8_t nozdata[PRINTSPIDER_NOZDATA_SZ] = {0};
+                uint8_t out[PRINTSPIDER_NOZDATA_SZ] = {0};
+                if (row < POWER_ROWS) make_row(solid, nozdata);
+                requested += count_nozzles(nozdata);
+                printspider_power_limit(&power, nozdata, out);
+                fired += count_nozzles(out);
+                TEST_ASSERT_FALSE_MESSAGE(over_budget(out, budget), message);
+                TEST_ASSERT_TRUE_MESSAGE(row < 1000, message);
+            }
+            TEST_ASSERT_EQUAL_INT_MESSAGE(
+                requested, fired + power.dropped_nozzles, message);
+            if (!solid && budget >= 3) {
+                TEST_ASSERT_EQUAL_INT_MESSAGE(0, power.dropped_nozzles,
+                                              message);
+            }
+        }
+    }
+}
+
+// Sub-passes fire every drop of the row exactly once, within the budget, and
+// as few sub-passes as the fullest group needs.
+static void test_take(void) {
+    for (int solid = 0; solid < 2; solid++) {
+        for (uint8_t budget = 1; budget <= PRINTSPIDER_POWER_GROUP_NOZZLES;
+             budget++) {
+            printspider_power_t power;
+            printspider_power_init(&power, budget);
+            snprintf(message, sizeof(message), "%s rows, budget %u",
+                     solid ? "solid" : "random", budget);
+            for (int row = 0; row < POWER_ROWS; row++) {
+                uint8_t nozdata[PRINTSPIDER_NOZDATA_SZ];
+                uint8_t pending[PRINTSPIDER_NOZDATA_SZ];
+                uint8_t fired[PRINTSPIDER_NOZDATA_SZ] = {0};
+                make_row(solid, nozdata);
+                memcpy(pending, nozdata, sizeof(pending));
+                int passes = 0;
+                uint16_t left;
+                do {
+                    uint8_t out[PRINTSPIDER_NOZDATA_SZ] = {0};
+                    left = printspider_power_take(&power, pending, out);
+                    TEST_ASSERT_FALSE_MESSAGE(over_budget(out, budget),
+                                              message);
+                    for (int i = 0; i < PRINTSPIDER_NOZDATA_SZ; i++) {
+                        TEST_ASSERT_FALSE_MESSAGE(fired[i] & out[i], message);
+                        fired[i] |= out[i];
+                    }
+                    TEST_ASSERT_EQUAL_INT_MESSAGE(left, count_nozzles(pending),
+                                                  message);
+                    passes++;
+                } while (left);
+                TEST_ASSERT_EQUAL_MEMORY_MESSAGE(nozdata, fired, sizeof(fired),
+                                                 message);
+                if (solid) {
+                    TEST_ASSERT_EQUAL_INT_MESSAGE(
+                        (PRINTSPIDER_POWER_GROUP_NOZZLES + budget - 1) / budget,
+                        passes, message);
+                }
+            }
+            TEST_ASSERT_EQUAL_INT_MESSAGE(0, power.dropped_nozzles, message);
+        }
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_limit);
+    RUN_TEST(test_take);
+    return UNITY_END();
+}
@@ -0,0 +1,347 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Tests of printspider.c: the nozzle setters, every way of generating a
+// waveform against printspider_generate_waveform, and the decoder.
+//
+// Run with: pio test -e native
+
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "printspider.h"
+
+#define WAVEFORM_BUFFER_LEN 600
+#define ROWS_PER_TEMPLATE 256
+
+static const char *waveform_names[4] = {"color_a", "color_b", "black_a",
+                                        "black_b"};
+
+static uint16_t ref[WAVEFORM_BUFFER_LEN];
+static uint16_t out[WAVEFORM_BUFFER_LEN];
+static char message[128];
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static int count_bits(uint8_t v) {
+    int n = 0;
+    for (; v; v &= v - 1) n++;
+    return n;
+}
+
+static int count_nozzles(const uint8_t *nozdata) {
+    int n = 0;
+    for (int i = 0; i < PRINTSPIDER_NOZDATA_SZ; i++) {
+        n += count_bits(nozdata[i]);
+    }
+    return n;
+}
+
+// Row n of a seeded sequence sets a nozzle with chance (n / 16 + 1) / 16, so
+// the rows go from sparse to full.
+static void random_row(uint32_t *seed, int n, uint8_t *nozdata) {
+    for (int i = 0; i < PRINTSPIDER_NOZDATA_SZ; i++) {
+        uint8_t b = 0;
+        for (int k = 0; k < 8; k++) {
+            *seed = *seed * 1103515245u + 12345u;
+            if ((int)((*seed >> 16) & 15) <= n / 16) b |= 1 << k;
+        }
+        nozdata[i] = b;
+    }
+}
+
+// Encodes packed image rows one nozzle at a time, the reference for the
+// bulk setters: 3 color rows or 2 black rows.
+static void encode_per_nozzle(uint8_t *nozdata, uint8_t rows[3][21],
+                              int color) {
+    memset(nozdata, 0, PRINTSPIDER_NOZDATA_SZ);
+    if (color) {
+        for (int c = 0; c < 3; c++) {
+            for (int y = 0; y < PRINTSPIDER_COLOR_NOZZLES_IN_ROW; y++) {
+                if (PRINTSPIDER_ROW_BIT(rows[c], y)) {
+                    printspider_set_nozzle_color(
+                        nozdata, y + PRINTSPIDER_COLOR_VERTICAL_OFFSET, c);
+                }
+            }
+        }
+    } else {
+        for (int r = 0; r < 2; r++) {
+            for (int y = 0; y < PRINTSPIDER_BLACK_NOZZLES_IN_ROW; y++) {
+                if (PRINTSPIDER_ROW_BIT(rows[r], y)) {
+                    printspider_set_nozzle_black(nozdata, y, r);
+                }
+            }
+        }
+    }
+}
+
+static void encode_bulk(uint8_t *nozdata, uint8_t rows[3][21], int color) {
+    memset(nozdata, 0, PRINTSPIDER_NOZDATA_SZ);
+    if (color) {
+        for (int c = 0; c < 3; c++) {
+            printspider_set_row_color(nozdata, rows[c], c);
+        }
+    } else {
+        for (int r = 0; r < 2; r++) {
+            printspider_set_row_black(nozdata, rows[r], r);
+        }
+    }
+}
+
+// Every nozzle, all 2 x 168 black and 3 x 112 color ones, sets one bit of
+// its own, so each cartridge covers all 336 bits of the nozzle data.
+static void test_single_nozzles(void) {
+    for (int color = 0; color < 2; color++) {
+        int rows = color ? 3 : 2;
+        int nozzles = color ? 8 * 14 : PRINTSPIDER_BLACK_NOZZLES_IN_ROW;
+        uint8_t used[PRINTSPIDER_NOZDATA_SZ] = {0};
+        for (int r = 0; r < rows; r++) {
+            for (int p = 0; p < nozzles; p++) {
+                uint8_t single[PRINTSPIDER_NOZDATA_SZ] = {0};
+                if (color) {
+                    printspider_set_nozzle_color(single, p, r);
+                } else {
+                    printspider_set_nozzle_black(single, p, r);
+                }
+                int shared = 0;
+                for (int i = 0; i < PRINTSPIDER_NOZDATA_SZ; i++) {
+                    shared |= used[i] & single[i];
+                    used[i] |= single[i];
+                }
+                snprintf(message, sizeof(message), "%s row %d nozzle %d",
+                         color ? "color" : "black", r, p);
+                TEST_ASSERT_EQUAL_INT_MESSAGE(1, count_nozzles(single),
+                                              message);
+                TEST_ASSERT_FALSE_MESSAGE(shared, message);
+            }
+        }
+        TEST_ASSERT_EQUAL_INT(8 * PRINTSPIDER_NOZDATA_SZ, count_nozzles(used));
+    }
+}
+
+// The bulk setters enable the same nozzles as the per-nozzle ones, for every
+// single pixel of a row and for random rows.
+static void test_bulk_setters(void) {
+    uint32_t seed = 2463534242UL;
+    for (int color = 0; color < 2; color++) {
+        int rows = color ? 3 : 2;
+        int width = color ? PRINTSPIDER_COLOR_NOZZLES_IN_ROW
+                          : PRINTSPIDER_BLACK_NOZZLES_IN_ROW;
+        uint8_t ref_nozdata[PRINTSPIDER_NOZDATA_SZ];
+        uint8_t bulk[PRINTSPIDER_NOZDATA_SZ];
+        for (int r = 0; r < rows; r++) {
+            for (int y = 0; y < width; y++) {
+                uint8_t row_bits[3][21] = {{0}};
+                row_bits[r][y / 8] = 0x80 >> (y % 8);
+                encode_per_nozzle(ref_nozdata, row_bits, color);
+                encode_bulk(bulk, row_bits, color);
+                snprintf(message, sizeof(message), "%s row %d pixel %d",
+                         color ? "color" : "black", r, y);
+                TEST_ASSERT_EQUAL_INT_MESSAGE(1, count_nozzles(ref_nozdata),
+                                              message);
+                TEST_ASSERT_EQUAL_MEMORY_MESSAGE(ref_nozdata, bulk,
+                                                 sizeof(bulk), message);
+            }
+        }
+        for (int n = 0; n < 64; n++) {
+            uint8_t row_bits[3][21];
+            for (int r = 0; r < 3; r++) {
+                for (int i = 0; i < 21; i++) {
+                    seed ^= seed << 13;
+                    seed ^= seed >> 17;
+                    seed ^= seed << 5;
+                    row_bits[r][i] = seed;
+                }
+            }
+            encode_per_nozzle(ref_nozdata, row_bits, color);
+            encode_bulk(bulk, row_bits, color);
+            snprintf(message, sizeof(message), "%s random row %d",
+                     color ? "color" : "black", n);
+            TEST_ASSERT_EQUAL_MEMORY_MESSAGE(ref_nozdata, bulk, sizeof(bulk),
+                                             message);
+        }
+    }
+}
+
+// The precomputed steps, the cursor a packet at a time from the template
+// and from the steps, and the length of skipped packets all give what
+// printspider_generate_waveform writes.
+static void test_generators(void) {
+    uint32_t seed = 1;
+    for (int t = 0; t < 4; t++) {
+        printspider_waveform_desc_t wf = printspider_get_waveform(t);
+        uint8_t nozdata[PRINTSPIDER_NOZDATA_SZ];
+        for (int n = 0; n < ROWS_PER_TEMPLATE; n++) {
+            // Blank rows take their own path.
+            if (n) {
+                random_row(&seed, n, nozdata);
+            } else {
+                memset(nozdata, 0, sizeof(nozdata));
+            }
+            memset(ref, 0, sizeof(ref));
+            int len =
+                printspider_generate_waveform(ref, wf.data, nozdata, wf.len);
+            TEST_ASSERT_EQUAL_INT(printspider_waveform_length(wf.len), len);
+            snprintf(message, sizeof(message), "%s row %d",
+                     waveform_names[t], n);
+
+            int fast_len = printspider_generate_waveform_fast(out, &wf,
+                                                              nozdata);
+            TEST_ASSERT_EQUAL_INT_MESSAGE(len, fast_len, message);
+            TEST_ASSERT_EQUAL_MEMORY_MESSAGE(ref, out, len * 2, message);
+
+            for (int fast = 0; fast < 2; fast++) {
+                printspider_waveform_cursor_t cursor;
+                printspider_waveform_cursor_t skip;
+                if (fast) {
+                    printspider_waveform_begin_fast(&cursor, &wf, nozdata);
+                } else {
+                    printspider_waveform_begin(&cursor, wf.data, nozdata,
+                                               wf.len);
+                }
+                skip = cursor;
+                int total = 0;
+                int p;
+                while ((p = printspider_waveform_next_packet(&cursor,
+                                                             &out[total]))) {
+                    TEST_ASSERT_EQUAL_INT_MESSAGE(
+                        p, printspider_waveform_skip_packet(&skip), message);
+                    total += p;
+                }
+                TEST_ASSERT_EQUAL_INT_MESSAGE(
+                    0, printspider_waveform_skip_packet(&skip), message);
+                TEST_ASSERT_EQUAL_INT_MESSAGE(len, total, message);
+                TEST_ASSERT_EQUAL_MEMORY_MESSAGE(ref, out, len * 2, message);
+            }
+        }
+    }
+}
+
+// printspider_waveform_next_word gives the same elements, one at a time, as
+// printspider_waveform_next_packet.
+static void test_next_word(void) {
+    uint32_t seed = 7;
+    for (int t = 0; t < 4; t++) {
+        printspider_waveform_desc_t wf = printspider_get_waveform(t);
+        uint8_t nozdata[PRINTSPIDER_NOZDATA_SZ];
+        for (int n = 0; n < ROWS_PER_TEMPLATE; n++) {
+            if (n) {
+                random_row(&seed, n, nozdata);
+            } else {
+                memset(nozdata, 0, sizeof(nozdata));
+            }
+            printspider_waveform_cursor_t packets;
+            printspider_waveform_begin_fast(&packets, &wf, nozdata);
+            int len = 0;
+            int p;
+            while ((p = printspider_waveform_next_packet(&packets,
+                                                         &ref[len]))) {
+                len += p;
+            }
+            printspider_waveform_cursor_t words;
+            printspider_waveform_begin(&words, wf.data, nozdata, wf.len);
+            int count = 0;
+            uint16_t v;
+            while (count < WAVEFORM_BUFFER_LEN &&
+                   printspider_waveform_next_word(&words, &v)) {
+                out[count++] = v;
+            }
+            snprintf(message, sizeof(message), "%s row %d",
+                     waveform_names[t], n);
+            TEST_ASSERT_EQUAL_INT_MESSAGE(len, count, message);
+            TEST_ASSERT_EQUAL_MEMORY_MESSAGE(ref, out, len * 2, message);
+        }
+    }
+}
+
+// Random rows of every density round trip through the decoder.
+static void test_decode_round_trip(void) {
+    uint32_t seed = 1;
+    for (int t = 0; t < 4; t++) {
+        printspider_waveform_desc_t wf = printspider_get_waveform(t);
+        uint8_t nozdata[PRINTSPIDER_NOZDATA_SZ];
+        uint8_t decoded[PRINTSPIDER_NOZDATA_SZ];
+        for (int n = 0; n < ROWS_PER_TEMPLATE; n++) {
+            random_row(&seed, n, nozdata);
+            int len =
+                printspider_generate_waveform(ref, wf.data, nozdata, wf.len);
+            snprintf(message, sizeof(message), "%s row %d",
+                     waveform_names[t], n);
+            TEST_ASSERT_EQUAL_INT_MESSAGE(
+                0,
+                printspider_decode_waveform(ref, len, wf.data, wf.len,
+                                            decoded, NULL),
+                message);
+            TEST_ASSERT_EQUAL_MEMORY_MESSAGE(nozdata, decoded,
+                                             sizeof(decoded), message);
+        }
+    }
+}
+
+// Every bit of a waveform with about half the nozzles set is flipped in
+// turn. A flip has to be reported as a mismatch in its packet; a data bit
+// spans several elements, and a flipped one changes the decoded bit for all
+// of them, so the mismatch can be at another element of the bit. A flip
+// that makes the waveform of other valid nozzle data has to decode to a bit
+// off.
+static void test_decode_bit_flips(void) {
+    for (int t = 0; t < 4; t++) {
+        printspider_waveform_desc_t wf = printspider_get_waveform(t);
+        uint8_t nozdata[PRINTSPIDER_NOZDATA_SZ];
+        uint8_t decoded[PRINTSPIDER_NOZDATA_SZ];
+        uint32_t seed = 3;
+        random_row(&seed, 127, nozdata);
+        int len = printspider_generate_waveform(ref, wf.data, nozdata, wf.len);
+        int packet_len = wf.len + PRINTSPIDER_IDLE_WORDS;
+        for (int i = 0; i < len; i++) {
+            for (int bit = 0; bit < 16; bit++) {
+                printspider_waveform_info_t info;
+                ref[i] ^= 1 << bit;
+                int r = printspider_decode_waveform(ref, len, wf.data, wf.len,
+                                                    decoded, &info);
+                ref[i] ^= 1 << bit;
+                snprintf(message, sizeof(message),
+                         "%s flip of bit %d of element %d", waveform_names[t],
+                         bit, i);
+                if (r == PRINTSPIDER_DECODE_EMISMATCH) {
+                    TEST_ASSERT_EQUAL_INT_MESSAGE(
+                        i / packet_len, info.error_pos / packet_len, message);
+                } else {
+                    int off = 0;
+                    for (int k = 0; k < PRINTSPIDER_NOZDATA_SZ; k++) {
+                        off += count_bits(decoded[k] ^ nozdata[k]);
+                    }
+                    TEST_ASSERT_EQUAL_INT_MESSAGE(0, r, message);
+                    TEST_ASSERT_EQUAL_INT_MESSAGE(1, off, message);
+                }
+            }
+        }
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_single_nozzles);
+    RUN_TEST(test_bulk_setters);
+    RUN_TEST(test_generators);
+    RUN_TEST(test_next_word);
+    RUN_TEST(test_decode_round_trip);
+    RUN_TEST(test_decode_bit_flips);
+    return UNITY_END();
+}
@@ -0,0 +1,174 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Tests of printspider_raster.c: Code128 barcodes are read back with tables
+// of their own, and scaled text is checked against unscaled text.
+//
+// Run with: pio test -e native
+
+#include <string.h>
+#include <unity.h>
+
+#include "printspider.h"
+#include "printspider_raster.h"
+
+// Bar and space widths of the Code128 symbols 0..105, to read barcodes back
+// independently of the rasterizer's tables.
+static const char *code128_widths[106] = {
+    "212222", "222122", "222221", "121223", "121322", "131222", "122213",
+    "122312", "132212", "221213", "221312", "231212", "112232", "122132",
+    "122231", "113222", "123122", "123221", "223211", "221132", "221231",
+    "213212", "223112", "312131", "311222", "321122", "321221", "312212",
+    "322112", "322211", "212123", "212321", "232121", "111323", "131123",
+    "131321", "112313", "132113", "132311", "211313", "231113", "231311",
+    "112133", "112331", "132131", "113123", "113321", "133121", "313121",
+    "211331", "231131", "213113", "213311", "213131", "311123", "311321",
+    "331121", "312113", "312311", "332111", "314111", "221411", "431111",
+    "111224", "111422", "121124", "121421", "141122", "141221", "112214",
+    "112412", "122114", "122411", "142112", "142211", "241211", "221114",
+    "413111", "241112", "134111", "111242", "121142", "121241", "114212",
+    "124112", "124211", "411212", "421112", "421211", "212141", "214121",
+    "412121", "111143", "111341", "131141", "114113", "114311", "411113",
+    "411311", "113141", "114131", "311141", "411131", "211412", "211214",
+    "211232"};
+
+#define RASTER_MAX_LINES 2048
+
+// Reads a Code128 barcode back from its modules, one per entry of `m`, set
+// for bars. Writes the text to `text` and returns 0, or -1 if the quiet
+// zones, start, checksum or stop are wrong.
+static int read_code128(const uint8_t *m, int n, char *text) {
+    int i = 10;
+    int values[RASTER_MAX_LINES / 11];
+    int count = 0;
+    for (int k = 0; k < 10; k++) {
+        if (m[k] || m[n - 1 - k]) return -1;
+    }
+    while (i + 13 < n - 10) {
+        char w[7];
+        for (int k = 0; k < 6; k++) {
+            int run = 0;
+            while (i < n && m[i] == !(k & 1)) {
+                run++;
+                i++;
+            }
+            w[k] = '0' + run;
+        }
+        w[6] = 0;
+        int v = 0;
+        while (v < 106 && strcmp(w, code128_widths[v])) v++;
+        if (v == 106) return -1;
+        values[count++] = v;
+    }
+    // Stop symbol, 2331112.
+    static const uint8_t stop[13] = {1, 1, 0, 0, 0, 1, 1, 1, 0, 1, 0, 1, 1};
+    if (i + 13 != n - 10 || memcmp(&m[i], stop, 13) != 0) return -1;
+    if (count < 2 || values[0] < 104) return -1;
+    int sum = values[0];
+    for (int k = 1; k < count - 1; k++) sum += k * values[k];
+    if (sum % 103 != values[count - 1]) return -1;
+    int set_c = values[0] == 105;
+    for (int k = 1; k < count - 1; k++) {
+        int v = values[k];
+        if (set_c && v < 100) {
+            *text++ = '0' + v / 10;
+            *text++ = '0' + v % 10;
+        } else if (v == 99 || v == 100) {
+            set_c = v == 99;
+        } else if (!set_c && v < 96) {
+            *text++ = ' ' + v;
+        } else {
+            return -1;
+        }
+    }
+    *text = 0;
+    return 0;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// Barcodes of set B and set C texts, and of texts switching between them,
+// read back as their text.
+static void test_code128(void) {
+    static const char *texts[] = {"PS-2021", "LOT 123456", "12345", "0042x",
+                                  "A", "", "2021-10-16 12:00", "~{|}"};
+    static uint8_t modules[RASTER_MAX_LINES];
+    uint8_t line[PRINTSPIDER_BLACK_ROW_BYTES];
+    for (unsigned t = 0; t < sizeof(texts) / sizeof(texts[0]); t++) {
+        printspider_raster_t r;
+        char decoded[64];
+        printspider_raster_code128(&r, texts[t], 3, 5, 1);
+        int n = 0;
+        for (;;) {
+            memset(line, 0, sizeof(line));
+            if (!printspider_raster_next_line(&r, line, sizeof(line) * 8)) break;
+            // The bar covers pixels 3..7 and nothing else.
+            TEST_ASSERT_TRUE_MESSAGE(!line[0] || line[0] == 0x1f, texts[t]);
+            TEST_ASSERT_TRUE_MESSAGE(n < RASTER_MAX_LINES, texts[t]);
+            modules[n++] = line[0] == 0x1f;
+        }
+        TEST_ASSERT_EQUAL_INT_MESSAGE(0, read_code128(modules, n, decoded),
+                                      texts[t]);
+        TEST_ASSERT_EQUAL_STRING(texts[t], decoded);
+    }
+}
+
+// Every font pixel of a scaled text is a square of the unscaled one.
+static void test_scaled_text(void) {
+    static uint8_t unscaled[RASTER_MAX_LINES][PRINTSPIDER_BLACK_ROW_BYTES];
+    uint8_t line[PRINTSPIDER_BLACK_ROW_BYTES];
+    const char *text = "Lot 42/A";
+    int lines = 0;
+    printspider_raster_t r;
+    printspider_raster_text(&r, text, 0, 1);
+    for (;;) {
+        memset(unscaled[lines], 0, sizeof(unscaled[0]));
+        if (!printspider_raster_next_line(&r, unscaled[lines],
+                                          PRINTSPIDER_BLACK_NOZZLES_IN_ROW)) {
+            break;
+        }
+        lines++;
+    }
+    TEST_ASSERT_EQUAL_INT(6 * (int)strlen(text) - 1, lines);
+    int scaled_lines = 0;
+    printspider_raster_text(&r, text, 5, 3);
+    for (;;) {
+        memset(line, 0, sizeof(line));
+        if (!printspider_raster_next_line(&r, line,
+                                          PRINTSPIDER_BLACK_NOZZLES_IN_ROW)) {
+            break;
+        }
+        TEST_ASSERT_TRUE(scaled_lines < 3 * lines);
+        for (int y = 0; y < PRINTSPIDER_BLACK_NOZZLES_IN_ROW; y++) {
+            int src = y >= 5 && y < 5 + 21
+                          ? PRINTSPIDER_ROW_BIT(unscaled[scaled_lines / 3],
+                                                (y - 5) / 3)
+                          : 0;
+            TEST_ASSERT_EQUAL_INT(src, PRINTSPIDER_ROW_BIT(line, y));
+        }
+        scaled_lines++;
+    }
+    TEST_ASSERT_EQUAL_INT(3 * lines, scaled_lines);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_code128);
+    RUN_TEST(test_scaled_text);
+    return UNITY_END();
+}
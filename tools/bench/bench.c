@@ -0,0 +1,429 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Host benchmark of the PrintSpider library. Measures the time per row of
+// waveform generation and nozzle encoding for every waveform template and a
+// set of nozzle patterns, and checks the generated waveforms against golden
+// hashes so optimizations can be verified to be bit-exact. A label workload
+// of blank rows, text and solid bars measures the packet cache against
+// generating and converting every packet, and generating the packets straight
+// as port pairs against both, and playing them back from a compiled job.
+// Labels from the rasterizer are timed per line. Whether the outputs are
+// right is checked by the unit tests in test/.
+//
+// Run with: pio run -e native -t exec
+// Optional argument: number of rows per measurement.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "printspider.h"
+#include "printspider_cache.h"
+#include "printspider_job.h"
+#include "printspider_port.h"
+#include "printspider_portgen.h"
+#include "printspider_raster.h"
+
+#define BENCH_DEFAULT_ROWS 20000
+#define WAVEFORM_BUFFER_LEN 600
+
+enum pattern_en { PATTERN_EMPTY, PATTERN_SPARSE, PATTERN_FULL, PATTERN_COUNT };
+
+static const char *pattern_names[PATTERN_COUNT] = {"empty", "sparse", "full"};
+
+static const char *waveform_names[4] = {"color_a", "color_b", "black_a",
+                                        "black_b"};
+
+// FNV-1a hashes of the waveform generated by the original
+// printspider_generate_waveform, per template and pattern.
+static const uint32_t golden[4][PATTERN_COUNT] = {
+    {0xca66d755, 0xcaa2033d, 0x6301eb5d},
+    {0xca66d755, 0xcc8573e9, 0xd4d55b1d},
+    {0xca66d755, 0x06f052fa, 0x9099cf25},
+    {0xca66d755, 0x8784413e, 0x1c8913d5},
+};
+
+static int is_color(int type) {
+    return type == PRINTSPIDER_WAVEFORM_COLOR_A ||
+           type == PRINTSPIDER_WAVEFORM_COLOR_B;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+static uint32_t fnv1a(const uint16_t *w, int len) {
+    uint32_t h = 2166136261UL;
+    for (int i = 0; i < len; i++) {
+        h = (h ^ (w[i] & 0xff)) * 16777619UL;
+        h = (h ^ (w[i] >> 8)) * 16777619UL;
+    }
+    return h;
+}
+
+// Packed image rows for a pattern: 3 color rows or 2 black rows. Sparse
+// fires about every 16th pixel, from a fixed xorshift sequence.
+static void make_rows(enum pattern_en pattern, uint8_t rows[3][21]) {
+    uint32_t x = 2463534242UL;
+    for (int r = 0; r < 3; r++) {
+        for (int i = 0; i < 21; i++) {
+            uint8_t b = 0;
+            if (pattern == PATTERN_FULL) {
+                b = 0xff;
+            } else if (pattern == PATTERN_SPARSE) {
+                for (int k = 0; k < 8; k++) {
+                    x ^= x << 13;
+                    x ^= x >> 17;
+                    x ^= x << 5;
+                    if ((x & 15) == 0) b |= 0x80 >> k;
+                }
+            }
+            rows[r][i] = b;
+        }
+    }
+}
+
+// Encodes the rows one nozzle at a time, the reference for the bulk setters.
+static void encode_per_nozzle(uint8_t *nozdata, uint8_t rows[3][21],
+                              int color) {
+    memset(nozdata, 0, PRINTSPIDER_NOZDATA_SZ);
+    if (color) {
+        for (int c = 0; c < 3; c++) {
+            for (int y = 0; y < PRINTSPIDER_COLOR_NOZZLES_IN_ROW; y++) {
+                if (PRINTSPIDER_ROW_BIT(rows[c], y)) {
+                    printspider_set_nozzle_color(
+                        nozdata, y + PRINTSPIDER_COLOR_VERTICAL_OFFSET, c);
+                }
+            }
+        }
+    } else {
+        for (int r = 0; r < 2; r++) {
+            for (int y = 0; y < PRINTSPIDER_BLACK_NOZZLES_IN_ROW; y++) {
+                if (PRINTSPIDER_ROW_BIT(rows[r], y)) {
+                    printspider_set_nozzle_black(nozdata, y, r);
+                }
+            }
+        }
+    }
+}
+
+static void encode_bulk(uint8_t *nozdata, uint8_t rows[3][21], int color) {
+    memset(nozdata, 0, PRINTSPIDER_NOZDATA_SZ);
+    if (color) {
+        for (int c = 0; c < 3; c++) printspider_set_row_color(nozdata, rows[c], c);
+    } else {
+        for (int r = 0; r < 2; r++) printspider_set_row_black(nozdata, rows[r], r);
+    }
+}
+
+static int generate_streamed(uint16_t *w, const printspider_waveform_desc_t *wf,
+                             const uint8_t *nozdata) {
+    printspider_waveform_cursor_t cursor;
+    printspider_waveform_begin_fast(&cursor, wf, nozdata);
+    int len = 0;
+    int n;
+    while ((n = printspider_waveform_next_packet(&cursor, &w[len])) > 0) {
+        len += n;
+    }
+    return len;
+}
+
+// Cartridge pins of the firmware, bus[i] carries bit i of a waveform word.
+static const uint8_t bus[PRINTSPIDER_PORT_LINES] = {0, 1, 2, 3, 5, 7,
+                                                    4, 8, 9, 6, 10, 11};
+
+#define LABEL_ROWS 64
+
+// Nozzle data of a label: mostly blank rows, rows of text in the middle of
+// the nozzles with blank margins, and solid bars.
+static void make_label(uint8_t label[LABEL_ROWS][PRINTSPIDER_NOZDATA_SZ],
+                       int color) {
+    uint32_t x = 88172645UL;
+    uint8_t rows[3][21];
+    for (int y = 0; y < LABEL_ROWS; y++) {
+        memset(rows, 0, sizeof(rows));
+        int kind = y % 16;
+        if (kind >= 4 && kind < 10) {
+            // Text: glyph columns over the middle third of the nozzles.
+            for (int r = 0; r < 3; r++) {
+                for (int i = 7; i < 14; i++) {
+                    x ^= x << 13;
+                    x ^= x >> 17;
+                    x ^= x << 5;
+                    rows[r][i] = x & 0x7e;
+                }
+            }
+        } else if (kind >= 12) {
+            memset(rows, 0xff, sizeof(rows));
+        }
+        encode_bulk(label[y], rows, color);
+    }
+}
+
+// Generates and converts every packet, as the output stage does without the
+// cache.
+static int label_convert(const printspider_portmap_t *m,
+                         const printspider_waveform_desc_t *wf,
+                         const uint8_t *nozdata, uint16_t *w) {
+    int len = generate_streamed(w, wf, nozdata);
+    printspider_portmap_convert(m, w, len);
+    return len;
+}
+
+// Gets every packet from the cache; blank rows produce no pairs.
+static int label_cached(printspider_cache_t *k,
+                        const printspider_waveform_desc_t *wf,
+                        const uint8_t *nozdata, uint16_t *w) {
+    printspider_waveform_cursor_t cursor;
+    printspider_waveform_begin_fast(&cursor, wf, nozdata);
+    const uint16_t *pairs;
+    int len;
+    int total = 0;
+    while ((pairs = printspider_cache_next_packet(k, &cursor, &len)) || len) {
+        if (pairs) {
+            memcpy(&w[total], pairs, len * sizeof(*pairs));
+        } else {
+            memset(&w[total], 0, len * sizeof(*w));
+        }
+        total += len;
+    }
+    return total;
+}
+
+// Generates every packet straight as port pairs.
+static int label_portgen(const printspider_portgen_t *g,
+                         const printspider_waveform_desc_t *wf,
+                         const uint8_t *nozdata, uint16_t *w) {
+    printspider_waveform_cursor_t cursor;
+    printspider_waveform_begin_fast(&cursor, wf, nozdata);
+    int len;
+    int total = 0;
+    while ((len = printspider_portgen_next_packet(g, &cursor, &w[total]))) {
+        total += len;
+    }
+    return total;
+}
+
+// Job data of every label row, each row its own job as tools/ps_job would
+// compile it. A packet of n pairs takes at most 1 + 3 * n bytes.
+#define LABEL_JOB_BYTES (LABEL_ROWS * 4 * WAVEFORM_BUFFER_LEN)
+
+// Compiles the label rows into `data`, with the offset of every row in
+// `starts`. Returns the amount of bytes.
+static int label_job_compile(const printspider_portmap_t *m,
+                             const printspider_waveform_desc_t *wf,
+                             uint8_t label[LABEL_ROWS][PRINTSPIDER_NOZDATA_SZ],
+                             uint8_t *data, int *starts) {
+    static const uint8_t blank[PRINTSPIDER_NOZDATA_SZ];
+    uint16_t w[WAVEFORM_BUFFER_LEN];
+    int pos = 0;
+    for (int y = 0; y < LABEL_ROWS; y++) {
+        starts[y] = pos;
+        int len = label_convert(m, wf, label[y], w);
+        if (!memcmp(label[y], blank, sizeof(blank))) {
+            pos += printspider_job_encode_idle(&data[pos], len);
+        } else {
+            printspider_waveform_cursor_t cursor;
+            printspider_waveform_begin(&cursor, wf->data, label[y], wf->len);
+            int n;
+            int i = 0;
+            while ((n = printspider_waveform_skip_packet(&cursor))) {
+                pos += printspider_job_encode_packet(&data[pos], &w[i], n);
+                i += n;
+            }
+        }
+        data[pos++] = 0;
+    }
+    return pos;
+}
+
+// Plays a compiled row back; blank rows produce no pairs.
+static int label_job(const uint8_t *row, uint16_t *w) {
+    printspider_job_t job = {0, 1, row};
+    printspider_job_reader_t reader;
+    printspider_job_open(&reader, &job);
+    uint16_t pairs[PRINTSPIDER_JOB_PACKET_LEN];
+    const uint16_t *p;
+    int len;
+    int total = 0;
+    while ((p = printspider_job_next_packet(&reader, pairs, &len)) || len) {
+        if (p) {
+            memcpy(&w[total], p, len * sizeof(*p));
+        } else {
+            memset(&w[total], 0, len * sizeof(*w));
+        }
+        total += len;
+    }
+    return total;
+}
+
+// Draws a label line by line: a text of font pixels `scale` high and a
+// barcode below it. Returns the number of lines.
+static int raster_label(const char *text, uint8_t scale, uint8_t *line) {
+    printspider_raster_t t, b;
+    printspider_raster_text(&t, text, 0, scale);
+    printspider_raster_code128(&b, text, 8 * scale, 100, 2);
+    int n = 0;
+    for (;;) {
+        memset(line, 0, PRINTSPIDER_BLACK_ROW_BYTES);
+        int more = printspider_raster_next_line(&t, line,
+                                                PRINTSPIDER_BLACK_NOZZLES_IN_ROW);
+        more |= printspider_raster_next_line(&b, line,
+                                             PRINTSPIDER_BLACK_NOZZLES_IN_ROW);
+        if (!more) return n;
+        n++;
+    }
+}
+
+// Nanoseconds per call of a row operation, averaged over `rows` calls.
+#define MEASURE(rows, stmt)                          \
+    ({                                               \
+        uint64_t start_ = now_ns();                  \
+        for (long i_ = 0; i_ < (rows); i_++) {       \
+            stmt;                                    \
+        }                                            \
+        (double)(now_ns() - start_) / (rows);        \
+    })
+
+int main(int argc, char **argv) {
+    long rows = argc > 1 ? atol(argv[1]) : BENCH_DEFAULT_ROWS;
+    if (rows <= 0) rows = BENCH_DEFAULT_ROWS;
+    static uint16_t ref[WAVEFORM_BUFFER_LEN];
+    static uint16_t out[WAVEFORM_BUFFER_LEN];
+    uint8_t row_bits[3][21];
+    uint8_t nozdata[PRINTSPIDER_NOZDATA_SZ];
+    uint8_t bulk[PRINTSPIDER_NOZDATA_SZ];
+    // Keeps the compiler from dropping the measured calls.
+    volatile int sink = 0;
+    int failures = 0;
+
+    printf("%-8s %-7s %10s %10s %10s %10s %10s %10s\n", "waveform",
+           "pattern", "gen_ns", "fast_ns", "stream_ns", "enc_ns", "bulk_ns",
+           "hash");
+    for (int t = 0; t < 4; t++) {
+        printspider_waveform_desc_t wf = printspider_get_waveform(t);
+        int color = is_color(t);
+        for (int p = 0; p < PATTERN_COUNT; p++) {
+            make_rows(p, row_bits);
+            encode_per_nozzle(nozdata, row_bits, color);
+            memset(ref, 0, sizeof(ref));
+            int len = printspider_generate_waveform(ref, wf.data, nozdata,
+                                                    wf.len);
+            uint32_t hash = fnv1a(ref, len);
+            if (hash != golden[t][p]) {
+                printf("FAIL %s/%s: hash 0x%08x, golden 0x%08x\n",
+                       waveform_names[t], pattern_names[p], (unsigned)hash,
+                       (unsigned)golden[t][p]);
+                failures++;
+            }
+
+            double gen = MEASURE(rows, sink += printspider_generate_waveform(
+                                           out, wf.data, nozdata, wf.len));
+            double fast = MEASURE(
+                rows, sink += printspider_generate_waveform_fast(out, &wf, nozdata));
+            double stream =
+                MEASURE(rows, sink += generate_streamed(out, &wf, nozdata));
+            double enc = MEASURE(rows, {
+                encode_per_nozzle(bulk, row_bits, color);
+                sink += bulk[0];
+            });
+            double enc_bulk = MEASURE(rows, {
+                encode_bulk(bulk, row_bits, color);
+                sink += bulk[0];
+            });
+            printf("%-8s %-7s %10.1f %10.1f %10.1f %10.1f %10.1f 0x%08x\n",
+                   waveform_names[t], pattern_names[p], gen, fast, stream, enc,
+                   enc_bulk, (unsigned)hash);
+        }
+    }
+
+    // Label workload through the packet cache.
+    printspider_portmap_t portmap;
+    printspider_portmap_init(&portmap, bus, PRINTSPIDER_PORT_LINES);
+    static uint8_t label[LABEL_ROWS][PRINTSPIDER_NOZDATA_SZ];
+    static printspider_cache_t cache;
+    static printspider_portgen_t portgen;
+    static uint8_t job[LABEL_JOB_BYTES];
+    int job_starts[LABEL_ROWS];
+    printf("\n%-8s %10s %10s %10s %10s %10s %10s %10s %10s %10s\n",
+           "waveform", "convert_ns", "cached_ns", "saved", "hit_rate", "blank",
+           "direct_ns", "direct_c_ns", "job_ns", "job_bytes");
+    for (int t = 0; t < 4; t++) {
+        printspider_waveform_desc_t wf = printspider_get_waveform(t);
+        make_label(label, is_color(t));
+        printspider_cache_init(&cache, &portmap);
+        printspider_portgen_init(&portgen, &portmap, wf.steps, wf.len);
+        // Rates of one pass over the label; the counters would wrap over
+        // the measurement.
+        for (int y = 0; y < LABEL_ROWS; y++) {
+            sink += label_cached(&cache, &wf, label[y], out);
+        }
+        printspider_cache_stats_t st = cache.stats;
+        long label_rows = (rows / LABEL_ROWS + 1) * LABEL_ROWS;
+        double convert = MEASURE(label_rows, sink += label_convert(
+            &portmap, &wf, label[i_ % LABEL_ROWS], out));
+        printspider_cache_init(&cache, &portmap);
+        double cached = MEASURE(label_rows, sink += label_cached(
+            &cache, &wf, label[i_ % LABEL_ROWS], out));
+        double direct = MEASURE(label_rows, sink += label_portgen(
+            &portgen, &wf, label[i_ % LABEL_ROWS], out));
+        // The cache generating its missed packets as port pairs, as the
+        // firmware does with EMIT_DIRECT_PORTS.
+        printspider_cache_init(&cache, &portmap);
+        printspider_cache_use_portgen(&cache, &portgen);
+        double direct_cached = MEASURE(label_rows, sink += label_cached(
+            &cache, &wf, label[i_ % LABEL_ROWS], out));
+        // The same rows compiled ahead of time, only decompressed here.
+        int job_bytes = label_job_compile(&portmap, &wf, label, job,
+                                          job_starts);
+        double job_play = MEASURE(label_rows, sink += label_job(
+            &job[job_starts[i_ % LABEL_ROWS]], out));
+        printf("%-8s %10.1f %10.1f %9.1f%% %9.1f%% %9.1f%% %10.1f %10.1f "
+               "%10.1f %10d\n",
+               waveform_names[t], convert, cached,
+               100.0 * (convert - cached) / convert,
+               100.0 * st.hits / (st.hits + st.misses),
+               100.0 * st.blank_rows / LABEL_ROWS, direct, direct_cached,
+               job_play, job_bytes);
+    }
+
+    // Labels drawn on the fly, per image line; the line has to be ready
+    // before the waveform of the previous one is out.
+    uint8_t label_line[PRINTSPIDER_BLACK_ROW_BYTES];
+    char lot[16];
+    int label_lines = 0;
+    uint64_t start = now_ns();
+    for (long i = 0; label_lines < rows; i++) {
+        snprintf(lot, sizeof(lot), "LOT %06ld", i % 1000000);
+        label_lines += raster_label(lot, 2, label_line);
+        sink += label_line[0];
+    }
+    printf("\n%-8s %10s\n%-8s %10.1f\n", "raster", "line_ns", "label",
+           (double)(now_ns() - start) / label_lines);
+
+    (void)sink;
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all outputs match golden hashes\n");
+    return 0;
+}
@@ -0,0 +1,8 @@
+# Adds the benchmark sources to the native environment; src/ holds the
+# firmware, which only builds for AVR. Unit test builds (pio test -e native)
+# bring their own main().
+Import("env")
+from SCons.Script import COMMAND_LINE_TARGETS
+
+if "__test" not in COMMAND_LINE_TARGETS:
+    env.BuildSources("$BUILD_DIR/bench", "$PROJECT_DIR/tools/bench")
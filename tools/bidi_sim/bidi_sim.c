@@ -0,0 +1,574 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Host simulation of bidirectional printing. Test images are printed on
+// forward and reverse passes the same way as print_pass in src/main.c does,
+// the fired nozzles are decoded back from the generated waveforms and put on
+// a raster where the carriage puts them, and both rasters are compared with
+// the image as a unidirectional print puts it on paper.
+// A grey image is printed with the ordered dither, which only matches when
+// the reverse pass dithers every line with its own matrix row.
+//
+// The carriage moves one column per firing. Nozzle row c sits c offsets
+// behind the first one in the forward direction, so on a reverse pass it
+// leads. A pass of F firings covers the same span both ways: forward firing
+// y is at column y, reverse firing y at column F - 1 - y. The dots of reverse
+// passes can be made to land `error` columns further, as drop flight time or
+// carriage backlash do, to check the alignment settings that correct it.
+//
+// The redundant mode of the black cartridge is checked on the same rasters:
+// every dot of the image must be fired by exactly one of the two nozzle rows,
+// no nozzle may fire on two firings in a row in a solid image, and failed
+// nozzles must never fire while the other row takes their dots.
+//
+// Run with: pio run -e bidi_sim -t exec
+// Or .pio/build/bidi_sim/program [--error E] [--forward N] [--reverse N]
+// [--pgm PREFIX] for one setting, with the alignment as BIDI_ALIGN_FORWARD
+// and BIDI_ALIGN_REVERSE, writing the rasters as PGM files.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "printspider.h"
+#include "printspider_dither.h"
+#include "printspider_image.h"
+#include "printspider_swath.h"
+
+// Same as the default of src/main.c.
+#define BIDI_ALIGN_MAX 8
+
+#define IMAGE_LINES 96
+#define WAVEFORM_BUFFER_LEN 600
+// Longest pass: margins, image and the delay of the last nozzle row.
+#define MAX_FIRINGS \
+    (2 * BIDI_ALIGN_MAX + IMAGE_LINES + 2 * PRINTSPIDER_COLOR_ROW_OFFSET)
+// Raster columns, with room for dots landing off the pass.
+#define RASTER_MARGIN 32
+#define RASTER_COLUMNS (MAX_FIRINGS + 2 * RASTER_MARGIN)
+// Nozzle rows times nozzles of either cartridge.
+#define RASTER_DOTS (2 * PRINTSPIDER_BLACK_NOZZLES_IN_ROW)
+
+typedef struct cart_t {
+    const char *name;
+    int color;
+    // Nozzle rows, image channels, pixels per channel.
+    int rows;
+    int channels;
+    int width;
+    int offset;
+    printspider_waveform_desc_t waveform;
+    // Nozzle data byte and bit of every dot, mask 0 for nozzles that are
+    // not connected.
+    uint8_t byte[RASTER_DOTS];
+    uint8_t mask[RASTER_DOTS];
+} cart_t;
+
+typedef struct settings_t {
+    int error;
+    int forward;
+    int reverse;
+} settings_t;
+
+typedef uint8_t raster_t[RASTER_COLUMNS][RASTER_DOTS];
+
+static void cart_init(cart_t *cart, int color) {
+    memset(cart, 0, sizeof(*cart));
+    cart->color = color;
+    if (color) {
+        cart->name = "color";
+        cart->rows = 3;
+        cart->channels = 3;
+        cart->width = PRINTSPIDER_COLOR_NOZZLES_IN_ROW;
+        cart->offset = PRINTSPIDER_COLOR_ROW_OFFSET;
+        cart->waveform = printspider_get_waveform(PRINTSPIDER_WAVEFORM_COLOR_B);
+    } else {
+        cart->name = "black";
+        cart->rows = 2;
+        cart->channels = 1;
+        cart->width = PRINTSPIDER_BLACK_NOZZLES_IN_ROW;
+        cart->offset = PRINTSPIDER_BLACK_ROW_OFFSET;
+        cart->waveform = printspider_get_waveform(PRINTSPIDER_WAVEFORM_BLACK_B);
+    }
+    // Find the nozzle data bit of every dot from the nozzle setters.
+    for (int r = 0; r < cart->rows; r++) {
+        for (int p = 0; p < cart->width; p++) {
+            uint8_t nozdata[PRINTSPIDER_NOZDATA_SZ] = {0};
+            if (color) {
+                printspider_set_nozzle_color(
+                    nozdata, p + PRINTSPIDER_COLOR_VERTICAL_OFFSET, r);
+            } else {
+                printspider_set_nozzle_black(nozdata, p, r);
+            }
+            for (int i = 0; i < PRINTSPIDER_NOZDATA_SZ; i++) {
+                if (nozdata[i]) {
+                    cart->byte[r * cart->width + p] = i;
+                    cart->mask[r * cart->width + p] = nozdata[i];
+                }
+            }
+        }
+    }
+}
+
+static uint32_t xorshift(uint32_t *x) {
+    *x ^= *x << 13;
+    *x ^= *x >> 17;
+    *x ^= *x << 5;
+    return *x;
+}
+
+// Pattern of the grey test image, see grey_pixel.
+#define PATTERN_GREY 4
+
+// Random state of the test images, reset for every image.
+static uint32_t random_state;
+
+// Pixel of a test image, 1 for ink. Every channel gets a different pattern,
+// so mixed up nozzle rows show.
+static int test_pixel(int pattern, int line, int channel, int p) {
+    switch (pattern) {
+        case 0:
+            // Diagonals, vertical bars and a frame.
+            return (line + p * (channel + 1)) % 23 == 0 || line % 31 == 7 ||
+                   line == 0 || line == IMAGE_LINES - 1 || p < 2;
+        case 1:
+            // Blocks of text.
+            return (line / 8 + p / 12 + channel) % 3 == 0 && line % 8 < 6 &&
+                   (xorshift(&random_state) & 3) != 0;
+        case 2:
+            return (xorshift(&random_state) & 7) == 0;
+        case PATTERN_GREY:
+            return 0;
+        default:
+            return 1;
+    }
+}
+
+// Pixel level of the grey test image, a ramp along the nozzles moving with
+// the line and the channel.
+static uint8_t grey_pixel(int line, int channel, int p) {
+    return p * 3 + line * 2 + channel * 85;
+}
+
+// Test image in RAM, packed or as RLE of 0 and 255 pixels, which dither the
+// same in any order, or the grey image as RLE for the ordered dither.
+typedef struct test_image_t {
+    printspider_image_t image;
+    uint8_t data[IMAGE_LINES * 3 * PRINTSPIDER_BLACK_NOZZLES_IN_ROW * 2];
+    uint16_t index[IMAGE_LINES];
+    // Expected ink per line and dot of the first nozzle row.
+    uint8_t ink[IMAGE_LINES][3 * PRINTSPIDER_BLACK_NOZZLES_IN_ROW];
+} test_image_t;
+
+static void make_image(test_image_t *t, const cart_t *cart, int pattern,
+                       int format, int indexed) {
+    memset(t, 0, sizeof(*t));
+    random_state = 2463534242UL;
+    int row_bytes = (cart->width + 7) / 8;
+    int n = 0;
+    for (int y = 0; y < IMAGE_LINES; y++) {
+        t->index[y] = n;
+        for (int c = 0; c < cart->channels; c++) {
+            uint8_t *ink = &t->ink[y][c * cart->width];
+            uint8_t level[PRINTSPIDER_BLACK_NOZZLES_IN_ROW];
+            for (int p = 0; p < cart->width; p++) {
+                ink[p] = test_pixel(pattern, y, c, p);
+                level[p] = ink[p] ? 0 : 255;
+            }
+            if (pattern == PATTERN_GREY) {
+                // Line y gets row y of the dither matrix in either pass.
+                printspider_dither_t d;
+                uint8_t bits[PRINTSPIDER_BLACK_ROW_BYTES];
+                printspider_dither_init(&d, PRINTSPIDER_DITHER_ORDERED, 1);
+                printspider_dither_seek_row(&d, y);
+                for (int p = 0; p < cart->width; p++) {
+                    level[p] = grey_pixel(y, c, p);
+                }
+                printspider_dither_row(&d, level, bits, cart->width);
+                for (int p = 0; p < cart->width; p++) {
+                    ink[p] = PRINTSPIDER_ROW_BIT(bits, p);
+                }
+            }
+            if (format == PRINTSPIDER_IMAGE_PACKED) {
+                for (int p = 0; p < cart->width; p++) {
+                    if (ink[p]) t->data[n + p / 8] |= 0x80 >> (p % 8);
+                }
+                n += row_bytes;
+                continue;
+            }
+            // PackBits with runs only, good enough for a test.
+            for (int p = 0; p < cart->width;) {
+                int run = 1;
+                while (p + run < cart->width && run < 128 &&
+                       level[p + run] == level[p]) {
+                    run++;
+                }
+                t->data[n++] = run > 1 ? 257 - run : 0;
+                t->data[n++] = level[p];
+                p += run;
+            }
+        }
+    }
+    t->image.format = format;
+    t->image.channels = cart->channels;
+    t->image.width = cart->width;
+    t->image.lines = IMAGE_LINES;
+    t->image.data = t->data;
+    t->image.index = indexed ? t->index : NULL;
+}
+
+// Puts the dots fired by nozzle data on the raster, decoded back from the
+// generated waveform.
+static int fire(const cart_t *cart, const uint8_t *nozdata, int column,
+                raster_t raster) {
+    static uint16_t w[WAVEFORM_BUFFER_LEN];
+    uint8_t decoded[PRINTSPIDER_NOZDATA_SZ];
+    int len = printspider_generate_waveform_fast(w, &cart->waveform, nozdata);
+    if (printspider_decode_waveform(w, len, cart->waveform.data,
+                                    cart->waveform.len, decoded, NULL)) {
+        return -1;
+    }
+    for (int r = 0; r < cart->rows; r++) {
+        // Nozzle row r is r offsets behind the first one.
+        int x = column - r * cart->offset + RASTER_MARGIN;
+        for (int p = 0; p < cart->width; p++) {
+            int dot = r * cart->width + p;
+            if (!(decoded[cart->byte[dot]] & cart->mask[dot])) continue;
+            if (x < 0 || x >= RASTER_COLUMNS) return -1;
+            raster[x][dot] = 1;
+        }
+    }
+    return 0;
+}
+
+// Redundant mode and map of failed nozzles of the black swath in print_pass.
+static int redundant;
+// Dither mode of print_pass.
+static int dither_mode = PRINTSPIDER_DITHER_DIFFUSION;
+static uint8_t dead[PRINTSPIDER_SWATH_DEAD_SZ];
+
+// Prints the image in one pass like print_pass in src/main.c and returns the
+// amount of firings, or -1 if the waveforms don't decode.
+static int print_pass(const cart_t *cart, const printspider_image_t *image,
+                      int reverse, int align, int error, raster_t raster) {
+    static uint8_t swath_buffer[PRINTSPIDER_SWATH_COLOR_SZ];
+    static uint8_t nozdata[MAX_FIRINGS][PRINTSPIDER_NOZDATA_SZ];
+    printspider_swath_t swath;
+    if (cart->color) {
+        printspider_swath_init_color(&swath, swath_buffer);
+    } else {
+        printspider_swath_init_black(&swath, swath_buffer);
+        printspider_swath_set_redundant(&swath, redundant, dead);
+    }
+    printspider_swath_set_reverse(&swath, reverse);
+    printspider_dither_t dither[3];
+    for (int c = 0; c < 3; c++) {
+        printspider_dither_init(&dither[c], dither_mode, 1);
+    }
+
+    memset(nozdata, 0, sizeof(nozdata));
+    int firings = 0;
+    for (int i = 0; i < BIDI_ALIGN_MAX + align; i++) {
+        printspider_swath_push(&swath, NULL, nozdata[firings++]);
+    }
+    uint8_t pixels[PRINTSPIDER_BLACK_NOZZLES_IN_ROW];
+    uint8_t line[3 * PRINTSPIDER_COLOR_ROW_BYTES];
+    printspider_image_reader_t reader;
+    printspider_image_open(&reader, image);
+    for (int i = 0; i < image->lines; i++) {
+        if (reverse) {
+            uint16_t src_line = image->lines - 1 - i;
+            printspider_image_seek(&reader, src_line);
+            for (int c = 0; c < 3; c++) {
+                printspider_dither_seek_row(&dither[c], src_line);
+            }
+        }
+        printspider_image_read_line(&reader, dither, pixels, line);
+        printspider_swath_push(&swath, line, nozdata[firings++]);
+    }
+    for (int i = printspider_swath_pending(&swath) + BIDI_ALIGN_MAX - align;
+         i > 0; i--) {
+        printspider_swath_push(&swath, NULL, nozdata[firings++]);
+    }
+
+    memset(raster, 0, sizeof(raster_t));
+    for (int y = 0; y < firings; y++) {
+        int column = reverse ? firings - 1 - y + error : y;
+        if (fire(cart, nozdata[y], column, raster)) return -1;
+    }
+    return firings;
+}
+
+// The image as a unidirectional print puts it on paper: line y at column
+// `start` + y with every nozzle row.
+static void expected_raster(const cart_t *cart, const test_image_t *t,
+                            int start, raster_t raster) {
+    memset(raster, 0, sizeof(raster_t));
+    for (int y = 0; y < IMAGE_LINES; y++) {
+        for (int r = 0; r < cart->rows; r++) {
+            const uint8_t *ink = &t->ink[y][cart->color ? r * cart->width : 0];
+            for (int p = 0; p < cart->width; p++) {
+                int dot = r * cart->width + p;
+                if (ink[p] && cart->mask[dot]) {
+                    raster[start + y + RASTER_MARGIN][dot] = 1;
+                }
+            }
+        }
+    }
+}
+
+// Returns the amount of dots that differ with raster b moved by shift
+// columns.
+static int compare(raster_t a, raster_t b, int shift) {
+    int diff = 0;
+    for (int x = 0; x < RASTER_COLUMNS; x++) {
+        int bx = x - shift;
+        for (int d = 0; d < RASTER_DOTS; d++) {
+            uint8_t vb = bx >= 0 && bx < RASTER_COLUMNS ? b[bx][d] : 0;
+            diff += a[x][d] != vb;
+        }
+    }
+    return diff;
+}
+
+static int count_dots(raster_t a) {
+    int n = 0;
+    for (int x = 0; x < RASTER_COLUMNS; x++) {
+        for (int d = 0; d < RASTER_DOTS; d++) n += a[x][d];
+    }
+    return n;
+}
+
+// Returns the shift of raster b that matches a, or RASTER_COLUMNS if none.
+static int find_shift(raster_t a, raster_t b) {
+    for (int s = 0; s < 2 * RASTER_MARGIN; s++) {
+        if (!compare(a, b, s)) return s;
+        if (!compare(a, b, -s)) return -s;
+    }
+    return RASTER_COLUMNS;
+}
+
+static void write_pgm(const char *path, const cart_t *cart, raster_t a) {
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    // Nozzles down, carriage columns across, nozzle rows one under another.
+    int dots = cart->rows * cart->width;
+    fprintf(f, "P5\n%d %d\n255\n", RASTER_COLUMNS, dots);
+    for (int d = 0; d < dots; d++) {
+        for (int x = 0; x < RASTER_COLUMNS; x++) fputc(a[x][d] ? 0 : 255, f);
+    }
+    fclose(f);
+}
+
+static raster_t expected, forward, reverse;
+
+// Prints one image both ways, returns 1 if both passes match the
+// unidirectional print.
+static int run(const cart_t *cart, const char *name, const test_image_t *t,
+               const settings_t *s, const char *pgm) {
+    int start = BIDI_ALIGN_MAX + s->forward;
+    expected_raster(cart, t, start, expected);
+    int ff = print_pass(cart, &t->image, 0, s->forward, 0, forward);
+    int fr = print_pass(cart, &t->image, 1, s->reverse, s->error, reverse);
+    if (ff < 0 || fr < 0) {
+        printf("%-6s %-12s waveform decode failed\n", cart->name, name);
+        return 0;
+    }
+    int df = compare(expected, forward, 0);
+    int dr = compare(expected, reverse, 0);
+    int shift = dr ? find_shift(expected, reverse) : 0;
+    char shift_text[16] = "none";
+    if (shift != RASTER_COLUMNS) snprintf(shift_text, 16, "%+d", shift);
+    printf("%-6s %-12s %3d %3d %+4d %+4d %+4d %6d %6d %6d %6s\n", cart->name,
+           name, ff, fr, s->error, s->forward, s->reverse,
+           count_dots(expected), df, dr, shift_text);
+    if (pgm) {
+        char path[256];
+        snprintf(path, sizeof(path), "%s_%s_%s_forward.pgm", pgm, cart->name,
+                 name);
+        write_pgm(path, cart, forward);
+        snprintf(path, sizeof(path), "%s_%s_%s_reverse.pgm", pgm, cart->name,
+                 name);
+        write_pgm(path, cart, reverse);
+    }
+    return !df && !dr;
+}
+
+// Checks a pass of the redundant mode against the image, returns 1 if every
+// dot is fired once by a working nozzle and, with `solid`, no nozzle fires
+// twice in a row.
+static int check_redundant_pass(const cart_t *cart, const char *name,
+                                const test_image_t *t, int reverse, int solid,
+                                int dead_count) {
+    int start = BIDI_ALIGN_MAX;
+    if (print_pass(cart, &t->image, reverse, 0, 0, forward) < 0) {
+        printf("%-6s %-12s waveform decode failed\n", cart->name, name);
+        return 0;
+    }
+    int w = cart->width;
+    int missing = 0, twice = 0, repeated = 0, dead_fired = 0;
+    for (int x = 0; x < RASTER_COLUMNS; x++) {
+        int y = x - start - RASTER_MARGIN;
+        for (int p = 0; p < w; p++) {
+            uint8_t a = forward[x][p];
+            uint8_t b = forward[x][w + p];
+            int dead0 = PRINTSPIDER_ROW_BIT(dead, p);
+            int dead1 = PRINTSPIDER_ROW_BIT(dead, w + p);
+            if ((a && dead0) || (b && dead1)) dead_fired++;
+            if (a && b) twice++;
+            // Dots of nozzles that aren't connected can't be checked.
+            int ink = y >= 0 && y < IMAGE_LINES && t->ink[y][p];
+            if (ink && cart->mask[p] && cart->mask[w + p] &&
+                !(dead0 && dead1) && !a && !b) {
+                missing++;
+            }
+            // Consecutive columns of a dot are consecutive firings of its
+            // nozzle; failed nozzles leave the other one on its own.
+            if (solid && x > 0 && !dead0 && !dead1 &&
+                ((a && forward[x - 1][p]) || (b && forward[x - 1][w + p]))) {
+                repeated++;
+            }
+        }
+    }
+    printf("%-6s %-12s %-7s %4d %7d %7d %7d %7d\n", cart->name, name,
+           reverse ? "reverse" : "forward", dead_count, missing, twice,
+           repeated, dead_fired);
+    return !missing && !twice && !repeated && !dead_fired;
+}
+
+// Runs the redundant mode of the black cartridge in both directions, with and
+// without failed nozzles, returns the amount of passes that failed.
+static int run_redundant(void) {
+    static test_image_t t;
+    static cart_t cart;
+    // Nozzles of the first row, then of the second one; 41 failed in both.
+    static const int failed_nozzles[] = {5, 40, 41, 120,
+                                         PRINTSPIDER_BLACK_NOZZLES_IN_ROW + 41,
+                                         PRINTSPIDER_BLACK_NOZZLES_IN_ROW + 90};
+    int failed = 0;
+    cart_init(&cart, 0);
+    redundant = 1;
+    printf("\ncart   image        pass    dead missing   twice  repeat  "
+           "d_dead\n");
+    for (int d = 0; d < 2; d++) {
+        memset(dead, 0, sizeof(dead));
+        int dead_count = d ? (int)(sizeof(failed_nozzles) / sizeof(int)) : 0;
+        for (int i = 0; i < dead_count; i++) {
+            dead[failed_nozzles[i] / 8] |= 0x80 >> (failed_nozzles[i] % 8);
+        }
+        for (int pattern = 2; pattern < 4; pattern++) {
+            make_image(&t, &cart, pattern, PRINTSPIDER_IMAGE_PACKED, 1);
+            for (int reverse = 0; reverse < 2; reverse++) {
+                failed += !check_redundant_pass(
+                    &cart, pattern == 3 ? "solid" : "noise", &t, reverse,
+                    pattern == 3, dead_count);
+            }
+        }
+    }
+    redundant = 0;
+    memset(dead, 0, sizeof(dead));
+    return failed;
+}
+
+static const char *image_names[] = {"lines",     "text",     "noise",
+                                    "lines_rle", "text_rle", "text_scan",
+                                    "grey_rle"};
+
+#define IMAGE_COUNT ((int)(sizeof(image_names) / sizeof(image_names[0])))
+
+// Runs all test images on both cartridges, returns the amount that failed.
+static int run_all(const settings_t *s, const char *pgm) {
+    static test_image_t t;
+    static cart_t carts[2];
+    int failed = 0;
+    for (int color = 0; color < 2; color++) {
+        cart_t *cart = &carts[color];
+        cart_init(cart, color);
+        for (int i = 0; i < IMAGE_COUNT; i++) {
+            // Packed images, then RLE with an index and RLE without one, then
+            // the grey image in the ordered dither.
+            int format =
+                i < 3 ? PRINTSPIDER_IMAGE_PACKED : PRINTSPIDER_IMAGE_RLE;
+            int pattern = i < 3 ? i : (i == 3 ? 0 : (i == 6 ? PATTERN_GREY : 1));
+            make_image(&t, cart, pattern, format, i != 5);
+            dither_mode = pattern == PATTERN_GREY ? PRINTSPIDER_DITHER_ORDERED
+                                                  : PRINTSPIDER_DITHER_DIFFUSION;
+            failed += !run(cart, image_names[i], &t, s, pgm);
+        }
+        dither_mode = PRINTSPIDER_DITHER_DIFFUSION;
+    }
+    return failed;
+}
+
+int main(int argc, char **argv) {
+    settings_t one = {0, 0, 0};
+    int custom = 0;
+    const char *pgm = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && !strcmp(argv[i], "--error")) {
+            one.error = atoi(argv[++i]);
+        } else if (i + 1 < argc && !strcmp(argv[i], "--forward")) {
+            one.forward = atoi(argv[++i]);
+        } else if (i + 1 < argc && !strcmp(argv[i], "--reverse")) {
+            one.reverse = atoi(argv[++i]);
+        } else if (i + 1 < argc && !strcmp(argv[i], "--pgm")) {
+            pgm = argv[++i];
+            continue;
+        } else {
+            fprintf(stderr,
+                    "usage: %s [--error E] [--forward N] [--reverse N] "
+                    "[--pgm PREFIX]\n",
+                    argv[0]);
+            return 2;
+        }
+        custom = 1;
+    }
+    if (abs(one.forward) > BIDI_ALIGN_MAX ||
+        abs(one.reverse) > BIDI_ALIGN_MAX) {
+        fprintf(stderr, "alignment is out of range, max %d\n", BIDI_ALIGN_MAX);
+        return 2;
+    }
+
+    // Firings of both passes, the landing error of reverse passes and the
+    // alignment, dots of the image, dots that differ from a unidirectional
+    // print per pass, and the shift that would line up the reverse pass.
+    printf(
+        "cart   image        ff  fr error  fwd  rev   dots d_fwd  d_rev  "
+        "shift\n");
+    if (custom) return run_all(&one, pgm) ? 1 : 0;
+
+    // Without options: no error, then errors corrected by the alignment,
+    // which must all line up, then an uncorrected error, which must be found.
+    static const settings_t aligned[] = {
+        {0, 0, 0}, {3, 0, 3}, {3, 2, 1}, {-4, -4, 0}, {-5, -2, -3}};
+    int failed = 0;
+    for (int i = 0; i < (int)(sizeof(aligned) / sizeof(aligned[0])); i++) {
+        failed += run_all(&aligned[i], pgm);
+    }
+    const settings_t off = {3, 0, 0};
+    int off_failed = run_all(&off, NULL);
+    failed += run_redundant();
+    if (failed || off_failed != 2 * IMAGE_COUNT) {
+        printf("FAILED\n");
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
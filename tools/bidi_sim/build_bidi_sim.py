@@ -0,0 +1,5 @@
+# Adds the bidirectional printing simulation sources to the bidi_sim
+# environment; src/ holds the firmware, which only builds for AVR.
+Import("env")
+
+env.BuildSources("$BUILD_DIR/bidi_sim", "$PROJECT_DIR/tools/bidi_sim")
@@ -0,0 +1,8 @@
+# Adds the encoder stimulus sources to the encoder_sim environment and links
+# them with simavr; src/ holds the firmware, which only builds for AVR.
+Import("env")
+
+env.Append(CPPPATH=["/usr/local/include/simavr"],
+           LIBPATH=["/usr/local/lib"],
+           LIBS=["simavr", "elf"])
+env.BuildSources("$BUILD_DIR/encoder_sim", "$PROJECT_DIR/tools/encoder_sim")
@@ -0,0 +1,204 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+// Encoder stimulus for the position triggered firmware under simavr, see
+// include/trigger.h. The firmware built by the uno_trigger environment runs
+// in the simulator while quadrature edges are driven into A0 and A1 at a fixed
+// spacing, like a carriage moving at constant speed. Every row should start
+// right after the edge that makes it due: the cycles from every trigger edge
+// to the next change of the cartridge lines on PORTD and PORTB are measured,
+// and the firmware's own profile report is printed from the serial port.
+//
+// Needs simavr and libelf installed; make install RELEASE=1 in simavr puts
+// them under /usr/local.
+//
+// Run with: pio run -e uno_trigger && pio run -e encoder_sim -t exec
+// Or .pio/build/encoder_sim/program [FIRMWARE] [--period US] [--edges N]
+// [--divider N] [--back N], with --divider as TRIGGER_DIVIDER of the firmware
+// and --back edges moving backwards half way through.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "avr_ioport.h"
+#include "avr_uart.h"
+#include "sim_avr.h"
+#include "sim_cycle_timers.h"
+#include "sim_elf.h"
+#include "sim_time.h"
+
+#define DEFAULT_FIRMWARE ".pio/build/uno_trigger/firmware.elf"
+#define MAX_TRIGGERS 4096
+// Time the firmware gets after the last edge to finish and send its report.
+#define TAIL_US 500000
+
+static avr_t *mcu;
+
+// Stimulus settings and state.
+static uint32_t period_us = 2000;
+static int edges = 200;
+static int back = 0;
+static int divider = 2;
+static int edge;
+static uint8_t state;
+static int position;
+// Position where the next row is due, counted like the firmware does.
+static int next;
+static avr_irq_t *channel[2];
+
+// Trigger edges and the cycles until the lines changed, 0 if they didn't
+// before the next trigger.
+static avr_cycle_count_t trigger_at[MAX_TRIGGERS];
+static avr_cycle_count_t latency[MAX_TRIGGERS];
+static int triggers;
+static int waiting;
+static uint32_t port_value[2];
+
+// Quadrature states going forward, channel A leading.
+static const uint8_t gray[4] = {0, 1, 3, 2};
+
+static avr_cycle_count_t drive_edge(avr_t *avr, avr_cycle_count_t when,
+                                    void *param) {
+    (void)param;
+    if (edge >= edges) return 0;
+    int half = (edges - back) / 2;
+    int dir = (edge >= half && edge < half + back) ? -1 : 1;
+    edge++;
+    state = (state + dir) & 3;
+    avr_raise_irq(channel[0], gray[state] & 1);
+    avr_raise_irq(channel[1], gray[state] >> 1);
+    position += dir;
+    if (position >= next) {
+        next += divider;
+        if (triggers < MAX_TRIGGERS) {
+            trigger_at[triggers++] = when;
+            waiting = 1;
+        }
+    }
+    return when + avr_usec_to_cycles(avr, period_us);
+}
+
+static void port_changed(struct avr_irq_t *irq, uint32_t value, void *param) {
+    (void)irq;
+    int port = (int)(intptr_t)param;
+    if (port_value[port] == value) return;
+    port_value[port] = value;
+    if (waiting) {
+        waiting = 0;
+        latency[triggers - 1] = mcu->cycle - trigger_at[triggers - 1];
+    }
+}
+
+static void uart_output(struct avr_irq_t *irq, uint32_t value, void *param) {
+    (void)irq;
+    (void)param;
+    if (value != '\r') putchar(value);
+}
+
+int main(int argc, char **argv) {
+    const char *firmware = DEFAULT_FIRMWARE;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--period") && i + 1 < argc) {
+            period_us = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--edges") && i + 1 < argc) {
+            edges = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--divider") && i + 1 < argc) {
+            divider = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--back") && i + 1 < argc) {
+            back = atoi(argv[++i]);
+        } else if (argv[i][0] != '-') {
+            firmware = argv[i];
+        } else {
+            fprintf(stderr,
+                    "usage: %s [FIRMWARE] [--period US] [--edges N] "
+                    "[--divider N] [--back N]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (period_us < 1 || divider < 1 || back < 0 || back > edges) {
+        fprintf(stderr, "bad stimulus settings\n");
+        return 2;
+    }
+    next = divider;
+
+    elf_firmware_t f;
+    memset(&f, 0, sizeof(f));
+    if (elf_read_firmware(firmware, &f)) {
+        fprintf(stderr, "can't read %s\n", firmware);
+        return 1;
+    }
+    mcu = avr_make_mcu_by_name("atmega328p");
+    if (!mcu) return 1;
+    avr_init(mcu);
+    mcu->frequency = 16000000;
+    avr_load_firmware(mcu, &f);
+
+    // The report goes to our output only, without simavr's line log.
+    uint32_t flags = 0;
+    avr_ioctl(mcu, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+    flags &= ~AVR_UART_FLAG_STDIO;
+    avr_ioctl(mcu, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+    avr_irq_register_notify(
+        avr_io_getirq(mcu, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT),
+        uart_output, NULL);
+
+    channel[0] = avr_io_getirq(mcu, AVR_IOCTL_IOPORT_GETIRQ('C'), 0);
+    channel[1] = avr_io_getirq(mcu, AVR_IOCTL_IOPORT_GETIRQ('C'), 1);
+    avr_irq_register_notify(
+        avr_io_getirq(mcu, AVR_IOCTL_IOPORT_GETIRQ('D'), IOPORT_IRQ_PIN_ALL),
+        port_changed, (void *)0);
+    avr_irq_register_notify(
+        avr_io_getirq(mcu, AVR_IOCTL_IOPORT_GETIRQ('B'), IOPORT_IRQ_PIN_ALL),
+        port_changed, (void *)1);
+    // Give the firmware time to queue its first rows.
+    avr_cycle_timer_register_usec(mcu, 10000, drive_edge, NULL);
+
+    avr_cycle_count_t end = 0;
+    int cpu = cpu_Running;
+    while (cpu != cpu_Done && cpu != cpu_Crashed) {
+        cpu = avr_run(mcu);
+        if (edge >= edges && !end) {
+            end = mcu->cycle + avr_usec_to_cycles(mcu, TAIL_US);
+        }
+        if (end && mcu->cycle >= end) break;
+    }
+    fflush(stdout);
+
+    int rows = 0;
+    avr_cycle_count_t min = 0, max = 0, sum = 0;
+    for (int i = 0; i < triggers; i++) {
+        if (!latency[i]) continue;
+        if (!rows || latency[i] < min) min = latency[i];
+        if (latency[i] > max) max = latency[i];
+        sum += latency[i];
+        rows++;
+    }
+    printf("encoder edges %d position %d triggers %d rows_out %d\n", edge,
+           position, triggers, rows);
+    if (rows) {
+        double mhz = mcu->frequency / 1e6;
+        printf("latency_cycles min %llu mean %llu max %llu\n",
+               (unsigned long long)min, (unsigned long long)(sum / rows),
+               (unsigned long long)max);
+        printf("latency_us min %.1f mean %.1f max %.1f\n", min / mhz,
+               sum / rows / mhz, max / mhz);
+    }
+    return cpu == cpu_Crashed;
+}
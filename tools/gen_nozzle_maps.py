@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+# Copyright 2021 Pavel Semenov
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Generates lib/PrintSpider/printspider_nozmap.h.
+
+The tables map every pixel of a color or black image row straight to the
+nozzle data byte and bit that printspider_set_nozzle_color and
+printspider_set_nozzle_black would set for it, so the bulk row setters need
+no division or nested lookups. Run it after changing the nozzle order tables
+in printspider.c:
+
+    python3 tools/gen_nozzle_maps.py
+"""
+
+import os
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+OUTPUT = os.path.join(ROOT, "lib", "PrintSpider", "printspider_nozmap.h")
+
+COLOR_NOZZLES_IN_ROW = 84
+COLOR_VERTICAL_OFFSET = 14
+BLACK_NOZZLES_IN_ROW = 168
+
+# Byte order tables from printspider_set_nozzle_color.
+COLOR_BO = [
+    [8, 13, 4, 9, 0, 5, 10, 1, 6, 11, 2, 7, 12, 3],
+    [11, 2, 7, 12, 3, 8, 13, 4, 9, 0, 5, 10, 1, 6],
+    [0, 5, 10, 1, 6, 11, 2, 7, 12, 3, 8, 13, 4, 9],
+]
+
+# Nozzle order tables from printspider_set_nozzle_black.
+BLACK_NI = [
+    (2, 0, 1), (2, 1, 1), (1, 0, 1), (1, 1, 1), (0, 0, 1), (0, 1, 1),
+    (2, 4, 1), (2, 5, 1), (1, 4, 1), (1, 5, 1), (0, 4, 1), (0, 5, 1),
+    (2, 2, 0), (2, 3, 0), (1, 2, 0), (1, 3, 0), (0, 2, 0), (0, 3, 0),
+    (2, 6, 0), (2, 7, 0), (1, 6, 0), (1, 7, 0), (0, 6, 0), (0, 7, 0),
+]
+BLACK_BO = [
+    [4, 12, 10, 2, 8, 0, 6, 13, 7, 1, 9, 3, 11, 5],
+    [13, 7, 1, 9, 3, 11, 5, 4, 12, 10, 2, 8, 0, 6],
+]
+
+
+def color_nozzle(p, color):
+    return COLOR_BO[color][p % 14] + 14 * color, 1 << (p // 14)
+
+
+def black_nozzle(p, row):
+    if row:
+        p += 168
+    j = p // 14
+    k = 13 - (p % 14)
+    c, bit, order = BLACK_NI[j]
+    return c * 14 + BLACK_BO[order][k], 1 << bit
+
+
+def table(name, entries):
+    lines = ["static const printspider_nozmap_t %s[] PROGMEM = {" % name]
+    for i in range(0, len(entries), 6):
+        chunk = entries[i:i + 6]
+        lines.append("    " + " ".join("{%d, 0x%02x}," % e for e in chunk))
+    lines.append("};")
+    lines.append("")
+    return lines
+
+
+def main():
+    lines = [
+        "// Generated by tools/gen_nozzle_maps.py from the nozzle order tables",
+        "// in printspider.c. Do not edit.",
+        "",
+    ]
+    for color, name in enumerate(("c", "m", "y")):
+        entries = [color_nozzle(y + COLOR_VERTICAL_OFFSET, color)
+                   for y in range(COLOR_NOZZLES_IN_ROW)]
+        lines += table("nozmap_color_%s" % name, entries)
+    for row in range(2):
+        entries = [black_nozzle(y, row) for y in range(BLACK_NOZZLES_IN_ROW)]
+        lines += table("nozmap_black_%d" % row, entries)
+    with open(OUTPUT, "w") as f:
+        f.write("\n".join(lines))
+
+
+if __name__ == "__main__":
+    main()
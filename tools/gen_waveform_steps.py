@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+# Copyright 2021 Pavel Semenov
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Generates lib/PrintSpider/printspider_steps.h from the waveform templates.
+
+For every step of every template in printspider.c this precomputes what
+printspider_generate_waveform derives at runtime: the output word with the
+csync line resolved for normal and last packets, and the data bit sent in
+that step. Run it after changing a template:
+
+    python3 tools/gen_waveform_steps.py
+"""
+
+import os
+import re
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE = os.path.join(ROOT, "lib", "PrintSpider", "printspider.c")
+OUTPUT = os.path.join(ROOT, "lib", "PrintSpider", "printspider_steps.h")
+
+TP_BIT_TOGGLE = 0x0003
+TP_CSYNC_LAST = 1 << 14
+TP_CSYNC_NORM = 1 << 15
+OUT_DATA = 0x0007
+OUT_CSYNC = 1 << 3
+
+
+def read_templates():
+    text = open(SOURCE).read()
+    templates = []
+    for m in re.finditer(r"static uint16_t (waveform_tpl_\w+)\[\] = \{(.*?)\};",
+                         text, re.S):
+        values = [int(v, 0) for v in m.group(2).replace("\n", " ").split(",")
+                  if v.strip()]
+        templates.append((m.group(1), values))
+    return templates
+
+
+def steps(template):
+    # Mirrors the bit tracking in packet_word(), including the 8-bit wrap of
+    # the bit mask.
+    bit = 0
+    ov = 0
+    out = []
+    for v in template:
+        if v & TP_BIT_TOGGLE != ov:
+            bit = 1 if not bit else (bit << 1) & 0xff
+            ov = v & TP_BIT_TOGGLE
+        en = v & TP_BIT_TOGGLE
+        base = v & ~(OUT_CSYNC | OUT_DATA) & 0xffff
+        if en and not bit:
+            # No data bit left: the generator always drives the lines high.
+            base |= OUT_DATA
+        words = []
+        for sel in (TP_CSYNC_NORM, TP_CSYNC_LAST):
+            words.append(base | (OUT_CSYNC if base & sel else 0))
+        out.append((words, bit if en else 0))
+    return out
+
+
+def main():
+    lines = [
+        "// Generated by tools/gen_waveform_steps.py from the templates in",
+        "// printspider.c. Do not edit.",
+        "",
+    ]
+    for name, template in read_templates():
+        lines.append("static const printspider_waveform_step_t %s_steps[] PROGMEM = {"
+                     % name[len("waveform_"):])
+        for words, bit in steps(template):
+            lines.append("    {{0x%04x, 0x%04x}, 0x%02x}," % (words[0], words[1], bit))
+        lines.append("};")
+        lines.append("")
+    with open(OUTPUT, "w") as f:
+        f.write("\n".join(lines))
+
+
+if __name__ == "__main__":
+    main()
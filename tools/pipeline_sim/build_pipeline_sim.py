@@ -0,0 +1,8 @@
+# Adds the pipeline simulation sources to the pipeline_sim environment. They
+# build src/pipeline.c and src/trigger.c against the stand-in AVR headers in
+# tools/pipeline_sim/stub; src/ as a whole only builds for AVR.
+Import("env")
+
+env.Append(CPPPATH=["$PROJECT_DIR/tools/pipeline_sim/stub",
+                    "$PROJECT_DIR/include", "$PROJECT_DIR/src"])
+env.BuildSources("$BUILD_DIR/pipeline_sim", "$PROJECT_DIR/tools/pipeline_sim")
@@ -0,0 +1,525 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Host simulation of the print pipeline and the position triggers, see
+// include/pipeline.h and include/trigger.h. src/pipeline.c and src/trigger.c
+// run unchanged against a simulated Timer2, quadrature encoder and interrupt
+// flag. Emitting a packet takes its length in words at EMIT_WORD_CYCLES,
+// generating it takes no time, and the timer stands still while the
+// interrupt runs, as it is restarted at its end. Interrupts come in as soon as they are
+// enabled; in the main context
+// the Timer2 interrupt can also be raised between any two accesses of the
+// ring indexes of the pipeline. Every row is stamped with its number before
+// it is committed, and the rows the interrupt generates packets of are
+// checked to come in order and to stay untouched while they are out.
+//
+// The cases: a carriage slower and faster than the row rate, moving back and
+// forth, edges of both encoder channels at once, a trigger with no row
+// queued, a row finishing in the middle of pipeline_acquire, the free
+// running pipeline, and a free running producer that is late, which counts
+// one underrun per row slot missed and none after pipeline_flush.
+//
+// Run with: pio run -e pipeline_sim -t exec
+
+#define PRINT_TRIGGERED
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pipeline.h"
+#include "sim.h"
+#include "trigger.h"
+
+#define TIMER_STEP_US 4
+#define MAX_ROWS 64
+#define MAX_TRIGGERS 256
+
+volatile uint8_t TCCR2A, TCCR2B, OCR2A, TCNT2, TIFR2, TIMSK2;
+volatile uint8_t PORTB, PORTC, PORTD, DDRC, PINC;
+volatile uint8_t PCMSK1, PCIFR, PCICR;
+
+// Pipeline under test, triggered or free running.
+typedef struct sim_pipeline_t {
+    void (*start)(const printspider_waveform_desc_t *waveform);
+    uint8_t *(*acquire)(void);
+    void (*commit)(void);
+    void (*flush)(void);
+    void (*get_stats)(pipeline_stats_t *stats);
+    void (*reset)(void);
+    uint8_t (*queued)(void);
+    uint8_t (*rows)(void);
+    void (*timer_vector)(void);
+} sim_pipeline_t;
+
+static const sim_pipeline_t triggered = {
+    pipeline_start,   pipeline_acquire,    pipeline_commit,
+    pipeline_flush,   pipeline_get_stats,  sim_pipeline_reset,
+    sim_pipeline_queued, sim_pipeline_rows, TIMER2_COMPA_vect};
+
+static const sim_pipeline_t free_running = {
+    free_pipeline_start,       free_pipeline_acquire,
+    free_pipeline_commit,      free_pipeline_flush,
+    free_pipeline_get_stats,   free_sim_pipeline_reset,
+    free_sim_pipeline_queued,  free_sim_pipeline_rows,
+    free_TIMER2_COMPA_vect};
+
+static const sim_pipeline_t *pipeline;
+static printspider_waveform_desc_t waveform;
+// Packets per row, time from the start of a row to the start of its last
+// packet and to the start of the next row, packets back to back.
+static int row_packets;
+static uint32_t last_packet_us;
+static uint32_t row_us;
+
+static uint32_t now_us;
+static uint8_t irq_enabled;
+static uint8_t in_isr;
+static uint8_t tick_pending;
+// Access of the ring indexes to raise the timer interrupt at, 0 for none.
+static int tick_at_access;
+static int accesses;
+
+// Rows stamped and committed by the main context, and the most it commits.
+static int committed;
+static int commit_limit;
+// Rows the interrupt started, with their start times.
+static int rows_seen;
+static uint32_t row_start[MAX_ROWS];
+static int out_seq;
+// End of the last emit, and packets of a row that didn't start a gap after
+// the one before.
+static uint32_t emit_end_us;
+static int gap_errors;
+// Trigger positions the simulation expects, with their times.
+static int triggers;
+static uint32_t trigger_at[MAX_TRIGGERS];
+static int position;
+static int next_trigger;
+static uint8_t phase;
+
+static int failures;
+static const char *case_name;
+
+// Quadrature states going forward, channel A leading.
+static const uint8_t gray[4] = {0, 1, 3, 2};
+
+static void fail(const char *what, int value) {
+    printf("FAIL %s: %s (%d)\n", case_name, what, value);
+    failures++;
+}
+
+uint32_t micros(void) { return now_us; }
+
+static void run_isr(void (*vector)(void)) {
+    in_isr = 1;
+    irq_enabled = 0;
+    vector();
+    irq_enabled = 1;
+    in_isr = 0;
+}
+
+static void deliver(void) {
+    while (tick_pending && (TIMSK2 & _BV(OCIE2A)) && irq_enabled && !in_isr) {
+        tick_pending = 0;
+        run_isr(pipeline->timer_vector);
+    }
+}
+
+static void raise_tick(void) {
+    if (!(TIMSK2 & _BV(OCIE2A))) return;
+    tick_pending = 1;
+    deliver();
+}
+
+uint8_t sim_irq_save(void) {
+    uint8_t enabled = irq_enabled;
+    irq_enabled = 0;
+    return enabled;
+}
+
+void sim_irq_restore(uint8_t enabled) {
+    irq_enabled = enabled;
+    if (enabled) deliver();
+}
+
+void sim_access(void) {
+    if (in_isr || !tick_at_access) return;
+    if (++accesses == tick_at_access) raise_tick();
+}
+
+// Fills a row with a pattern of its number.
+static void stamp(uint8_t *nozdata, int seq) {
+    nozdata[0] = seq;
+    for (int i = 1; i < PRINTSPIDER_NOZDATA_SZ; i++) {
+        nozdata[i] = (uint8_t)(seq * 37 + i * 11) | 1;
+    }
+}
+
+static int stamped(const uint8_t *nozdata, int seq) {
+    uint8_t expected[PRINTSPIDER_NOZDATA_SZ];
+    stamp(expected, seq);
+    return memcmp(nozdata, expected, sizeof(expected)) == 0;
+}
+
+const uint16_t *emit_next_packet(printspider_waveform_cursor_t *cursor,
+                                 int *len) {
+    static uint16_t w[PRINTSPIDER_IDLE_WORDS + 128];
+    if (cursor->pos == 0) {
+        out_seq = cursor->nozdata[0];
+        if (out_seq != rows_seen + 1) fail("row out of order", out_seq);
+        if (rows_seen < MAX_ROWS) row_start[rows_seen] = now_us;
+        rows_seen++;
+    }
+    if (!stamped(cursor->nozdata, out_seq)) {
+        fail("row changed while it is out", out_seq);
+    }
+    if (cursor->pos && now_us - emit_end_us != PIPELINE_GAP_US) gap_errors++;
+    *len = printspider_waveform_next_packet(cursor, w);
+    return w;
+}
+
+// Time the emission loop takes for `len` words.
+static uint32_t emit_us(int len) {
+    return (uint32_t)len * EMIT_WORD_CYCLES / (F_CPU / 1000000UL);
+}
+
+void emit_pairs(const uint16_t *pairs, int len) {
+    (void)pairs;
+    now_us += emit_us(len);
+    emit_end_us = now_us;
+}
+
+void emit_idle(int len) {
+    now_us += emit_us(len);
+    emit_end_us = now_us;
+}
+
+// Commits the next row if there is room, like row_end in src/main.c.
+static void produce(void) {
+    while (committed < commit_limit &&
+           pipeline->queued() < pipeline->rows()) {
+        uint8_t *nozdata = pipeline->acquire();
+        stamp(nozdata, ++committed);
+        pipeline->commit();
+    }
+}
+
+// Timer2 in CTC mode at clk/64: a compare match every OCR2A + 1 counts.
+static void step(void) {
+    now_us += TIMER_STEP_US;
+    if (!(TIMSK2 & _BV(OCIE2A))) return;
+    if (TCNT2 == OCR2A) {
+        TCNT2 = 0;
+        raise_tick();
+    } else {
+        TCNT2++;
+    }
+}
+
+// Runs for `us`, the time packets take to emit included.
+static void advance(uint32_t us) {
+    uint32_t end = now_us + us;
+    while ((int32_t)(end - now_us) > 0) {
+        produce();
+        step();
+    }
+}
+
+// Moves the encoder by one count, both channels at once for `both`.
+static void encoder_edge(int dir, int both) {
+    uint32_t at = now_us;
+    phase = (phase + (both ? 2 : dir)) & 3;
+    PINC = (PINC & ~0x03) | gray[phase];
+    run_isr(PCINT1_vect);
+    if (both) return;
+    position += dir;
+    if (position >= next_trigger) {
+        next_trigger += TRIGGER_DIVIDER;
+        if (triggers < MAX_TRIGGERS) trigger_at[triggers] = at;
+        triggers++;
+    }
+}
+
+// Lets the rows left out, triggered ones a row and a half apart, and stops
+// the pipeline as soon as they are.
+static void drain(void) {
+    uint32_t start = now_us;
+    uint32_t last_trigger = now_us;
+    while (now_us - start < 64 * row_us &&
+           (pipeline->queued() || committed < commit_limit)) {
+        produce();
+        step();
+        if (pipeline == &triggered && now_us - last_trigger >= row_us * 3 / 2) {
+            last_trigger = now_us;
+            for (int e = 0; e < TRIGGER_DIVIDER; e++) encoder_edge(1, 0);
+        }
+    }
+    if (pipeline->queued()) fail("rows left in the queue", pipeline->queued());
+    pipeline->flush();
+}
+
+static void begin_case(const char *name, const sim_pipeline_t *p,
+                       int limit) {
+    case_name = name;
+    pipeline = p;
+    now_us = 0;
+    irq_enabled = 1;
+    in_isr = 0;
+    tick_pending = 0;
+    tick_at_access = 0;
+    committed = 0;
+    commit_limit = limit;
+    rows_seen = 0;
+    gap_errors = 0;
+    triggers = 0;
+    position = 0;
+    next_trigger = TRIGGER_DIVIDER;
+    phase = 0;
+    PINC = 0;
+    TIMSK2 = 0;
+    pipeline->reset();
+    pipeline->start(&waveform);
+    if (p == &triggered) trigger_start();
+}
+
+static void end_case(int failures_before) {
+    printf("%-24s rows %3d triggers %3d %s\n", case_name, rows_seen, triggers,
+           failures == failures_before ? "OK" : "FAIL");
+}
+
+// Every row starts on its trigger.
+static void run_slow(void) {
+    int before = failures;
+    begin_case("slow carriage", &triggered, 20);
+    for (int e = 0; e < 40; e++) {
+        advance(row_us * 3 / 4);
+        encoder_edge(1, 0);
+    }
+    drain();
+    pipeline_stats_t stats;
+    pipeline_get_stats(&stats);
+    if (rows_seen != 20) fail("rows printed", rows_seen);
+    if (stats.missed_triggers) fail("missed triggers", stats.missed_triggers);
+    for (int i = 0; i < rows_seen && i < triggers; i++) {
+        if (row_start[i] != trigger_at[i]) {
+            fail("row not started on its trigger", i);
+            break;
+        }
+    }
+    end_case(before);
+}
+
+// Triggers during a row start the next one right after it, further ones are
+// dropped.
+static void run_fast(void) {
+    int before = failures;
+    begin_case("fast carriage", &triggered, 20);
+    for (int e = 0; e < 40; e++) {
+        advance(row_us / 4);
+        encoder_edge(1, 0);
+    }
+    // The late row after the last trigger.
+    advance(2 * row_us);
+    int fast_rows = rows_seen;
+    drain();
+    pipeline_stats_t stats;
+    pipeline_get_stats(&stats);
+    if (stats.triggers != triggers) fail("triggers counted", stats.triggers);
+    if (!stats.missed_triggers) fail("no missed triggers", 0);
+    if (stats.rows != rows_seen) fail("rows counted", stats.rows);
+    if (rows_seen != 20) fail("rows printed", rows_seen);
+    if (fast_rows < 2) fail("rows printed fast", fast_rows);
+    for (int i = 1; i < fast_rows; i++) {
+        if (row_start[i] - row_start[i - 1] != row_us) {
+            fail("late row not right after the last one", i);
+            break;
+        }
+    }
+    end_case(before);
+}
+
+// Each position triggers once, moving back triggers nothing.
+static void run_back_and_forth(void) {
+    int before = failures;
+    begin_case("back and forth", &triggered, 15);
+    int moves[3] = {20, -10, 20};
+    for (int m = 0; m < 3; m++) {
+        int dir = moves[m] > 0 ? 1 : -1;
+        for (int e = 0; e < abs(moves[m]); e++) {
+            advance(row_us * 3 / 4);
+            encoder_edge(dir, 0);
+        }
+    }
+    drain();
+    pipeline_stats_t stats;
+    pipeline_get_stats(&stats);
+    trigger_stats_t encoder;
+    trigger_get_stats(&encoder);
+    if (encoder.position != 30) fail("encoder position", encoder.position);
+    if (stats.triggers != 15) fail("triggers counted", stats.triggers);
+    if (rows_seen != 15) fail("rows printed", rows_seen);
+    end_case(before);
+}
+
+// Edges of both channels at once are errors and don't move the position.
+static void run_double_edges(void) {
+    int before = failures;
+    begin_case("double edges", &triggered, 2);
+    for (int e = 0; e < 6; e++) {
+        advance(row_us * 3 / 4);
+        encoder_edge(1, e % 3 == 1);
+    }
+    drain();
+    trigger_stats_t encoder;
+    trigger_get_stats(&encoder);
+    if (encoder.errors != 2) fail("encoder errors", encoder.errors);
+    if (encoder.position != 4) fail("encoder position", encoder.position);
+    if (rows_seen != 2) fail("rows printed", rows_seen);
+    end_case(before);
+}
+
+// A trigger that finds no row queued is dropped.
+static void run_empty_queue(void) {
+    int before = failures;
+    begin_case("empty queue", &triggered, 1);
+    for (int e = 0; e < 4; e++) {
+        advance(row_us * 3 / 2);
+        encoder_edge(1, 0);
+    }
+    advance(row_us * 3 / 2);
+    drain();
+    pipeline_stats_t stats;
+    pipeline_get_stats(&stats);
+    if (rows_seen != 1) fail("rows printed", rows_seen);
+    if (stats.missed_triggers != 1) {
+        fail("missed triggers", stats.missed_triggers);
+    }
+    if (stats.underruns != 1) fail("underruns", stats.underruns);
+    end_case(before);
+}
+
+// The active row finishes while the main context is in pipeline_acquire,
+// at every access of the ring indexes in turn. The row after it is still
+// queued and must not be handed out again.
+static void run_acquire_race(void) {
+    for (int k = 1; k <= 6; k++) {
+        int before = failures;
+        char name[32];
+        snprintf(name, sizeof(name), "finish in acquire #%d", k);
+        begin_case(name, &triggered, 3);
+        advance(TIMER_STEP_US);
+        encoder_edge(1, 0);
+        encoder_edge(1, 0);
+        // Row 1 is out up to the gap before its last packet, rows 2 and 3
+        // are queued.
+        advance(row_start[0] + last_packet_us - PIPELINE_GAP_US / 2 - now_us);
+        accesses = 0;
+        tick_at_access = k;
+        uint8_t *nozdata = pipeline_acquire();
+        stamp(nozdata, ++committed);
+        pipeline_commit();
+        tick_at_access = 0;
+        // The access wasn't reached, the row finishes right after.
+        if (accesses < k) raise_tick();
+        for (int e = 0; e < 6; e++) {
+            advance(row_us * 3 / 2);
+            encoder_edge(1, 0);
+        }
+        drain();
+        if (rows_seen != 4) fail("rows printed", rows_seen);
+        end_case(before);
+    }
+}
+
+// Without triggers the packets follow each other a gap apart, and the rows a
+// row time apart.
+static void run_free_running(void) {
+    int before = failures;
+    begin_case("free running", &free_running, 20);
+    while (committed < commit_limit) advance(TIMER_STEP_US);
+    drain();
+    pipeline_stats_t stats;
+    free_pipeline_get_stats(&stats);
+    if (rows_seen != 20) fail("rows printed", rows_seen);
+    if (stats.underruns) fail("underruns", stats.underruns);
+    if (gap_errors) fail("packets not a gap apart", gap_errors);
+    for (int i = 1; i < rows_seen; i++) {
+        if (row_start[i] - row_start[i - 1] != row_us) {
+            fail("rows not a row time apart", i);
+            break;
+        }
+    }
+    end_case(before);
+}
+
+// Rows that come after the last one is out: right away, half a row time,
+// a row time and a half and half a row time late, then the pipeline is
+// flushed and left idle.
+static void run_late_producer(void) {
+    static const uint32_t late_us[] = {0, 0, 1, 3, 1};
+    int before = failures;
+    begin_case("late producer", &free_running, 0);
+    for (int i = 0; i < 5; i++) {
+        while (pipeline->queued()) advance(TIMER_STEP_US);
+        advance(late_us[i] * row_us / 2);
+        // Rows are only committed here, not by produce.
+        commit_limit++;
+        uint8_t *nozdata = pipeline->acquire();
+        stamp(nozdata, ++committed);
+        pipeline->commit();
+    }
+    drain();
+    pipeline_stats_t stats;
+    free_pipeline_get_stats(&stats);
+    if (rows_seen != 5) fail("rows printed", rows_seen);
+    if (stats.underruns != 4) fail("underruns", stats.underruns);
+    advance(10 * row_us);
+    free_pipeline_get_stats(&stats);
+    if (stats.underruns != 4) fail("underruns after flush", stats.underruns);
+    end_case(before);
+}
+
+int main(void) {
+    waveform = printspider_get_waveform(PRINTSPIDER_WAVEFORM_BLACK_B);
+    uint8_t nozdata[PRINTSPIDER_NOZDATA_SZ];
+    stamp(nozdata, 1);
+    printspider_waveform_cursor_t cursor;
+    printspider_waveform_begin_fast(&cursor, &waveform, nozdata);
+    int len;
+    while ((len = printspider_waveform_skip_packet(&cursor))) {
+        last_packet_us = row_us;
+        row_us += emit_us(len) + PIPELINE_GAP_US;
+        row_packets++;
+    }
+    printf("%d packets, row time %lu us at a gap of %d us\n", row_packets,
+           (unsigned long)row_us, PIPELINE_GAP_US);
+
+    run_slow();
+    run_fast();
+    run_back_and_forth();
+    run_double_edges();
+    run_empty_queue();
+    run_acquire_race();
+    run_free_running();
+    run_late_producer();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
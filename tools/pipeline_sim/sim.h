@@ -0,0 +1,57 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Interface between the simulation and the firmware sources it builds, see
+// pipeline_sim.c.
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <string.h>
+#include <util/atomic.h>
+
+#include "Arduino.h"
+#include "emit.h"
+#include "printspider.h"
+#include "profile.h"
+
+// Called on every access of the ring indexes of the triggered pipeline, see
+// sim_pipeline.c.
+void sim_access(void);
+
+// src/pipeline.c with PRINT_TRIGGERED, under the usual names (sim_pipeline.c).
+void sim_pipeline_reset(void);
+uint8_t sim_pipeline_queued(void);
+uint8_t sim_pipeline_rows(void);
+void TIMER2_COMPA_vect(void);
+
+// src/pipeline.c without it, the free running pipeline (sim_pipeline_free.c).
+typedef struct pipeline_stats_t pipeline_stats_t;
+void free_pipeline_start(const printspider_waveform_desc_t *waveform);
+uint8_t *free_pipeline_acquire(void);
+void free_pipeline_commit(void);
+void free_pipeline_flush(void);
+void free_pipeline_get_stats(pipeline_stats_t *stats);
+void free_sim_pipeline_reset(void);
+uint8_t free_sim_pipeline_queued(void);
+uint8_t free_sim_pipeline_rows(void);
+void free_TIMER2_COMPA_vect(void);
+
+// src/trigger.c (sim_trigger.c).
+void PCINT1_vect(void);
+
+#endif
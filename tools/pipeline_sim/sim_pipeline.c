@@ -0,0 +1,55 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// src/pipeline.c with PRINT_TRIGGERED. Every access to the ring indexes head
+// and queued goes through sim_access, so the simulated Timer2 interrupt can
+// come in between any two of them, as it can on the AVR between two
+// instructions.
+#define PRINT_TRIGGERED
+
+#include "sim.h"
+
+static volatile uint8_t sim_head;
+static volatile uint8_t sim_queued;
+
+static volatile uint8_t *sim_head_ref(void) {
+    sim_access();
+    return &sim_head;
+}
+
+static volatile uint8_t *sim_queued_ref(void) {
+    sim_access();
+    return &sim_queued;
+}
+
+#define head (*sim_head_ref())
+#define queued (*sim_queued_ref())
+#include "pipeline.c"
+#undef head
+#undef queued
+
+void sim_pipeline_reset(void) {
+    sim_head = 0;
+    sim_queued = 0;
+    row_active = 0;
+    running = 0;
+    late = 0;
+    memset((void *)&stats, 0, sizeof(stats));
+}
+
+uint8_t sim_pipeline_queued(void) { return sim_queued; }
+
+uint8_t sim_pipeline_rows(void) { return PIPELINE_ROWS; }
@@ -0,0 +1,40 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// src/pipeline.c without PRINT_TRIGGERED, renamed so it links next to the
+// triggered one.
+#define pipeline_start free_pipeline_start
+#define pipeline_acquire free_pipeline_acquire
+#define pipeline_commit free_pipeline_commit
+#define pipeline_flush free_pipeline_flush
+#define pipeline_get_stats free_pipeline_get_stats
+#define TIMER2_COMPA_vect free_TIMER2_COMPA_vect
+
+#include "sim.h"
+
+#include "pipeline.c"
+
+void free_sim_pipeline_reset(void) {
+    head = 0;
+    queued = 0;
+    row_active = 0;
+    running = 0;
+    memset((void *)&stats, 0, sizeof(stats));
+}
+
+uint8_t free_sim_pipeline_queued(void) { return queued; }
+
+uint8_t free_sim_pipeline_rows(void) { return PIPELINE_ROWS; }
@@ -0,0 +1,55 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Stand-in for the Arduino core and the AVR registers the pipeline and the
+// position triggers use, for building them on the host. The registers are
+// plain variables of the simulation, interrupts go through its interrupt
+// flag, see tools/pipeline_sim/pipeline_sim.c.
+
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "printspider_pgm.h"
+
+#define F_CPU 16000000UL
+#define _BV(bit) (1 << (bit))
+#define ISR(vector) void vector(void)
+
+extern volatile uint8_t TCCR2A, TCCR2B, OCR2A, TCNT2, TIFR2, TIMSK2;
+#define WGM21 1
+#define CS22 2
+#define OCF2A 1
+#define OCIE2A 1
+
+extern volatile uint8_t PORTB, PORTC, PORTD, DDRC, PINC;
+extern volatile uint8_t PCMSK1, PCIFR, PCICR;
+#define PCIF1 1
+#define PCIE1 1
+
+uint32_t micros(void);
+
+// Clears the interrupt flag and returns its old state.
+uint8_t sim_irq_save(void);
+// Restores the interrupt flag, pending interrupts come in when it is set.
+void sim_irq_restore(uint8_t enabled);
+
+#define cli() ((void)sim_irq_save())
+#define sei() sim_irq_restore(1)
+
+#endif
@@ -0,0 +1,30 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Stand-in for avr-libc's ATOMIC_BLOCK on the simulated interrupt flag, see
+// ../Arduino.h. Leaving the block with break or return is not supported.
+
+#ifndef SIM_UTIL_ATOMIC_H
+#define SIM_UTIL_ATOMIC_H
+
+#include "Arduino.h"
+
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_BLOCK(type)                                         \
+    for (uint8_t sim_sreg_ = sim_irq_save(), sim_once_ = 1; sim_once_; \
+         sim_irq_restore(sim_sreg_), sim_once_ = 0)
+
+#endif
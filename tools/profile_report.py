@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+# Copyright 2021 Pavel Semenov
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Picks the profile report out of the simavr console output.
+
+simavr prints what the firmware sends over the serial port among its own
+messages, with terminal colors. This keeps only the lines of the report
+written by profile_dump (see include/profile.h), so the reports of two runs
+can be compared with diff:
+
+    pio run -e uno_profile -t capture > run1.txt
+    python3 tools/profile_report.py run1.txt
+
+With --compare it reads a second output and prints a stage of both reports
+and the difference of its cycles per row, the stage's cycles over the rows
+printed:
+
+    python3 tools/profile_report.py steps.txt --compare walk.txt \
+        --stage waveform
+"""
+
+import argparse
+import re
+import sys
+
+# First field of every line of the report.
+REPORT_LINES = ("stage", "dither", "nozzles", "power", "wait", "waveform",
+                "emit", "row", "rows", "triggers", "cache_hits")
+
+ESCAPE = re.compile(r"\x1b\[[0-9;]*m")
+LINE = re.compile(r"\b(%s) [a-z0-9<>=]" % "|".join(REPORT_LINES))
+
+
+def report_lines(text):
+    """Returns the report lines of the console output `text`, the last
+    report if there are several."""
+    lines = []
+    for raw in ESCAPE.sub("", text).splitlines():
+        m = LINE.search(raw)
+        if not m:
+            continue
+        line = raw[m.start():].strip()
+        if line.startswith("stage "):
+            lines = []
+        lines.append(line)
+    return lines
+
+
+def parse(lines):
+    """Returns {stage: {count, min, max, mean}} and {name: value} of the
+    other lines of a report."""
+    header = lines[0].split()
+    stages = {}
+    counters = {}
+    for line in lines[1:]:
+        fields = line.split()
+        if fields[0] in REPORT_LINES[1:8] and len(fields) == len(header):
+            stages[fields[0]] = {name: int(v) for name, v in
+                                 zip(header[1:5], fields[1:5])}
+        else:
+            for name, v in zip(fields[::2], fields[1::2]):
+                counters[name] = int(v)
+    return stages, counters
+
+
+def read_report(path):
+    if path:
+        with open(path, errors="replace") as f:
+            text = f.read()
+    else:
+        text = sys.stdin.read()
+    lines = report_lines(text)
+    if not lines:
+        sys.exit("no profile report in %s" % (path or "the input"))
+    return lines
+
+
+def compare(a, b, stage):
+    """Prints `stage` of the reports `a` and `b` and the difference of its
+    cycles per row."""
+    print("%-8s %8s %8s %8s %8s %14s" % ("report", "count", "min", "max",
+                                         "mean", "cycles_per_row"))
+    per_row = []
+    misses = []
+    for name, lines in (("a", a), ("b", b)):
+        stages, counters = parse(lines)
+        rows = counters.get("rows", 0)
+        misses.append(counters.get("cache_misses"))
+        if stage not in stages:
+            sys.exit("no %s stage in report %s" % (stage, name))
+        s = stages[stage]
+        # The mean is rounded down, the sum is off by less than the count.
+        per_row.append(s["count"] * s["mean"] / rows if rows else 0.0)
+        print("%-8s %8d %8d %8d %8d %14.1f" % (name, s["count"], s["min"],
+                                               s["max"], s["mean"],
+                                               per_row[-1]))
+    print("%-8s %14.1f cycles per row (b - a)" % ("delta",
+                                                   per_row[1] - per_row[0]))
+    # Packets from the cache cost the same in both, the difference is in the
+    # generated ones.
+    if misses[0] is not None:
+        print("cache_misses a %d b %d" % tuple(misses))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("output", nargs="?", help="console output, or stdin")
+    parser.add_argument("--compare", metavar="OUTPUT",
+                        help="console output of a second run to compare")
+    parser.add_argument("--stage", default="waveform",
+                        help="stage to compare, default waveform")
+    args = parser.parse_args()
+    lines = read_report(args.output)
+    if args.compare:
+        compare(lines, read_report(args.compare), args.stage)
+    else:
+        sys.stdout.write("\n".join(lines) + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,268 @@
+#!/usr/bin/env python3
+# Copyright 2021 Pavel Semenov
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Converts an image into a flash image header (see printspider_image.h).
+
+Reads binary PGM and PPM files, or PNG and other formats when Pillow is
+installed, and writes a C header with the PROGMEM image data and its
+printspider_image_t:
+
+    python3 tools/ps_image.py logo.png -o include/logo.h --cart black
+
+Every image row is one firing of the nozzles, so the image is as wide as the
+cartridge has nozzles in a row: 168 for black, 84 for color. Narrower images
+are padded with white. Use --columns for images drawn the other way, where
+every column is one firing and the print runs from left to right.
+
+Black images are stored 1 bit per pixel (--format packed), dithered here with
+Floyd-Steinberg error diffusion, or with a plain threshold with --threshold.
+Color images are stored as PackBits compressed 8-bit channels (--format rle)
+and dithered by the printer while printing, with an index of the line offsets
+for reading the lines backwards on reverse passes. Either format works with
+either cartridge.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+CARTS = {
+    # nozzles in a row, channels of an image line
+    "black": (168, 1),
+    "color": (84, 3),
+}
+
+
+def read_pnm(path):
+    """Returns (width, height, channels, pixels) of a binary PGM or PPM."""
+    with open(path, "rb") as f:
+        data = f.read()
+    fields = []
+    pos = 0
+    while len(fields) < 4:
+        while data[pos:pos + 1].isspace():
+            pos += 1
+        if data[pos:pos + 1] == b"#":
+            pos = data.index(b"\n", pos)
+            continue
+        end = pos
+        while not data[end:end + 1].isspace():
+            end += 1
+        fields.append(data[pos:end])
+        pos = end
+    magic, width, height, maxval = fields[0], *map(int, fields[1:])
+    if magic not in (b"P5", b"P6") or maxval != 255:
+        sys.exit("%s: only 8-bit binary PGM and PPM are supported" % path)
+    channels = 1 if magic == b"P5" else 3
+    pixels = data[pos + 1:pos + 1 + width * height * channels]
+    return width, height, channels, pixels
+
+
+def read_image(path):
+    """Returns (width, height, channels, pixels) of a grayscale or RGB
+    image."""
+    if os.path.splitext(path)[1].lower() in (".pgm", ".ppm", ".pnm"):
+        return read_pnm(path)
+    try:
+        from PIL import Image
+    except ImportError:
+        sys.exit("%s: reading this format needs Pillow" % path)
+    image = Image.open(path)
+    image = image.convert("L" if image.mode in ("1", "L", "LA") else "RGB")
+    channels = 1 if image.mode == "L" else 3
+    return image.width, image.height, channels, image.tobytes()
+
+
+def image_lines(path, cart, columns=False):
+    """Returns the image lines of path for cart, each a list of 8-bit
+    channel rows of the cartridge nozzle count: one for black, cyan, magenta
+    and yellow for color."""
+    nozzles, nchannels = CARTS[cart]
+    width, height, channels, pixels = read_image(path)
+
+    def pixel(x, y):
+        i = (y * width + x) * channels
+        return pixels[i:i + channels]
+
+    if columns:
+        count, size = width, height
+        at = lambda line, i: pixel(line, i)  # noqa: E731
+    else:
+        count, size = height, width
+        at = lambda line, i: pixel(i, line)  # noqa: E731
+    if size > nozzles:
+        sys.exit("%s: image lines are %d pixels, the %s cartridge has %d "
+                 "nozzles" % (path, size, cart, nozzles))
+    lines = []
+    for line in range(count):
+        values = [at(line, i) for i in range(size)]
+        rows = []
+        for c in range(nchannels):
+            if channels == nchannels:
+                row = bytes(v[c] for v in values)
+            elif channels == 1:
+                row = bytes(v[0] for v in values)
+            else:
+                row = bytes(sum(v) // 3 for v in values)
+            rows.append(row + bytes([255] * (nozzles - size)))
+        lines.append(rows)
+    return lines
+
+
+def pack(pixels):
+    """1 bit per pixel, MSB first, set for pixels darker than half."""
+    out = bytearray((len(pixels) + 7) // 8)
+    for i, v in enumerate(pixels):
+        if v < 128:
+            out[i // 8] |= 0x80 >> (i % 8)
+    return bytes(out)
+
+
+def diffuse(lines, channel):
+    """Floyd-Steinberg dithers one channel of the image lines, returns the
+    lines with pixels of 0 or 255."""
+    width = len(lines[0][channel])
+    error = [0.0] * (width + 2)
+    out = []
+    for line in lines:
+        next_error = [0.0] * (width + 2)
+        row = bytearray(width)
+        for x in range(width):
+            v = line[channel][x] + error[x + 1]
+            row[x] = 0 if v < 128 else 255
+            e = v - row[x]
+            error[x + 2] += e * 7 / 16
+            next_error[x] += e * 3 / 16
+            next_error[x + 1] += e * 5 / 16
+            next_error[x + 2] += e * 1 / 16
+        error = next_error
+        out.append(bytes(row))
+    return out
+
+
+def packbits(data):
+    out = bytearray()
+    i = 0
+    n = len(data)
+    while i < n:
+        j = i + 1
+        while j < n and j - i < 128 and data[j] == data[i]:
+            j += 1
+        if j - i >= 3:
+            out += bytes([257 - (j - i), data[i]])
+            i = j
+            continue
+        # Literal bytes up to the next run of three.
+        j = i
+        while j < n and j - i < 128 and \
+                not (j + 2 < n and data[j] == data[j + 1] == data[j + 2]):
+            j += 1
+        out += bytes([j - i - 1]) + data[i:j]
+        i = j
+    return bytes(out)
+
+
+def encode(lines, fmt, threshold):
+    """Returns the image data and, for RLE, the offset of every line in it."""
+    channels = len(lines[0])
+    if fmt == "rle":
+        data = b""
+        index = []
+        for line in lines:
+            index.append(len(data))
+            data += b"".join(packbits(row) for row in line)
+        return data, index
+    if not threshold:
+        dithered = [diffuse(lines, c) for c in range(channels)]
+        lines = [[dithered[c][y] for c in range(channels)]
+                 for y in range(len(lines))]
+    return b"".join(pack(row) for line in lines for row in line), None
+
+
+def header(name, source, fmt, lines, data, index):
+    channels = len(lines[0])
+    width = len(lines[0][0])
+    guard = re.sub(r"\W", "_", name).upper() + "_H"
+    out = [
+        "// Generated by tools/ps_image.py from %s. Do not edit." % source,
+        "",
+        "#ifndef %s" % guard,
+        "#define %s" % guard,
+        "",
+        '#include "printspider_image.h"',
+        "",
+        "// %d line%s of %d pixels, %d channel%s, %d bytes." %
+        (len(lines), "s" if len(lines) > 1 else "", width, channels,
+         "s" if channels > 1 else "", len(data)),
+        "static const uint8_t %s_data[] PROGMEM = {" % name,
+    ]
+    for i in range(0, len(data), 12):
+        out.append("    " + " ".join("0x%02x," % b for b in data[i:i + 12]))
+    out.append("};")
+    fields = "PRINTSPIDER_IMAGE_%s, %d, %d, %d, %s_data" % (
+        fmt.upper(), channels, width, len(lines), name)
+    if index is not None:
+        out += [
+            "",
+            "// Offset of every line in %s_data." % name,
+            "static const uint16_t %s_index[] PROGMEM = {" % name,
+        ]
+        for i in range(0, len(index), 8):
+            out.append("    " + " ".join("%d," % v for v in index[i:i + 8]))
+        out.append("};")
+        fields += ", %s_index" % name
+    out += [
+        "",
+        "static const printspider_image_t %s = {" % name,
+        "    %s};" % fields,
+        "",
+        "#endif",
+        "",
+    ]
+    return "\n".join(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("image")
+    parser.add_argument("-o", "--output", required=True,
+                        help="header file to write")
+    parser.add_argument("--cart", choices=CARTS, default="black")
+    parser.add_argument("--format", choices=("packed", "rle"),
+                        help="default is packed for black, rle for color")
+    parser.add_argument("--threshold", action="store_true",
+                        help="threshold packed images instead of dithering")
+    parser.add_argument("--columns", action="store_true",
+                        help="every image column is one firing")
+    parser.add_argument("--name", help="C name, default from the file name")
+    args = parser.parse_args()
+
+    fmt = args.format or ("packed" if args.cart == "black" else "rle")
+    name = args.name or re.sub(
+        r"\W", "_", os.path.splitext(os.path.basename(args.output))[0])
+    lines = image_lines(args.image, args.cart, args.columns)
+    if not lines:
+        sys.exit("%s: empty image" % args.image)
+    if len(lines) > 65535:
+        sys.exit("%s: too many lines" % args.image)
+    data, index = encode(lines, fmt, args.threshold)
+    source = os.path.relpath(args.image).replace(os.sep, "/")
+    with open(args.output, "w") as f:
+        f.write(header(name, source, fmt, lines, data, index))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,5 @@
+# Adds the job compiler sources to the ps_job environment; src/ holds the
+# firmware, which only builds for AVR.
+Import("env")
+
+env.BuildSources("$BUILD_DIR/ps_job", "$PROJECT_DIR/tools/ps_job")
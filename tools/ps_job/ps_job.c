@@ -0,0 +1,450 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Host compiler of print jobs (see printspider_job.h). Reads a binary PGM or
+// PPM image and prints it the way src/main.c prints the built in image:
+// every image row is dithered, combined for the offset nozzle rows by the
+// swath scheduler and fitted into the power budget, and the waveform of
+// every firing is generated with printspider_generate_waveform and converted
+// to port pairs. The packets are written compressed to a header with the
+// PROGMEM job data and its printspider_job_t, which the firmware plays back
+// with PRINT_JOB. Every row is read back from the job data and compared
+// with the generated one.
+//
+// Images are laid out like for tools/ps_image.py: every image row is one
+// firing, as wide as the cartridge has nozzles in a row, narrower images
+// are padded with white. Color images take the red, green and blue channels
+// as cyan, magenta and yellow; gray images print the same on all three.
+//
+// Build with: pio run -e ps_job
+// Run with: .pio/build/ps_job/program IMAGE -o HEADER [--cart black|color]
+// [--name NAME] [--dither random|ordered|diffusion] [--seed N]
+// [--budget N] [--next-row] [--redundant [--dead N,N...]]
+// --next-row fires the nozzles over the budget with the next row like
+// POWER_NEXT_ROW in src/main.c, instead of in extra passes of the same row.
+// --dead lists failed black nozzles like DEAD_NOZZLES in src/main.c.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "printspider.h"
+#include "printspider_dither.h"
+#include "printspider_job.h"
+#include "printspider_port.h"
+#include "printspider_power.h"
+#include "printspider_swath.h"
+
+#define WAVEFORM_BUFFER_LEN 600
+
+// Cartridge pins of src/main.c, bus[i] carries bit i of a waveform word.
+static const uint8_t bus[PRINTSPIDER_PORT_LINES] = {0, 1, 2, 3, 5, 7,
+                                                    4, 8, 9, 6, 10, 11};
+
+typedef struct options_t {
+    const char *image;
+    const char *output;
+    const char *name;
+    int color;
+    int dither;
+    uint32_t seed;
+    int budget;
+    int next_row;
+    int redundant;
+    // Failed nozzles for the redundant mode.
+    uint8_t dead[PRINTSPIDER_SWATH_DEAD_SZ];
+} options_t;
+
+typedef struct pnm_t {
+    int width;
+    int height;
+    int channels;
+    uint8_t *pixels;
+} pnm_t;
+
+// Growing buffer of the job data.
+typedef struct job_data_t {
+    uint8_t *data;
+    size_t len;
+    size_t size;
+} job_data_t;
+
+typedef struct job_stats_t {
+    long rows;
+    long blank_rows;
+    long packets;
+    long pairs;
+} job_stats_t;
+
+static void fail(const char *message, const char *what) {
+    fprintf(stderr, "ps_job: %s%s%s\n", what ? what : "", what ? ": " : "",
+            message);
+    exit(1);
+}
+
+// Returns the next header field of a PNM file, skipping comments.
+static int pnm_field(FILE *f) {
+    int c;
+    do {
+        c = fgetc(f);
+        if (c == '#') {
+            while (c != '\n' && c != EOF) c = fgetc(f);
+        }
+    } while (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+    int v = 0;
+    while (c >= '0' && c <= '9') {
+        v = v * 10 + c - '0';
+        c = fgetc(f);
+    }
+    return v;
+}
+
+// Reads an 8-bit binary PGM or PPM.
+static void read_pnm(const char *path, pnm_t *img) {
+    FILE *f = fopen(path, "rb");
+    if (!f) fail("can't open", path);
+    char magic[2];
+    if (fread(magic, 1, 2, f) != 2 || magic[0] != 'P' ||
+        (magic[1] != '5' && magic[1] != '6')) {
+        fail("only 8-bit binary PGM and PPM are supported", path);
+    }
+    img->channels = magic[1] == '5' ? 1 : 3;
+    img->width = pnm_field(f);
+    img->height = pnm_field(f);
+    if (pnm_field(f) != 255 || img->width <= 0 || img->height <= 0) {
+        fail("only 8-bit binary PGM and PPM are supported", path);
+    }
+    size_t size = (size_t)img->width * img->height * img->channels;
+    img->pixels = malloc(size);
+    if (!img->pixels || fread(img->pixels, 1, size, f) != size) {
+        fail("image data is short", path);
+    }
+    fclose(f);
+}
+
+// Writes the 8-bit channel `c` of image row `y`, padded with white, to
+// `pixels` of `width` bytes.
+static void image_row(const pnm_t *img, int y, int c, uint8_t *pixels,
+                      int width) {
+    memset(pixels, 255, width);
+    for (int x = 0; x < img->width; x++) {
+        const uint8_t *v = &img->pixels[((size_t)y * img->width + x) *
+                                        img->channels];
+        pixels[x] = img->channels == 1 ? v[0] : v[c];
+    }
+}
+
+static void put_bytes(job_data_t *job, const uint8_t *bytes, int len) {
+    if (job->len + len > job->size) {
+        job->size = job->size * 2 + len + 4096;
+        job->data = realloc(job->data, job->size);
+        if (!job->data) fail("out of memory", NULL);
+    }
+    memcpy(job->data + job->len, bytes, len);
+    job->len += len;
+}
+
+// Checks that the job data from `start` plays back the port pairs `w` of
+// `len` words.
+static void check_row(const job_data_t *job, size_t start, const uint16_t *w,
+                      int len, long row) {
+    static uint16_t pairs[PRINTSPIDER_JOB_PACKET_LEN];
+    printspider_job_t played = {0, 1, job->data + start};
+    printspider_job_reader_t reader;
+    printspider_job_open(&reader, &played);
+    int pos = 0;
+    for (;;) {
+        int n;
+        const uint16_t *p = printspider_job_next_packet(&reader, pairs, &n);
+        if (!p && !n) break;
+        for (int i = 0; i < n; i++, pos++) {
+            if (pos >= len || (p ? p[i] : 0) != w[pos]) {
+                fprintf(stderr, "ps_job: row %ld plays back wrong\n", row);
+                exit(1);
+            }
+        }
+    }
+    if (pos != len) {
+        fprintf(stderr, "ps_job: row %ld plays back short\n", row);
+        exit(1);
+    }
+}
+
+// Adds the firing of nozzle data `nozdata` to the job.
+static void compile_row(job_data_t *job, job_stats_t *stats,
+                        const printspider_waveform_desc_t *wf,
+                        const printspider_portmap_t *portmap,
+                        const uint8_t *nozdata) {
+    static uint16_t w[WAVEFORM_BUFFER_LEN];
+    static const uint8_t blank[PRINTSPIDER_NOZDATA_SZ];
+    uint8_t out[PRINTSPIDER_JOB_PACKET_BYTES(PRINTSPIDER_JOB_PACKET_LEN)];
+    size_t start = job->len;
+    memset(w, 0, sizeof(w));
+    int len = printspider_generate_waveform(w, wf->data, nozdata, wf->len);
+    printspider_portmap_convert(portmap, w, len);
+    if (!memcmp(nozdata, blank, sizeof(blank))) {
+        // Blank rows are only waited out, like the packet cache does.
+        put_bytes(job, out, printspider_job_encode_idle(out, len));
+        stats->blank_rows++;
+    } else {
+        // Packet boundaries from the streaming generator, which makes the
+        // same words.
+        printspider_waveform_cursor_t cursor;
+        printspider_waveform_begin(&cursor, wf->data, nozdata, wf->len);
+        int pos = 0;
+        int n;
+        while ((n = printspider_waveform_skip_packet(&cursor))) {
+            if (n > PRINTSPIDER_JOB_PACKET_LEN) {
+                fail("packet is longer than PRINTSPIDER_JOB_PACKET_LEN", NULL);
+            }
+            put_bytes(job, out,
+                      printspider_job_encode_packet(out, &w[pos], n));
+            pos += n;
+            stats->packets++;
+            stats->pairs += n;
+        }
+        if (pos != len) fail("packets don't add up to the waveform", NULL);
+    }
+    // The end marker makes the row playable on its own for the check, and is
+    // overwritten by the next row.
+    uint8_t end = 0;
+    put_bytes(job, &end, 1);
+    check_row(job, start, w, len, stats->rows);
+    job->len--;
+    stats->rows++;
+}
+
+static void compile(const options_t *o, const pnm_t *img, job_data_t *job,
+                    job_stats_t *stats, int *waveform) {
+    *waveform = o->color ? PRINTSPIDER_WAVEFORM_COLOR_B
+                         : PRINTSPIDER_WAVEFORM_BLACK_B;
+    printspider_waveform_desc_t wf = printspider_get_waveform(*waveform);
+    printspider_portmap_t portmap;
+    printspider_portmap_init(&portmap, bus, PRINTSPIDER_PORT_LINES);
+
+    static uint8_t swath_buffer[PRINTSPIDER_SWATH_COLOR_SZ];
+    printspider_swath_t swath;
+    if (o->color) {
+        printspider_swath_init_color(&swath, swath_buffer);
+    } else {
+        printspider_swath_init_black(&swath, swath_buffer);
+        printspider_swath_set_redundant(&swath, o->redundant, o->dead);
+    }
+    printspider_power_t power;
+    printspider_power_init(&power, o->budget);
+    int channels = o->color ? 3 : 1;
+    int width = o->color ? PRINTSPIDER_COLOR_NOZZLES_IN_ROW
+                         : PRINTSPIDER_BLACK_NOZZLES_IN_ROW;
+    int row_bytes = (width + 7) / 8;
+    printspider_dither_t dither[3];
+    for (int c = 0; c < channels; c++) {
+        printspider_dither_init(&dither[c], o->dither, o->seed + c);
+    }
+
+    uint8_t pixels[PRINTSPIDER_BLACK_NOZZLES_IN_ROW];
+    uint8_t line[3 * PRINTSPIDER_COLOR_ROW_BYTES];
+    uint8_t nozdata[PRINTSPIDER_NOZDATA_SZ];
+    uint8_t out[PRINTSPIDER_NOZDATA_SZ];
+    for (int y = 0;; y++) {
+        // The image lines, then what is left in the delayed nozzle rows and
+        // the power budget, as print_swath_tail in src/main.c.
+        const uint8_t *bits = NULL;
+        if (y < img->height) {
+            for (int c = 0; c < channels; c++) {
+                image_row(img, y, c, pixels, width);
+                printspider_dither_row(&dither[c], pixels,
+                                       &line[c * row_bytes], width);
+            }
+            bits = line;
+        } else if (!printspider_swath_pending(&swath) &&
+                   !printspider_power_pending(&power)) {
+            break;
+        }
+        memset(nozdata, 0, sizeof(nozdata));
+        if (bits || printspider_swath_pending(&swath)) {
+            printspider_swath_push(&swath, bits, nozdata);
+        }
+        if (o->next_row) {
+            memset(out, 0, sizeof(out));
+            printspider_power_limit(&power, nozdata, out);
+            compile_row(job, stats, &wf, &portmap, out);
+            continue;
+        }
+        uint16_t left;
+        do {
+            memset(out, 0, sizeof(out));
+            left = printspider_power_take(&power, nozdata, out);
+            compile_row(job, stats, &wf, &portmap, out);
+        } while (left);
+    }
+    uint8_t end = 0;
+    put_bytes(job, &end, 1);
+}
+
+// Writes the job as a header like tools/ps_image.py does for images.
+static void write_header(const options_t *o, const job_data_t *job,
+                         const job_stats_t *stats, int waveform) {
+    FILE *f = fopen(o->output, "w");
+    if (!f) fail("can't write", o->output);
+    char guard[256];
+    int n = 0;
+    for (const char *p = o->name; *p && n < 250; p++) {
+        char c = *p;
+        guard[n++] = c >= 'a' && c <= 'z' ? c - 'a' + 'A' : c;
+    }
+    strcpy(&guard[n], "_H");
+    fprintf(f, "// Generated by tools/ps_job from %s. Do not edit.\n\n",
+            o->image);
+    fprintf(f, "#ifndef %s\n#define %s\n\n", guard, guard);
+    fprintf(f, "#include \"printspider_job.h\"\n\n");
+    fprintf(f, "// %ld rows of the %s cartridge, %ld blank, %ld packets, %zu "
+            "bytes.\n",
+            stats->rows, o->color ? "color" : "black", stats->blank_rows,
+            stats->packets, job->len);
+    fprintf(f, "static const uint8_t %s_data[] PROGMEM = {\n", o->name);
+    for (size_t i = 0; i < job->len; i += 12) {
+        fprintf(f, "   ");
+        for (size_t k = i; k < i + 12 && k < job->len; k++) {
+            fprintf(f, " 0x%02x,", job->data[k]);
+        }
+        fprintf(f, "\n");
+    }
+    fprintf(f, "};\n\n");
+    fprintf(f, "static const printspider_job_t %s = {\n", o->name);
+    fprintf(f, "    %s, %ld, %s_data};\n\n",
+            waveform == PRINTSPIDER_WAVEFORM_COLOR_B
+                ? "PRINTSPIDER_WAVEFORM_COLOR_B"
+                : "PRINTSPIDER_WAVEFORM_BLACK_B",
+            stats->rows, o->name);
+    fprintf(f, "#endif\n");
+    fclose(f);
+}
+
+// C name from the output file name, like tools/ps_image.py.
+static char *default_name(const char *output) {
+    const char *base = strrchr(output, '/');
+    base = base ? base + 1 : output;
+    char *name = strdup(base);
+    char *dot = strrchr(name, '.');
+    if (dot) *dot = 0;
+    for (char *p = name; *p; p++) {
+        if (!(*p >= 'a' && *p <= 'z') && !(*p >= 'A' && *p <= 'Z') &&
+            !(*p >= '0' && *p <= '9')) {
+            *p = '_';
+        }
+    }
+    return name;
+}
+
+static void usage(const char *program) {
+    fprintf(stderr,
+            "usage: %s IMAGE -o HEADER [--cart black|color] [--name NAME] "
+            "[--dither random|ordered|diffusion] [--seed N] [--budget N] "
+            "[--next-row] [--redundant [--dead N,N...]]\n",
+            program);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    // Same as the defaults of src/main.c.
+    options_t o = {NULL, NULL, NULL, 0, PRINTSPIDER_DITHER_DIFFUSION, 1, -1, 0,
+                   0, {0}};
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const char *v = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!strcmp(a, "-o") && v) {
+            o.output = v;
+            i++;
+        } else if (!strcmp(a, "--cart") && v) {
+            if (strcmp(v, "black") && strcmp(v, "color")) usage(argv[0]);
+            o.color = !strcmp(v, "color");
+            i++;
+        } else if (!strcmp(a, "--name") && v) {
+            o.name = v;
+            i++;
+        } else if (!strcmp(a, "--dither") && v) {
+            if (!strcmp(v, "random")) {
+                o.dither = PRINTSPIDER_DITHER_RANDOM;
+            } else if (!strcmp(v, "ordered")) {
+                o.dither = PRINTSPIDER_DITHER_ORDERED;
+            } else if (!strcmp(v, "diffusion")) {
+                o.dither = PRINTSPIDER_DITHER_DIFFUSION;
+            } else {
+                usage(argv[0]);
+            }
+            i++;
+        } else if (!strcmp(a, "--seed") && v) {
+            o.seed = strtoul(v, NULL, 0);
+            i++;
+        } else if (!strcmp(a, "--budget") && v) {
+            o.budget = atoi(v);
+            if (o.budget < 1 || o.budget > PRINTSPIDER_POWER_GROUP_NOZZLES) {
+                usage(argv[0]);
+            }
+            i++;
+        } else if (!strcmp(a, "--next-row")) {
+            o.next_row = 1;
+        } else if (!strcmp(a, "--redundant")) {
+            o.redundant = 1;
+        } else if (!strcmp(a, "--dead") && v) {
+            // Numbered 0..167 in the first row, 168..335 in the second one.
+            for (char *p = (char *)v; *p;) {
+                long n = strtol(p, &p, 0);
+                if (n < 0 || n >= 2 * PRINTSPIDER_BLACK_NOZZLES_IN_ROW) {
+                    usage(argv[0]);
+                }
+                int row = n / PRINTSPIDER_BLACK_NOZZLES_IN_ROW;
+                int q = n % PRINTSPIDER_BLACK_NOZZLES_IN_ROW;
+                o.dead[row * PRINTSPIDER_BLACK_ROW_BYTES + q / 8] |=
+                    0x80 >> (q % 8);
+                if (*p == ',') p++;
+                else if (*p) usage(argv[0]);
+            }
+            i++;
+        } else if (a[0] != '-' && !o.image) {
+            o.image = a;
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (!o.image || !o.output) usage(argv[0]);
+    if (!o.name) o.name = default_name(o.output);
+    // The power budget defaults of src/main.c.
+    if (o.budget < 0) {
+        o.budget = o.color ? PRINTSPIDER_POWER_GROUP_NOZZLES
+                           : PRINTSPIDER_POWER_GROUP_NOZZLES / 2;
+    }
+
+    pnm_t img;
+    read_pnm(o.image, &img);
+    int width = o.color ? PRINTSPIDER_COLOR_NOZZLES_IN_ROW
+                        : PRINTSPIDER_BLACK_NOZZLES_IN_ROW;
+    if (img.width > width) {
+        fail("image rows are wider than the cartridge has nozzles", o.image);
+    }
+    job_data_t job = {NULL, 0, 0};
+    job_stats_t stats = {0, 0, 0, 0};
+    int waveform;
+    compile(&o, &img, &job, &stats, &waveform);
+    if (stats.rows > 65535) fail("too many rows", o.image);
+    write_header(&o, &job, &stats, waveform);
+    printf("%ld rows, %ld blank, %ld packets, %ld pairs, %zu bytes, "
+           "%.2f bytes per pair\n",
+           stats.rows, stats.blank_rows, stats.packets, stats.pairs, job.len,
+           stats.pairs ? (double)job.len / stats.pairs : 0.0);
+    return 0;
+}
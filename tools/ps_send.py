@@ -0,0 +1,274 @@
+#!/usr/bin/env python3
+# Copyright 2021 Pavel Semenov
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Host sender for the serial row streaming protocol (see include/stream.h).
+
+Sends an image to the printer built with PRINT_STREAM, one print row per
+frame, keeping within the credit the printer grants, and prints the printer
+status with the sustained row rate at the end. With --profile it also gets
+the cycle counts of the print path from a printer built with PRINT_PROFILE
+(see include/profile.h).
+
+The image is read the same way as by tools/ps_image.py: every image row is
+one column of nozzles, 168 pixels for black and 84 for color, or every image
+column with --columns. The
+nozzle rows of a cartridge are offset from each other, so every print row
+combines different image rows: the second black nozzle row prints the image
+row 10 rows before the first one, magenta and yellow print the image rows 16
+and 32 rows before cyan. With --lines every image row is sent once and the
+printer combines them itself, which takes less bandwidth. Without an image a
+gradient test pattern is sent.
+
+Usage:
+    python3 tools/ps_send.py PORT [image] [--cart black|color] [--columns]
+        [--baud 115200] [--packed] [--lines] [--repeat N] [--profile]
+    python3 tools/ps_send.py --dump frames.bin [image] ...
+
+Needs pyserial unless --dump is used.
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from ps_image import image_lines as read_image_lines, pack  # noqa: E402
+
+SYNC = 0xA5
+ROW_PACKED = 0x01
+ROW_BYTES = 0x02
+STATUS_REQUEST = 0x03
+END = 0x04
+LINE_PACKED = 0x05
+LINE_BYTES = 0x06
+PROFILE_REQUEST = 0x07
+CREDIT = 0x81
+STATUS = 0x82
+PROFILE = 0x83
+
+STATUS_FIELDS = ("rows", "underruns", "deferred_rows", "deferred_nozzles",
+                 "frames", "crc_errors", "frame_errors", "overruns",
+                 "dropped_nozzles")
+
+CARTS = {
+    # nozzles per nozzle row, image row offset of every nozzle row
+    "black": (168, (0, 10)),
+    "color": (84, (0, 16, 32)),
+}
+
+
+def crc8(data):
+    crc = 0
+    for c in data:
+        crc ^= c
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07 if crc & 0x80 else crc << 1) & 0xff
+    return crc
+
+
+def frame(frame_type, payload=b""):
+    body = struct.pack("<BH", frame_type, len(payload)) + bytes(payload)
+    return bytes([SYNC]) + body + bytes([crc8(body)])
+
+
+class FrameReader:
+    """Incremental parser of the frames sent by the printer."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+
+    def feed(self, data):
+        self.buffer += data
+        frames = []
+        while True:
+            start = self.buffer.find(SYNC)
+            if start < 0:
+                self.buffer.clear()
+                break
+            del self.buffer[:start]
+            if len(self.buffer) < 4:
+                break
+            length = self.buffer[2] | self.buffer[3] << 8
+            if len(self.buffer) < 5 + length:
+                break
+            body = bytes(self.buffer[1:4 + length])
+            crc = self.buffer[4 + length]
+            if crc == crc8(body):
+                frames.append((body[0], body[3:]))
+                del self.buffer[:5 + length]
+            else:
+                del self.buffer[:1]
+        return frames
+
+
+def image_lines(args, nozzles):
+    """Returns image rows as lists of per-nozzle-row pixel rows."""
+    nchannels = len(CARTS[args.cart][1])
+    if not args.image:
+        # Gradient along the nozzles, shifting every row.
+        return [[bytes((x * 255 // nozzles + y * 4) % 256
+                       for x in range(nozzles))] * nchannels
+                for y in range(args.rows)]
+    lines = read_image_lines(args.image, args.cart, args.columns)
+    # Black lines have one channel, printed by both nozzle rows.
+    return [line * (nchannels // len(line)) for line in lines]
+
+
+def row_frames(args):
+    nozzles, offsets = CARTS[args.cart]
+    lines = image_lines(args, nozzles)
+    if args.lines:
+        # Black lines are printed by both nozzle rows, send them once.
+        channels = 1 if args.cart == "black" else len(offsets)
+        if args.packed:
+            return [frame(LINE_PACKED, b"".join(map(pack, line[:channels])))
+                    for line in lines]
+        return [frame(LINE_BYTES, b"".join(line[:channels]))
+                for line in lines]
+    blank = bytes([255] * nozzles)
+    frames = []
+    for y in range(len(lines) + offsets[-1]):
+        channels = []
+        for c, offset in enumerate(offsets):
+            src = y - offset
+            channels.append(lines[src][c] if 0 <= src < len(lines) else blank)
+        if args.packed:
+            frames.append(frame(ROW_PACKED, b"".join(map(pack, channels))))
+        else:
+            frames.append(frame(ROW_BYTES, b"".join(channels)))
+    return frames
+
+
+def parse_profile(lines):
+    """Returns the profile report of profile_dump as a dict."""
+    header = lines[0].split()
+    report = {"stages": {}}
+    for line in lines[1:]:
+        fields = line.split()
+        if len(fields) == len(header):
+            stage = dict(zip(header[1:5], map(int, fields[1:5])))
+            stage["buckets"] = dict(zip(header[5:], map(int, fields[5:])))
+            report["stages"][fields[0]] = stage
+        else:
+            report.update(zip(fields[::2], map(int, fields[1::2])))
+    return report
+
+
+def send(port, frames, profile):
+    reader = FrameReader()
+    credit = 0
+    status = None
+    profile_lines = None
+
+    def receive(timeout):
+        nonlocal credit, status, profile_lines
+        port.timeout = timeout
+        data = port.read(max(1, port.in_waiting))
+        for frame_type, payload in reader.feed(data):
+            if frame_type == CREDIT:
+                credit += struct.unpack("<H", payload)[0]
+            elif frame_type == STATUS:
+                status = dict(zip(STATUS_FIELDS, struct.unpack(
+                    "<%dH" % len(STATUS_FIELDS), payload)))
+            elif frame_type == PROFILE and profile_lines is not None:
+                if payload:
+                    profile_lines.append(payload.decode())
+                else:
+                    status["profile"] = parse_profile(profile_lines)
+
+    # Opening the port resets the board, wait for the first credit.
+    deadline = time.time() + 5
+    while not credit:
+        if time.time() > deadline:
+            sys.exit("no credit from the printer")
+        receive(0.1)
+
+    data = b"".join(frames) + frame(END)
+    start = time.time()
+    pos = 0
+    while pos < len(data):
+        if credit:
+            chunk = data[pos:pos + credit]
+            port.write(chunk)
+            pos += len(chunk)
+            credit -= len(chunk)
+        receive(0 if credit else 0.01)
+    deadline = time.time() + 10
+    while status is None:
+        if time.time() > deadline:
+            sys.exit("no status from the printer")
+        receive(0.1)
+    elapsed = time.time() - start
+    status["seconds"] = elapsed
+    status["rows_per_second"] = status["rows"] / elapsed if elapsed else 0
+    if profile:
+        profile_lines = []
+        port.write(frame(PROFILE_REQUEST))
+        deadline = time.time() + 5
+        while "profile" not in status:
+            if time.time() > deadline:
+                sys.exit("no profile from the printer, is it built with "
+                         "PRINT_PROFILE?")
+            receive(0.1)
+    return status
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("port", nargs="?", help="serial port of the printer")
+    parser.add_argument("image", nargs="?", help="image to print")
+    parser.add_argument("--cart", choices=CARTS, default="black")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--packed", action="store_true",
+                        help="threshold on the host and send 1-bit rows")
+    parser.add_argument("--columns", action="store_true",
+                        help="every image column is one firing")
+    parser.add_argument("--lines", action="store_true",
+                        help="send every image row once and let the printer "
+                        "combine them for the offset nozzle rows")
+    parser.add_argument("--repeat", type=int, default=1,
+                        help="send the image this many times")
+    parser.add_argument("--rows", type=int, default=256,
+                        help="rows of the test pattern without an image")
+    parser.add_argument("--profile", action="store_true",
+                        help="get the cycle counts of the print path")
+    parser.add_argument("--dump", metavar="FILE",
+                        help="write the frames to FILE instead of a port")
+    args = parser.parse_args()
+    if args.dump and args.port and not args.image:
+        # Only one positional argument is needed with --dump.
+        args.image, args.port = args.port, None
+
+    frames = row_frames(args) * args.repeat
+    if args.dump:
+        with open(args.dump, "wb") as f:
+            f.write(b"".join(frames) + frame(END))
+        return
+    if not args.port:
+        parser.error("port is required without --dump")
+
+    import serial
+    with serial.Serial(args.port, args.baud) as port:
+        status = send(port, frames, args.profile)
+    status["sent"] = len(frames)
+    json.dump(status, sys.stdout, indent=2)
+    sys.stdout.write("\n")
+
+
+if __name__ == "__main__":
+    main()
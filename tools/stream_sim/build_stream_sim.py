@@ -0,0 +1,10 @@
+# Adds the serial host sources to the stream_sim environment and links them
+# with simavr; src/ holds the firmware, which only builds for AVR. The
+# protocol constants come from include/stream.h.
+Import("env")
+
+env.Append(CPPPATH=["/usr/local/include/simavr", "$PROJECT_DIR/include",
+                    "$PROJECT_DIR/lib/PrintSpider"],
+           LIBPATH=["/usr/local/lib"],
+           LIBS=["simavr", "elf"])
+env.BuildSources("$BUILD_DIR/stream_sim", "$PROJECT_DIR/tools/stream_sim")
@@ -0,0 +1,316 @@
+/*
+Copyright 2021 Pavel Semenov
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Serial host for the streaming firmware under simavr, see include/stream.h.
+// The firmware built by the uno_stream environment runs in the simulator with
+// USART0 looped back to this program, which plays the part of
+// tools/ps_send.py: it waits for credit, sends 8-bit rows of a grey ramp
+// within the credit at the line rate, ends the print and reads the status.
+//
+// The print is run twice, the second time with a row frame with a bad crc
+// and a frame with a bad length between the rows. Both are dropped, so the
+// cartridge lines on PORTD and PORTB have to go through exactly the same
+// values in both runs; a dropped 8-bit row that moved the dither on changes
+// every row after it. The status has to count every row, the bad frames and
+// no receive buffer overruns.
+//
+// Every run prints the status and the sustained rows per second in simulated
+// time, from the first byte sent to the status, like tools/ps_send.py does
+// on a board. The row rate and the underruns are reported, not checked: the
+// line rate bounds them, not the firmware.
+//
+// Needs simavr and libelf installed; make install RELEASE=1 in simavr puts
+// them under /usr/local.
+//
+// Run with: pio run -e uno_stream && pio run -e stream_sim -t exec
+// Or .pio/build/stream_sim/program [FIRMWARE] [--rows N]
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "avr_ioport.h"
+#include "avr_uart.h"
+#include "printspider.h"
+#include "sim_avr.h"
+#include "sim_cycle_timers.h"
+#include "sim_elf.h"
+#include "sim_time.h"
+#include "stream.h"
+
+#define DEFAULT_FIRMWARE ".pio/build/uno_stream/firmware.elf"
+// Black cartridge, two nozzle rows of 8-bit pixels per row frame.
+#define ROW_CHANNELS 2
+#define MAX_ROWS 200
+#define ROW_PIXELS (ROW_CHANNELS * PRINTSPIDER_BLACK_NOZZLES_IN_ROW)
+// Row frames and the bad ones, with 5 bytes of framing each.
+#define MAX_TX ((MAX_ROWS + 2) * (ROW_PIXELS + 5) + 5)
+// A byte is 10 bits at STREAM_BAUD, sent a little slower than that.
+#define BYTE_US (10 * 1000000UL / STREAM_BAUD + 5)
+// Time the firmware gets to answer the end of the print.
+#define TIMEOUT_US 20000000UL
+
+// Fields of stream_status_t, in the order they are sent.
+enum {
+    STATUS_ROWS,
+    STATUS_UNDERRUNS,
+    STATUS_DEFERRED_ROWS,
+    STATUS_DEFERRED_NOZZLES,
+    STATUS_FRAMES,
+    STATUS_CRC_ERRORS,
+    STATUS_FRAME_ERRORS,
+    STATUS_OVERRUNS,
+    STATUS_DROPPED_NOZZLES,
+    STATUS_FIELDS
+};
+
+static const char *status_names[STATUS_FIELDS] = {
+    "rows",       "underruns",    "deferred_rows", "deferred_nozzles",
+    "frames",     "crc_errors",   "frame_errors",  "overruns",
+    "dropped_nozzles"};
+
+static avr_t *mcu;
+static avr_irq_t *uart_in;
+
+// Bytes to send and the credit granted by the printer.
+static uint8_t tx[MAX_TX];
+static int tx_len;
+static int tx_pos;
+static long credit;
+// Cycles of the first byte sent and of the status.
+static avr_cycle_count_t start_cycle;
+static avr_cycle_count_t status_cycle;
+
+// Frame being received from the printer.
+static uint8_t rx_frame[4 + 256 + 1];
+static int rx_len;
+static uint16_t status[STATUS_FIELDS];
+static int got_status;
+
+// Values of PORTD and PORTB, and an FNV-1a hash of every change of them.
+static uint8_t ports[2];
+static uint32_t port_hash;
+static long port_changes;
+
+static uint8_t crc8_update(uint8_t crc, uint8_t c) {
+    crc ^= c;
+    for (uint8_t i = 0; i < 8; i++) {
+        crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return crc;
+}
+
+// Queues a frame, with its crc off by `bad_crc`.
+static void add_frame(uint8_t type, const uint8_t *payload, uint16_t len,
+                      uint8_t bad_crc) {
+    uint8_t header[4] = {STREAM_SYNC, type, len & 0xff, len >> 8};
+    uint8_t crc = 0;
+    for (int i = 0; i < 4; i++) {
+        tx[tx_len++] = header[i];
+        if (i) crc = crc8_update(crc, header[i]);
+    }
+    for (int i = 0; i < len; i++) {
+        tx[tx_len++] = payload[i];
+        crc = crc8_update(crc, payload[i]);
+    }
+    tx[tx_len++] = crc ^ bad_crc;
+}
+
+static avr_cycle_count_t send_byte(avr_t *avr, avr_cycle_count_t when,
+                                   void *param) {
+    (void)param;
+    if (tx_pos < tx_len && credit > 0) {
+        if (!tx_pos) start_cycle = when;
+        avr_raise_irq(uart_in, tx[tx_pos++]);
+        credit--;
+    }
+    return when + avr_usec_to_cycles(avr, BYTE_US);
+}
+
+// Collects the frames of the printer: credit and the status.
+static void uart_output(struct avr_irq_t *irq, uint32_t value, void *param) {
+    (void)irq;
+    (void)param;
+    if (rx_len == 0 && value != STREAM_SYNC) return;
+    rx_frame[rx_len++] = value;
+    if (rx_len < 4) return;
+    int len = rx_frame[2] | rx_frame[3] << 8;
+    if (len > 256) {
+        rx_len = 0;
+        return;
+    }
+    if (rx_len < 4 + len + 1) return;
+    uint8_t crc = 0;
+    for (int i = 1; i < 4 + len; i++) crc = crc8_update(crc, rx_frame[i]);
+    const uint8_t *payload = &rx_frame[4];
+    if (crc != rx_frame[4 + len]) {
+        printf("bad crc from the printer\n");
+    } else if (rx_frame[1] == STREAM_CREDIT && len == 2) {
+        credit += payload[0] | payload[1] << 8;
+    } else if (rx_frame[1] == STREAM_STATUS &&
+               len == 2 * STATUS_FIELDS) {
+        for (int i = 0; i < STATUS_FIELDS; i++) {
+            status[i] = payload[2 * i] | payload[2 * i + 1] << 8;
+        }
+        status_cycle = mcu->cycle;
+        got_status = 1;
+    }
+    rx_len = 0;
+}
+
+static void port_changed(struct avr_irq_t *irq, uint32_t value, void *param) {
+    (void)irq;
+    int port = (int)(intptr_t)param;
+    if (ports[port] == value) return;
+    ports[port] = value;
+    for (int i = 0; i < 2; i++) {
+        port_hash ^= ports[i];
+        port_hash *= 16777619u;
+    }
+    port_changes++;
+}
+
+// Streams `rows` rows, with bad frames after the first one for `bad`. Returns
+// 0 when the status came back.
+static int run(const elf_firmware_t *f, int rows, int bad) {
+    static uint8_t pixels[ROW_PIXELS];
+    tx_len = tx_pos = 0;
+    credit = 0;
+    rx_len = 0;
+    got_status = 0;
+    memset(ports, 0, sizeof(ports));
+    port_hash = 2166136261u;
+    port_changes = 0;
+    for (int r = 0; r < rows; r++) {
+        // A grey ramp across the nozzles, moving with the row, so the dither
+        // carries state from one row to the next.
+        for (int i = 0; i < ROW_PIXELS; i++) {
+            pixels[i] = (i % PRINTSPIDER_BLACK_NOZZLES_IN_ROW) + 2 * r;
+        }
+        add_frame(STREAM_ROW_BYTES, pixels, ROW_PIXELS, 0);
+        if (bad && r == 0) {
+            memset(pixels, 0, ROW_PIXELS);
+            add_frame(STREAM_ROW_BYTES, pixels, ROW_PIXELS, 0x5a);
+            // The printer looks for the next sync byte after a bad length,
+            // there is none in this frame.
+            add_frame(STREAM_ROW_BYTES, pixels, ROW_PIXELS - 1, 0);
+        }
+    }
+    add_frame(STREAM_END, NULL, 0, 0);
+
+    mcu = avr_make_mcu_by_name("atmega328p");
+    if (!mcu) return 1;
+    avr_init(mcu);
+    mcu->frequency = 16000000;
+    avr_load_firmware(mcu, (elf_firmware_t *)f);
+
+    uint32_t flags = 0;
+    avr_ioctl(mcu, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+    flags &= ~AVR_UART_FLAG_STDIO;
+    avr_ioctl(mcu, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+    avr_irq_register_notify(
+        avr_io_getirq(mcu, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT),
+        uart_output, NULL);
+    uart_in = avr_io_getirq(mcu, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT);
+    avr_irq_register_notify(
+        avr_io_getirq(mcu, AVR_IOCTL_IOPORT_GETIRQ('D'), IOPORT_IRQ_PIN_ALL),
+        port_changed, (void *)0);
+    avr_irq_register_notify(
+        avr_io_getirq(mcu, AVR_IOCTL_IOPORT_GETIRQ('B'), IOPORT_IRQ_PIN_ALL),
+        port_changed, (void *)1);
+    avr_cycle_timer_register_usec(mcu, BYTE_US, send_byte, NULL);
+
+    avr_cycle_count_t end = avr_usec_to_cycles(mcu, TIMEOUT_US);
+    int cpu = cpu_Running;
+    while (cpu != cpu_Done && cpu != cpu_Crashed && !got_status &&
+           mcu->cycle < end) {
+        cpu = avr_run(mcu);
+    }
+    printf("%-8s sent %6d of %6d bytes, %8ld line changes, hash %08x\n",
+           bad ? "bad" : "clean", tx_pos, tx_len, port_changes, port_hash);
+    if (!got_status) {
+        printf("%-8s no status from the printer\n", bad ? "bad" : "clean");
+        return 1;
+    }
+    for (int i = 0; i < STATUS_FIELDS; i++) {
+        printf("%-8s %-16s %u\n", bad ? "bad" : "clean", status_names[i],
+               status[i]);
+    }
+    double seconds = (double)(status_cycle - start_cycle) / mcu->frequency;
+    printf("%-8s %-16s %.1f\n", bad ? "bad" : "clean", "rows_per_second",
+           seconds > 0 ? status[STATUS_ROWS] / seconds : 0.0);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *firmware = DEFAULT_FIRMWARE;
+    int rows = 40;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--rows") && i + 1 < argc) {
+            rows = atoi(argv[++i]);
+        } else if (argv[i][0] != '-') {
+            firmware = argv[i];
+        } else {
+            fprintf(stderr, "usage: %s [FIRMWARE] [--rows N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (rows < 2 || rows > MAX_ROWS) {
+        fprintf(stderr, "rows out of range, 2 to %d\n", MAX_ROWS);
+        return 2;
+    }
+
+    elf_firmware_t f;
+    memset(&f, 0, sizeof(f));
+    if (elf_read_firmware(firmware, &f)) {
+        fprintf(stderr, "can't read %s\n", firmware);
+        return 1;
+    }
+
+    int failures = 0;
+    if (run(&f, rows, 0)) return 1;
+    uint32_t clean_hash = port_hash;
+    uint16_t clean[STATUS_FIELDS];
+    memcpy(clean, status, sizeof(clean));
+    if (run(&f, rows, 1)) return 1;
+
+    if (clean[STATUS_FRAMES] != rows || clean[STATUS_CRC_ERRORS] ||
+        clean[STATUS_FRAME_ERRORS] || clean[STATUS_OVERRUNS]) {
+        printf("FAIL clean run: wrong receive counters\n");
+        failures++;
+    }
+    if (status[STATUS_FRAMES] != rows || status[STATUS_CRC_ERRORS] != 1 ||
+        status[STATUS_FRAME_ERRORS] != 1 || status[STATUS_OVERRUNS]) {
+        printf("FAIL bad frames: wrong receive counters\n");
+        failures++;
+    }
+    if (status[STATUS_ROWS] != clean[STATUS_ROWS]) {
+        printf("FAIL rows printed: %u and %u\n", clean[STATUS_ROWS],
+               status[STATUS_ROWS]);
+        failures++;
+    }
+    if (port_hash != clean_hash) {
+        printf("FAIL the dropped frames changed the rows printed after them\n");
+        failures++;
+    }
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,245 @@
+#!/usr/bin/env python3
+# Copyright 2021 Pavel Semenov
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Tests of tools/vcd_analyze.py on synthetic captures.
+
+The waveforms are generated from the templates in printspider.c the way
+printspider_generate_waveform does, checked against the golden hashes of
+tools/bench/bench.c, and written as VCD files like the capture target writes
+them, with the word times moved by random noise. The analyzer has to find the
+word rate, the jitter of the noise, every packet and row, and the nozzle data
+of every row, for all four templates.
+
+    python3 tools/test_vcd_analyze.py
+"""
+
+import os
+import random
+import re
+import sys
+import tempfile
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import vcd_analyze  # noqa: E402
+from gen_nozzle_maps import (BLACK_NOZZLES_IN_ROW, COLOR_NOZZLES_IN_ROW,  # noqa: E402
+                             COLOR_VERTICAL_OFFSET, black_nozzle, color_nozzle)
+from gen_waveform_steps import read_templates, steps  # noqa: E402
+
+ROOT = vcd_analyze.ROOT
+
+PACKETS = 14
+IDLE_WORDS = 8
+NOZDATA_SZ = 3 * PACKETS
+# EMIT_WORD_CYCLES at 16 MHz.
+WORD_NS = 1000.0
+# Longer than a row of 14 packets of 27 + 8 words.
+ROW_PERIOD_NS = 600000.0
+NOISE_NS = 20.0
+
+# Line of every bit of a waveform word, see OUT_* in printspider.c.
+LINES = ("D1", "D2", "D3", "CSYNC", "S2", "S4", "S1", "S5", "DCLK", "S3",
+         "F3", "F5")
+OUT_DATA = 0x0007
+OUT_F3 = 1 << 10
+OUT_F5 = 1 << 11
+
+
+def generate_waveform(template, nozdata):
+    """Words of a row, like printspider_generate_waveform."""
+    length = (PACKETS * (len(template) + IDLE_WORDS) + 1) & ~1
+    if not any(nozdata):
+        return [0] * length
+    words = []
+    table = steps(template)
+    for j in range(PACKETS):
+        power = nozdata[j] | nozdata[14 + j] | nozdata[28 + j]
+        mask = 0xffff
+        if not power & 0x0f:
+            mask &= ~OUT_F3
+        if not power & 0xf0:
+            mask &= ~OUT_F5
+        last = j == PACKETS - 1
+        for pair, bit in table:
+            v = pair[last] & mask
+            for line in range(3):
+                if bit and not nozdata[line * 14 + j] & bit:
+                    v |= 1 << line
+            words.append(v)
+        words += [0] * IDLE_WORDS
+    return words + [0] * (length - len(words))
+
+
+def fnv1a(words):
+    h = 2166136261
+    for w in words:
+        h = ((h ^ (w & 0xff)) * 16777619) & 0xffffffff
+        h = ((h ^ (w >> 8)) * 16777619) & 0xffffffff
+    return h
+
+
+def encode_rows(rows, color):
+    """Nozzle data of packed image rows, like the bulk setters."""
+    nozdata = [0] * NOZDATA_SZ
+    if color:
+        for c in range(3):
+            for y in range(COLOR_NOZZLES_IN_ROW):
+                if rows[c][y // 8] & (0x80 >> (y % 8)):
+                    byte, mask = color_nozzle(y + COLOR_VERTICAL_OFFSET, c)
+                    nozdata[byte] |= mask
+    else:
+        for r in range(2):
+            for y in range(BLACK_NOZZLES_IN_ROW):
+                if rows[r][y // 8] & (0x80 >> (y % 8)):
+                    byte, mask = black_nozzle(y, r)
+                    nozdata[byte] |= mask
+    return nozdata
+
+
+def bench_rows(pattern):
+    """Image rows of the bench patterns: 0 empty, 1 sparse, 2 full."""
+    x = 2463534242
+    rows = []
+    for _ in range(3):
+        row = []
+        for _ in range(21):
+            b = 0
+            if pattern == 2:
+                b = 0xff
+            elif pattern == 1:
+                for k in range(8):
+                    x ^= (x << 13) & 0xffffffff
+                    x ^= x >> 17
+                    x ^= (x << 5) & 0xffffffff
+                    if x & 15 == 0:
+                        b |= 0x80 >> k
+            row.append(b)
+        rows.append(row)
+    return rows
+
+
+def read_golden():
+    with open(os.path.join(ROOT, "tools", "bench", "bench.c")) as f:
+        text = f.read()
+    m = re.search(r"golden\[4\]\[PATTERN_COUNT\] = \{(.*?)\};", text, re.S)
+    values = [int(v, 16) for v in re.findall(r"0x[0-9a-f]+", m.group(1))]
+    return [values[i:i + 3] for i in range(0, len(values), 3)]
+
+
+def write_vcd(path, rows, template, rng, noise_ns):
+    """Writes the rows as a VCD with one trace per line, every word moved by
+    up to `noise_ns`. Returns the start time of every row in ns."""
+    ids = {name: chr(ord("a") + i) for i, name in enumerate(LINES)}
+    starts = []
+    t0 = 1000.0
+    prev = 0
+    with open(path, "w") as f:
+        f.write("$timescale 1ps $end\n$scope module logic $end\n")
+        for name in LINES:
+            f.write("$var wire 1 %s %s $end\n" % (ids[name], name))
+        f.write("$upscope $end\n$enddefinitions $end\n#0\n")
+        for name in LINES:
+            f.write("0%s\n" % ids[name])
+        for nozdata in rows:
+            starts.append(t0)
+            for i, w in enumerate(generate_waveform(template, nozdata)):
+                changed = w ^ prev
+                if changed:
+                    t = t0 + i * WORD_NS + rng.uniform(-noise_ns, noise_ns)
+                    f.write("#%d\n" % round(t * 1000))
+                    for b, name in enumerate(LINES):
+                        if changed & (1 << b):
+                            f.write("%d%s\n" % ((w >> b) & 1, ids[name]))
+                prev = w
+            t0 += ROW_PERIOD_NS
+    return starts
+
+
+def random_row(rng, density):
+    nozdata = [0] * NOZDATA_SZ
+    for i in range(NOZDATA_SZ):
+        for k in range(8):
+            if rng.random() < density:
+                nozdata[i] |= 1 << k
+    return nozdata
+
+
+class GeneratorTest(unittest.TestCase):
+    def test_golden_hashes(self):
+        golden = read_golden()
+        for t, (name, template) in enumerate(read_templates()):
+            color = "color" in name
+            for pattern in range(3):
+                nozdata = encode_rows(bench_rows(pattern), color)
+                self.assertEqual(fnv1a(generate_waveform(template, nozdata)),
+                                 golden[t][pattern], "%s/%d" % (name, pattern))
+
+
+class AnalyzeTest(unittest.TestCase):
+    def analyze(self, template, rows, noise_ns, seed=1):
+        rng = random.Random(seed)
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "output.vcd")
+            starts = write_vcd(path, rows, template, rng, noise_ns)
+            changes = vcd_analyze.read_vcd(path, list(LINES))
+        return vcd_analyze.analyze(changes, "black", True), starts
+
+    def rows(self, seed):
+        rng = random.Random(seed)
+        rows = [[0xff] * NOZDATA_SZ, [0x01] + [0] * (NOZDATA_SZ - 1)]
+        rows += [random_row(rng, d) for d in (0.05, 0.3, 0.5, 0.9)]
+        return rows
+
+    def check(self, template, noise_ns):
+        rows = self.rows(len(template))
+        report, starts = self.analyze(template, rows, noise_ns)
+        self.assertAlmostEqual(report["words_per_second"], 1e9 / WORD_NS,
+                               delta=0.002 * 1e9 / WORD_NS)
+        jitter = report["jitter_ns"]
+        # Every interval is off by the difference of two noise values.
+        self.assertLessEqual(jitter["peak_to_peak"], 4 * noise_ns + 1)
+        self.assertLessEqual(jitter["rms"], 2 * noise_ns / 3 ** 0.5 + 1)
+        if noise_ns:
+            self.assertGreater(jitter["rms"], noise_ns / 2)
+        self.assertEqual(report["packets"]["count"], PACKETS * len(rows))
+        self.assertEqual(report["rows"]["count"], len(rows))
+        self.assertAlmostEqual(report["rows"]["period_ns"]["mean"],
+                               ROW_PERIOD_NS, delta=2 * noise_ns + 1)
+        for row, nozdata, start in zip(report["rows"]["rows"], rows, starts):
+            self.assertTrue(row["complete"])
+            self.assertEqual(row["nozdata"],
+                             "".join("%02x" % b for b in nozdata))
+            self.assertAlmostEqual(row["start_ns"], start + WORD_NS,
+                                   delta=noise_ns + 1)
+
+    def test_templates(self):
+        for name, template in read_templates():
+            for noise_ns in (0.0, NOISE_NS):
+                with self.subTest(template=name, noise_ns=noise_ns):
+                    self.check(template, noise_ns)
+
+    def test_nozzles(self):
+        name, template = read_templates()[2]
+        nozdata = [0] * NOZDATA_SZ
+        for y, r in ((0, 0), (77, 0), (167, 1)):
+            byte, mask = black_nozzle(y, r)
+            nozdata[byte] |= mask
+        report, _ = self.analyze(template, [nozdata], NOISE_NS)
+        nozzles = report["rows"]["rows"][0]["nozzles"]
+        self.assertEqual(nozzles, {"row0": [0, 77], "row1": [167]})
+
+
+if __name__ == "__main__":
+    unittest.main()
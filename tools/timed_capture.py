@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+# Copyright 2021 Pavel Semenov
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Runs the capture target for a while and stops it.
+
+The firmware idles after printing, so simavr never ends by itself. This runs
+pio run -e ENV -t capture for the given time, then interrupts simavr, which
+closes output.vcd, and keeps the console output, profile reports included:
+
+    python3 tools/timed_capture.py uno_profile 60 --log run1.txt
+    python3 tools/timed_capture.py uno 60 --dir ../before
+"""
+
+import argparse
+import os
+import signal
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("env", help="platformio.ini environment")
+    parser.add_argument("seconds", type=float,
+                        help="time to let the simulation run")
+    parser.add_argument("--dir", default=ROOT, help="project to capture")
+    parser.add_argument("--log", help="file for the console output")
+    args = parser.parse_args()
+
+    vcd = os.path.join(args.dir, "output.vcd")
+    if os.path.exists(vcd):
+        os.remove(vcd)
+    # Built first, so the build doesn't take from the simulation time.
+    subprocess.check_call(["pio", "run", "-e", args.env], cwd=args.dir,
+                          stdout=subprocess.DEVNULL)
+    # Line buffered, so nothing simavr printed is lost when it is stopped;
+    # stdbuf is passed on to simavr through the environment.
+    cmd = ["stdbuf", "-oL", "pio", "run", "-e", args.env, "-t", "capture"]
+    log = open(args.log, "w") if args.log else None
+    # Its own process group, so the interrupt reaches simavr as well.
+    proc = subprocess.Popen(cmd, cwd=args.dir, stdout=log or sys.stdout,
+                            stderr=subprocess.STDOUT, start_new_session=True)
+    try:
+        proc.wait(args.seconds)
+    except subprocess.TimeoutExpired:
+        os.killpg(proc.pid, signal.SIGINT)
+        try:
+            proc.wait(30)
+        except subprocess.TimeoutExpired:
+            os.killpg(proc.pid, signal.SIGKILL)
+            proc.wait()
+    if log:
+        log.close()
+    if not os.path.exists(vcd):
+        sys.exit("no output.vcd in %s" % args.dir)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,338 @@
+#!/usr/bin/env python3
+# Copyright 2021 Pavel Semenov
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Timing analyzer for the VCD written by the capture target.
+
+Reads output.vcd (or the given file), using the trace names configured in
+custom_capture of platformio.ini, and prints a JSON report with:
+
+- the word period and word rate of the output stage, and its jitter,
+- DCLK rate, packet and row durations, idle gaps between packets,
+- F3/F5 pulse widths,
+- the nozzle data of every row and the nozzles it fires, decoded from the
+  D1-D3 lines sampled at every DCLK edge.
+
+Usage:
+    python3 tools/vcd_analyze.py [output.vcd] [--cart black|color]
+        [--env uno] [--rows]
+"""
+
+import argparse
+import configparser
+import json
+import math
+import os
+import re
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from gen_nozzle_maps import (BLACK_NOZZLES_IN_ROW, COLOR_NOZZLES_IN_ROW,  # noqa: E402
+                             COLOR_VERTICAL_OFFSET, black_nozzle, color_nozzle)
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+PACKETS_PER_ROW = 14
+# A packet ends when all lines stay low for this many word periods; the
+# generator puts 8 idle words after every packet and never more than a
+# couple of low words inside one.
+PACKET_GAP_WORDS = 4
+
+TIMESCALE_NS = {"s": 1e9, "ms": 1e6, "us": 1e3, "ns": 1.0, "ps": 1e-3,
+                "fs": 1e-6}
+
+
+def find_option(config, section, option):
+    """Returns the option of the section, or of the sections it extends like
+    PlatformIO does, or None."""
+    if config.has_option(section, option):
+        return config.get(section, option)
+    if config.has_option(section, "extends"):
+        for parent in config.get(section, "extends").split(","):
+            value = find_option(config, parent.strip(), option)
+            if value is not None:
+                return value
+    if section.startswith("env:") and config.has_option("env", option):
+        return config.get("env", option)
+    return None
+
+
+def read_trace_names(env):
+    config = configparser.ConfigParser()
+    config.read(os.path.join(ROOT, "platformio.ini"))
+    section = "env:" + env
+    capture = find_option(config, section, "custom_capture")
+    if capture is None:
+        sys.exit("no custom_capture for [%s] in platformio.ini" % section)
+    names = []
+    for arg in capture.split():
+        m = re.match(r"(\w+)=trace@", arg)
+        if m:
+            names.append(m.group(1))
+    return names
+
+
+def read_vcd(path, names):
+    """Returns {name: [(time_ns, value), ...]} for the traced signals."""
+    ids = {}
+    scale = 1.0
+    changes = {name: [] for name in names}
+    time = 0.0
+    with open(path) as f:
+        text = f.read()
+    m = re.search(r"\$timescale\s+(\d+)\s*(\w+)\s+\$end", text)
+    if m:
+        scale = int(m.group(1)) * TIMESCALE_NS[m.group(2)]
+    var = r"\$var\s+\w+\s+\d+\s+(\S+)\s+(\S+)(?:\s+\[[^\]]*\])?\s+\$end"
+    for m in re.finditer(var, text):
+        if m.group(2) in changes:
+            ids[m.group(1)] = m.group(2)
+    body = text[text.find("$enddefinitions"):]
+    body = body[body.find("$end") + 4:]
+    for token in body.split():
+        if token.startswith("#"):
+            time = int(token[1:]) * scale
+        elif token[0] in "01xzXZ" and token[1:] in ids:
+            changes[ids[token[1:]]].append((time, 1 if token[0] == "1" else 0))
+    return changes
+
+
+def stats(values):
+    if not values:
+        return None
+    mean = sum(values) / len(values)
+    var = sum((v - mean) ** 2 for v in values) / len(values)
+    return {"count": len(values), "min": min(values), "max": max(values),
+            "mean": mean, "stddev": math.sqrt(var)}
+
+
+def bus_states(changes):
+    """Merges the signal changes into a list of (time, {name: value})."""
+    events = sorted((t, name, v) for name, lst in changes.items()
+                    for t, v in lst)
+    state = {name: 0 for name in changes}
+    states = []
+    for t, name, v in events:
+        state[name] = v
+        if states and states[-1][0] == t:
+            states[-1] = (t, dict(state))
+        else:
+            states.append((t, dict(state)))
+    # Drop entries that don't change anything.
+    out = []
+    for t, s in states:
+        if not out or out[-1][1] != s:
+            out.append((t, s))
+    return out
+
+
+def word_period(states):
+    """Estimates the word period from the shortest intervals between bus
+    changes."""
+    deltas = sorted(b[0] - a[0] for a, b in zip(states, states[1:])
+                    if b[0] > a[0])
+    if not deltas:
+        return None
+    # The shortest interval is one word; average the cluster around it.
+    base = deltas[0]
+    cluster = [d for d in deltas if d < base * 1.5]
+    return sum(cluster) / len(cluster)
+
+
+def pulses(changes, name):
+    widths = []
+    rise = None
+    for t, v in changes.get(name, []):
+        if v and rise is None:
+            rise = t
+        elif not v and rise is not None:
+            widths.append(t - rise)
+            rise = None
+    return widths
+
+
+def split_packets(states, period):
+    """Returns a list of packets, each a list of (time, state) entries."""
+    packets = []
+    current = []
+    low_since = None
+    for t, s in states:
+        busy = any(s.values())
+        if busy:
+            if current and low_since is not None and \
+                    t - low_since >= PACKET_GAP_WORDS * period:
+                packets.append(current)
+                current = []
+            current.append((t, s))
+            low_since = None
+        elif current:
+            current.append((t, s))
+            if low_since is None:
+                low_since = t
+    if current:
+        packets.append(current)
+    return packets
+
+
+def decode_packet(packet):
+    """Returns ([d1, d2, d3], csync_pulses) of a packet. Data bit k is
+    sampled at the k-th DCLK edge; a low data line means the nozzle fires."""
+    data = [0, 0, 0]
+    k = 0
+    dclk = 0
+    csync = 0
+    csync_pulses = 0
+    for _, s in packet:
+        if s.get("CSYNC", 0) and not csync:
+            csync_pulses += 1
+        csync = s.get("CSYNC", 0)
+        if s.get("DCLK", 0) != dclk:
+            dclk = s.get("DCLK", 0)
+            if k < 8:
+                for i, line in enumerate(("D1", "D2", "D3")):
+                    if not s.get(line, 0):
+                        data[i] |= 1 << k
+            k += 1
+    return data, csync_pulses
+
+
+def packet_end(packet):
+    """Time the last line of the packet went low."""
+    for t, s in reversed(packet):
+        if any(s.values()):
+            continue
+        return t
+    return packet[-1][0]
+
+
+def nozzles_of(nozdata, cart):
+    def fires(byte_mask):
+        return nozdata[byte_mask[0]] & byte_mask[1]
+
+    fired = {}
+    if cart == "color":
+        for color, name in enumerate(("c", "m", "y")):
+            fired[name] = [
+                y for y in range(COLOR_NOZZLES_IN_ROW)
+                if fires(color_nozzle(y + COLOR_VERTICAL_OFFSET, color))]
+    else:
+        for row in range(2):
+            fired["row%d" % row] = [y for y in range(BLACK_NOZZLES_IN_ROW)
+                                    if fires(black_nozzle(y, row))]
+    return fired
+
+
+def analyze(changes, cart, with_rows):
+    states = bus_states(changes)
+    report = {"events": len(states)}
+    period = word_period(states)
+    if period is None:
+        report["error"] = "no activity on the bus"
+        return report
+    report["word_period_ns"] = period
+    report["words_per_second"] = 1e9 / period
+
+    # Deviation of every bus change from the word grid.
+    deviations = []
+    for a, b in zip(states, states[1:]):
+        d = b[0] - a[0]
+        words = round(d / period)
+        if 0 < words <= PACKET_GAP_WORDS:
+            deviations.append(d - words * period)
+    dev = stats(deviations)
+    report["jitter_ns"] = {
+        "rms": math.sqrt(sum(d * d for d in deviations) / len(deviations))
+        if deviations else 0.0,
+        "peak_to_peak": (dev["max"] - dev["min"]) if dev else 0.0,
+    }
+
+    dclk_rises = [t for t, v in changes.get("DCLK", []) if v]
+    packets = split_packets(states, period)
+    dclk_periods = []
+    for p in packets:
+        rises = [t for t in dclk_rises if p[0][0] <= t <= p[-1][0]]
+        dclk_periods += [b - a for a, b in zip(rises, rises[1:])]
+    dclk = stats(dclk_periods)
+    report["dclk"] = {"rising_edges": len(dclk_rises), "period_ns": dclk,
+                      "frequency_hz": 1e9 / dclk["mean"] if dclk else None}
+
+    report["packets"] = {
+        "count": len(packets),
+        "duration_ns": stats([packet_end(p) - p[0][0] for p in packets]),
+        "idle_gap_ns": stats([b[0][0] - packet_end(a)
+                              for a, b in zip(packets, packets[1:])]),
+    }
+    report["f3_pulse_ns"] = stats(pulses(changes, "F3"))
+    report["f5_pulse_ns"] = stats(pulses(changes, "F5"))
+
+    # Group packets into rows; the last packet of a row uses a different
+    # csync selection, so it pulses csync a different number of times than
+    # the others.
+    decoded = [decode_packet(p) for p in packets]
+    counts = [c for _, c in decoded]
+    normal = max(set(counts), key=counts.count) if counts else 0
+    rows = []
+    current = []
+    for p, (data, csync_pulses) in zip(packets, decoded):
+        current.append((p, data))
+        if csync_pulses != normal or len(current) == PACKETS_PER_ROW:
+            rows.append(current)
+            current = []
+    if current:
+        rows.append(current)
+    row_reports = []
+    for r in rows:
+        nozdata = [0] * (3 * PACKETS_PER_ROW)
+        for j, (_, data) in enumerate(r[:PACKETS_PER_ROW]):
+            for line in range(3):
+                nozdata[line * PACKETS_PER_ROW + j] = data[line]
+        row_reports.append({
+            "start_ns": r[0][0][0][0],
+            "duration_ns": packet_end(r[-1][0]) - r[0][0][0][0],
+            "packets": len(r),
+            "complete": len(r) == PACKETS_PER_ROW,
+            "nozdata": "".join("%02x" % b for b in nozdata),
+            "nozzles": nozzles_of(nozdata, cart),
+        })
+    report["rows"] = {
+        "count": len(rows),
+        "duration_ns": stats([r["duration_ns"] for r in row_reports]),
+        "period_ns": stats([b["start_ns"] - a["start_ns"]
+                            for a, b in zip(row_reports, row_reports[1:])]),
+    }
+    if report["rows"]["period_ns"]:
+        report["rows"]["rows_per_second"] = \
+            1e9 / report["rows"]["period_ns"]["mean"]
+    if with_rows:
+        report["rows"]["rows"] = row_reports
+    return report
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("vcd", nargs="?", default="output.vcd")
+    parser.add_argument("--cart", choices=("black", "color"), default="black",
+                        help="cartridge type for decoding nozzles")
+    parser.add_argument("--env", default="uno",
+                        help="platformio.ini environment with custom_capture")
+    parser.add_argument("--rows", action="store_true",
+                        help="include decoded nozzle data of every row")
+    args = parser.parse_args()
+    changes = read_vcd(args.vcd, read_trace_names(args.env))
+    json.dump(analyze(changes, args.cart, args.rows), sys.stdout, indent=2)
+    sys.stdout.write("\n")
+
+
+if __name__ == "__main__":
+    main()